@@ -0,0 +1,140 @@
+/**
+ * @file amostragem_adaptativa.hpp
+ * @brief Taxa de amostragem adaptativa do cliente: ociosa com o sinal parado, rajada com atividade.
+ *
+ * @details Com o invólucro fechado e escuro, amostrar a taxa fixa gasta CPU e banda à toa; na
+ * abertura, ao contrário, é preciso amostrar depressa. O AgendadorAmostragem filtra o sinal do
+ * LDR com uma média móvel exponencial (constante de tempo fixa, independente da taxa) e estima
+ * a derivada do sinal filtrado e a variância da leitura em torno dele. Se a derivada ou a
+ * variância passa do seu limiar, a taxa sobe para a de rajada; ela volta à ociosa quando nenhum
+ * dos dois passa do limiar durante o tempo de manutenção.
+ *
+ * A taxa ativa vai no cabeçalho de cada datagrama (CabecalhoLDR::taxa_dhz), e cada amostra leva
+ * o seu próprio instante, de modo que o receptor reconstrói a linha do tempo nas duas taxas.
+ */
+
+#ifndef AMOSTRAGEM_ADAPTATIVA_HPP
+#define AMOSTRAGEM_ADAPTATIVA_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Parâmetros da amostragem adaptativa.
+ */
+struct ConfiguracaoAmostragem {
+    double taxaOciosaHz = 1.0;        /**< Taxa com o sinal parado. */
+    double taxaRajadaHz = 20.0;       /**< Taxa durante a atividade (igual à ociosa: taxa fixa). */
+    double limiarDerivada = 10.0;     /**< |d/dt| do sinal filtrado que inicia a rajada (%/s). */
+    double limiarVariancia = 4.0;     /**< Variância da leitura em torno do filtro que inicia a rajada (%²). */
+    uint32_t manutencaoMs = 5000;     /**< Tempo sem atividade até voltar à taxa ociosa. */
+    uint32_t constanteTempoMs = 500;  /**< Constante de tempo do filtro e da variância. */
+};
+
+/**
+ * @class AgendadorAmostragem
+ * @brief Decide, a cada leitura, o intervalo até a próxima.
+ */
+class AgendadorAmostragem {
+private:
+    /**< Parâmetros. */
+    ConfiguracaoAmostragem config;
+
+    /**< Estado do filtro. */
+    bool iniciado = false;
+    double filtrado = 0.0;
+    double variancia = 0.0;
+    double derivada = 0.0;
+    uint64_t ultimaNs = 0;
+
+    /**< Modo atual e instante da última atividade (CLOCK_MONOTONIC). */
+    bool rajada = false;
+    uint64_t ultimaAtividadeNs = 0;
+
+    /**< Trocas de taxa desde o início. */
+    uint64_t trocas = 0;
+
+public:
+    explicit AgendadorAmostragem(const ConfiguracaoAmostragem& configuracao) : config(configuracao) {
+        config.taxaOciosaHz = std::max(config.taxaOciosaHz, 0.1);
+        config.taxaRajadaHz = std::max(config.taxaRajadaHz, config.taxaOciosaHz);
+    }
+
+    /**
+     * @brief Registra uma leitura e atualiza o modo.
+     * @param valor Leitura (luminosidade percentual).
+     * @param agoraNs Instante da leitura (CLOCK_MONOTONIC).
+     * @return true se a taxa mudou com esta leitura.
+     */
+    bool registrar(double valor, uint64_t agoraNs) {
+        if (!iniciado) {
+            iniciado = true;
+            filtrado = valor;
+            ultimaNs = agoraNs;
+            return false;
+        }
+        double dt = static_cast<double>(agoraNs - ultimaNs) / 1e9;
+        ultimaNs = agoraNs;
+        if (dt <= 0.0) {
+            return false;
+        }
+        // Coeficiente pela constante de tempo: o filtro responde igual nas duas taxas.
+        double alfa = 1.0 - std::exp(-dt * 1000.0 / std::max<uint32_t>(config.constanteTempoMs, 1));
+        double anterior = filtrado;
+        double desvio = valor - filtrado;
+        filtrado += alfa * desvio;
+        variancia = (1.0 - alfa) * (variancia + alfa * desvio * desvio);
+        derivada = (filtrado - anterior) / dt;
+
+        bool ativo = std::fabs(derivada) > config.limiarDerivada || variancia > config.limiarVariancia;
+        if (ativo) {
+            ultimaAtividadeNs = agoraNs;
+        }
+        bool novaRajada = ativo || (rajada && agoraNs - ultimaAtividadeNs < config.manutencaoMs * 1000000ull);
+        if (novaRajada == rajada || config.taxaRajadaHz == config.taxaOciosaHz) {
+            return false;
+        }
+        rajada = novaRajada;
+        trocas++;
+        return true;
+    }
+
+    /**
+     * @brief Entra na rajada por um sinal externo (ex.: evento de limiar do ADC).
+     * @details Conta como atividade: a rajada dura ao menos o tempo de manutenção.
+     * @return true se a taxa mudou.
+     */
+    bool forcarRajada(uint64_t agoraNs) {
+        ultimaAtividadeNs = agoraNs;
+        if (rajada || config.taxaRajadaHz == config.taxaOciosaHz) {
+            return false;
+        }
+        rajada = true;
+        trocas++;
+        return true;
+    }
+
+    /** @brief Taxa ativa (Hz). */
+    double taxaHz() const { return rajada ? config.taxaRajadaHz : config.taxaOciosaHz; }
+
+    /** @brief Taxa ativa em décimos de Hz, como no cabeçalho do datagrama. */
+    uint16_t taxaDhz() const { return static_cast<uint16_t>(std::min(std::lround(taxaHz() * 10.0), 65535L)); }
+
+    /** @brief Intervalo até a próxima leitura (ns). */
+    uint64_t periodoNs() const { return static_cast<uint64_t>(1e9 / taxaHz()); }
+
+    /** @brief true durante a rajada. */
+    bool emRajada() const { return rajada; }
+
+    /** @brief Derivada do sinal filtrado (%/s). */
+    double derivadaAtual() const { return derivada; }
+
+    /** @brief Variância da leitura em torno do filtro (%²). */
+    double varianciaAtual() const { return variancia; }
+
+    /** @brief Trocas de taxa desde o início. */
+    uint64_t trocasDeTaxa() const { return trocas; }
+};
+
+#endif // AMOSTRAGEM_ADAPTATIVA_HPP
@@ -0,0 +1,268 @@
+/**
+ * @file anel_compartilhado.hpp
+ * @brief Anel de amostras em memória compartilhada para consumidores no mesmo host.
+ *
+ * @details O coletor publica cada amostra decodificada como um registro de tamanho fixo em um
+ * anel criado com shm_open() (visível em `/dev/shm/<nome>`). Os consumidores locais (interface,
+ * ferramentas de análise) mapeiam o anel somente para leitura e descobrem amostras novas lendo
+ * a memória, sem socket nem chamada de sistema no caminho de leitura.
+ *
+ * A publicação segue o padrão seqlock: cada registro tem um número de sequência que vale
+ * 2 * posição + 1 durante a escrita e 2 * posição + 2 depois dela. O leitor lê a sequência,
+ * copia o registro e relê a sequência: se ela mudou, ou se já pertence a uma volta posterior do
+ * anel, o leitor foi ultrapassado pelo escritor e conta as amostras perdidas em vez de usar
+ * dados misturados.
+ *
+ * Layout (ordem de bytes do host): CabecalhoAnelCompartilhado (64 bytes) seguido de
+ * `capacidade` registros RegistroCompartilhado (32 bytes cada).
+ */
+
+#ifndef ANEL_COMPARTILHADO_HPP
+#define ANEL_COMPARTILHADO_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "protocolo_ldr.hpp"
+
+/** @def ANEL_COMPARTILHADO_MAGIA
+ * @brief Identificação do anel ("LDRA").
+ */
+#define ANEL_COMPARTILHADO_MAGIA 0x4152444Cu
+
+/** @def ANEL_COMPARTILHADO_VERSAO
+ * @brief Versão do layout.
+ */
+#define ANEL_COMPARTILHADO_VERSAO 1
+
+/** @def ANEL_COMPARTILHADO_REGISTROS
+ * @brief Número padrão de registros (potência de 2).
+ */
+#define ANEL_COMPARTILHADO_REGISTROS 65536
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "o anel compartilhado requer atomicos de 64 bits sem trava");
+
+/**
+ * @brief Cabeçalho do anel compartilhado.
+ */
+struct alignas(64) CabecalhoAnelCompartilhado {
+    uint32_t magia;                   /**< ANEL_COMPARTILHADO_MAGIA. */
+    uint32_t versao;                  /**< ANEL_COMPARTILHADO_VERSAO. */
+    uint32_t capacidade;              /**< Número de registros (potência de 2). */
+    uint32_t tamanhoRegistro;         /**< sizeof(RegistroCompartilhado). */
+    std::atomic<uint64_t> cabeca;     /**< Próxima posição de escrita (offset 16). */
+};
+
+/**
+ * @brief Uma amostra no anel compartilhado.
+ */
+struct alignas(32) RegistroCompartilhado {
+    std::atomic<uint64_t> seq; /**< 2 * posição + 1 em escrita, 2 * posição + 2 publicado. */
+    uint64_t t_ns;             /**< Instante da amostra. */
+    uint32_t id_sensor;        /**< Sensor. */
+    uint32_t seq_amostra;      /**< Sequência da amostra no sensor. */
+    int32_t valor;             /**< Valor. */
+    uint32_t reservado;        /**< Reservado (0). */
+};
+static_assert(sizeof(CabecalhoAnelCompartilhado) == 64, "cabecalho do anel deve ter 64 bytes");
+static_assert(sizeof(RegistroCompartilhado) == 32, "registro do anel deve ter 32 bytes");
+
+/**
+ * @brief Tamanho total do mapeamento de um anel com @p capacidade registros.
+ */
+inline size_t tamanhoAnelCompartilhado(uint32_t capacidade) {
+    return sizeof(CabecalhoAnelCompartilhado) + static_cast<size_t>(capacidade) * sizeof(RegistroCompartilhado);
+}
+
+/**
+ * @class AnelCompartilhado
+ * @brief Lado do escritor: cria o anel e publica as amostras (vários threads podem publicar).
+ */
+class AnelCompartilhado {
+private:
+    /**< Nome do objeto de memória compartilhada. */
+    std::string nome;
+
+    /**< Mapeamento. */
+    CabecalhoAnelCompartilhado* cabecalho = nullptr;
+    RegistroCompartilhado* registros = nullptr;
+    size_t tamanho = 0;
+    uint64_t mascara = 0;
+
+public:
+    AnelCompartilhado() = default;
+    AnelCompartilhado(const AnelCompartilhado&) = delete;
+    AnelCompartilhado& operator=(const AnelCompartilhado&) = delete;
+
+    ~AnelCompartilhado() {
+        if (cabecalho != nullptr) {
+            munmap(cabecalho, tamanho);
+            shm_unlink(nome.c_str());
+        }
+    }
+
+    /**
+     * @brief Cria (ou recria) o anel `/dev/shm/<nomeAnel>`.
+     * @param nomeAnel Nome do objeto, iniciado por '/' (ex.: "/coletor_ldr").
+     * @param capacidade Número de registros (potência de 2).
+     * @return 0 ou -errno.
+     */
+    int criar(const std::string& nomeAnel, uint32_t capacidade = ANEL_COMPARTILHADO_REGISTROS) {
+        if (capacidade == 0 || (capacidade & (capacidade - 1)) != 0) {
+            return -EINVAL;
+        }
+        // Um anel antigo pode estar mapeado por leitores: recriar evita misturar as posições.
+        shm_unlink(nomeAnel.c_str());
+        int fd = shm_open(nomeAnel.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return -errno;
+        }
+        size_t bytes = tamanhoAnelCompartilhado(capacidade);
+        void* p = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+            p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int erro = errno;
+        close(fd);
+        if (p == MAP_FAILED) {
+            shm_unlink(nomeAnel.c_str());
+            return -erro;
+        }
+        nome = nomeAnel;
+        tamanho = bytes;
+        mascara = capacidade - 1;
+        cabecalho = static_cast<CabecalhoAnelCompartilhado*>(p);
+        registros = reinterpret_cast<RegistroCompartilhado*>(cabecalho + 1);
+        // A memória vem zerada do ftruncate(); a magia é escrita por último, quando o anel está pronto.
+        cabecalho->versao = ANEL_COMPARTILHADO_VERSAO;
+        cabecalho->capacidade = capacidade;
+        cabecalho->tamanhoRegistro = sizeof(RegistroCompartilhado);
+        __atomic_store_n(&cabecalho->magia, ANEL_COMPARTILHADO_MAGIA, __ATOMIC_RELEASE);
+        return 0;
+    }
+
+    /** @brief Publica @p n amostras em posições consecutivas. */
+    void publicar(const AmostraLDR* amostras, size_t n) {
+        uint64_t pos = cabecalho->cabeca.fetch_add(n, std::memory_order_relaxed);
+        for (size_t i = 0; i < n; i++, pos++) {
+            RegistroCompartilhado& r = registros[pos & mascara];
+            r.seq.store(2 * pos + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            r.t_ns = amostras[i].t_ns;
+            r.id_sensor = amostras[i].id_sensor;
+            r.seq_amostra = amostras[i].seq;
+            r.valor = amostras[i].valor;
+            r.seq.store(2 * pos + 2, std::memory_order_release);
+        }
+    }
+
+    /** @brief Amostras publicadas desde a criação. */
+    uint64_t publicadas() const { return cabecalho->cabeca.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @class LeitorAnelCompartilhado
+ * @brief Lado do leitor: mapeia o anel somente para leitura e consome as amostras por polling.
+ */
+class LeitorAnelCompartilhado {
+private:
+    const CabecalhoAnelCompartilhado* cabecalho = nullptr;
+    const RegistroCompartilhado* registros = nullptr;
+    size_t tamanho = 0;
+    uint64_t capacidade = 0;
+
+    /**< Próxima posição a ler e amostras perdidas por ultrapassagem. */
+    uint64_t proximo = 0;
+    uint64_t perdidas = 0;
+
+public:
+    LeitorAnelCompartilhado() = default;
+    LeitorAnelCompartilhado(const LeitorAnelCompartilhado&) = delete;
+    LeitorAnelCompartilhado& operator=(const LeitorAnelCompartilhado&) = delete;
+
+    ~LeitorAnelCompartilhado() {
+        if (cabecalho != nullptr) {
+            munmap(const_cast<CabecalhoAnelCompartilhado*>(cabecalho), tamanho);
+        }
+    }
+
+    /**
+     * @brief Abre o anel e posiciona o leitor na próxima amostra a ser publicada.
+     * @return 0 ou -errno (-EPROTO se o anel não estiver pronto ou tiver outro layout).
+     */
+    int abrir(const std::string& nomeAnel) {
+        int fd = shm_open(nomeAnel.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0) {
+            return -errno;
+        }
+        struct stat st;
+        void* p = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(CabecalhoAnelCompartilhado)) {
+            p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        int erro = errno;
+        close(fd);
+        if (p == MAP_FAILED) {
+            return -(erro != 0 ? erro : EPROTO);
+        }
+        tamanho = static_cast<size_t>(st.st_size);
+        cabecalho = static_cast<const CabecalhoAnelCompartilhado*>(p);
+        if (__atomic_load_n(&cabecalho->magia, __ATOMIC_ACQUIRE) != ANEL_COMPARTILHADO_MAGIA ||
+            cabecalho->versao != ANEL_COMPARTILHADO_VERSAO ||
+            cabecalho->tamanhoRegistro != sizeof(RegistroCompartilhado) ||
+            tamanhoAnelCompartilhado(cabecalho->capacidade) > tamanho) {
+            munmap(p, tamanho);
+            cabecalho = nullptr;
+            return -EPROTO;
+        }
+        capacidade = cabecalho->capacidade;
+        registros = reinterpret_cast<const RegistroCompartilhado*>(cabecalho + 1);
+        proximo = cabecalho->cabeca.load(std::memory_order_acquire);
+        return 0;
+    }
+
+    /**
+     * @brief Lê a próxima amostra, se houver.
+     * @return true se @p saida recebeu uma amostra nova.
+     */
+    bool ler(AmostraLDR& saida) {
+        while (true) {
+            const RegistroCompartilhado& r = registros[proximo & (capacidade - 1)];
+            uint64_t seq = r.seq.load(std::memory_order_acquire);
+            if (seq < 2 * proximo + 2) {
+                return false;
+            }
+            if (seq == 2 * proximo + 2) {
+                saida.t_ns = r.t_ns;
+                saida.id_sensor = r.id_sensor;
+                saida.seq = r.seq_amostra;
+                saida.valor = r.valor;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (r.seq.load(std::memory_order_relaxed) == seq) {
+                    proximo++;
+                    return true;
+                }
+            }
+            // Ultrapassado pelo escritor: salta para a amostra mais antiga ainda no anel.
+            uint64_t cabeca = cabecalho->cabeca.load(std::memory_order_acquire);
+            uint64_t antiga = cabeca > capacidade ? cabeca - capacidade + 1 : 0;
+            if (antiga <= proximo) {
+                antiga = proximo + 1;
+            }
+            perdidas += antiga - proximo;
+            proximo = antiga;
+        }
+    }
+
+    /** @brief Amostras sobrescritas antes de serem lidas. */
+    uint64_t amostrasPerdidas() const { return perdidas; }
+};
+
+#endif // ANEL_COMPARTILHADO_HPP
@@ -0,0 +1,210 @@
+/**
+ * @file anel_io_uring.hpp
+ * @brief Interface mínima para o io_uring do Linux, usando diretamente as chamadas de sistema.
+ *
+ * @details Encapsula a criação do anel (filas de submissão e de conclusão mapeadas em memória),
+ * o registro de descritores fixos e de anéis de buffers fornecidos (provided buffer rings),
+ * e o ciclo de submissão/espera. Não depende da liburing, que não está disponível na
+ * toolchain da placa; apenas do cabeçalho `linux/io_uring.h` do kernel.
+ */
+
+#ifndef ANEL_IO_URING_HPP
+#define ANEL_IO_URING_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @class AnelIoUring
+ * @brief Um anel io_uring (uma instância por thread/núcleo).
+ */
+class AnelIoUring {
+private:
+    /**< Descritor do anel. */
+    int fd = -1;
+
+    /**< Parâmetros devolvidos pelo kernel em io_uring_setup. */
+    io_uring_params params{};
+
+    /**< Regiões mapeadas (filas SQ e CQ compartilham a mesma região com IORING_FEAT_SINGLE_MMAP). */
+    void* regiaoSq = MAP_FAILED;
+    void* regiaoCq = MAP_FAILED;
+    size_t tamanhoSq = 0;
+    size_t tamanhoCq = 0;
+
+    /**< Vetor de SQEs. */
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t tamanhoSqes = 0;
+
+    /**< Ponteiros para os campos da fila de submissão. */
+    unsigned* sqCabeca = nullptr;
+    unsigned* sqCauda = nullptr;
+    unsigned* sqMascara = nullptr;
+    unsigned* sqVetor = nullptr;
+
+    /**< Ponteiros para os campos da fila de conclusão. */
+    unsigned* cqCabeca = nullptr;
+    unsigned* cqCauda = nullptr;
+    unsigned* cqMascara = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    /**< SQEs preenchidas e ainda não entregues ao kernel. */
+    unsigned pendentes = 0;
+
+    static int sysSetup(unsigned entradas, io_uring_params* p) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entradas, p));
+    }
+
+    static int sysEnter(int fd, unsigned submeter, unsigned minimo, unsigned flags) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, submeter, minimo, flags, nullptr, 0));
+    }
+
+    // Os índices das filas são compartilhados com o kernel: leituras com acquire, escritas com release.
+    static unsigned lerAdquirindo(const unsigned* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+    static void escreverLiberando(unsigned* p, unsigned v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+public:
+    AnelIoUring() = default;
+    AnelIoUring(const AnelIoUring&) = delete;
+    AnelIoUring& operator=(const AnelIoUring&) = delete;
+
+    ~AnelIoUring() {
+        if (sqes != MAP_FAILED) munmap(sqes, tamanhoSqes);
+        if (regiaoCq != MAP_FAILED && regiaoCq != regiaoSq) munmap(regiaoCq, tamanhoCq);
+        if (regiaoSq != MAP_FAILED) munmap(regiaoSq, tamanhoSq);
+        if (fd >= 0) close(fd);
+    }
+
+    /**
+     * @brief Cria o anel.
+     * @param entradas Número de SQEs (potência de 2).
+     * @return 0 em caso de sucesso ou -errno.
+     */
+    int iniciar(unsigned entradas) {
+        // Um único thread submete: o kernel pode evitar travas e adiar o trabalho de conclusão
+        // para o momento em que o thread entra no kernel. Kernels antigos recusam as flags.
+        params = io_uring_params{};
+        params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+        fd = sysSetup(entradas, &params);
+        if (fd < 0 && errno == EINVAL) {
+            params = io_uring_params{};
+            fd = sysSetup(entradas, &params);
+        }
+        if (fd < 0) {
+            return -errno;
+        }
+
+        tamanhoSq = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        tamanhoCq = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool mapaUnico = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (mapaUnico && tamanhoCq > tamanhoSq) {
+            tamanhoSq = tamanhoCq;
+        }
+        regiaoSq = mmap(nullptr, tamanhoSq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (regiaoSq == MAP_FAILED) {
+            return -errno;
+        }
+        regiaoCq = mapaUnico ? regiaoSq
+            : mmap(nullptr, tamanhoCq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (regiaoCq == MAP_FAILED) {
+            return -errno;
+        }
+        tamanhoSqes = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, tamanhoSqes, PROT_READ | PROT_WRITE,
+                                               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return -errno;
+        }
+
+        char* sq = static_cast<char*>(regiaoSq);
+        sqCabeca = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqCauda = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMascara = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqVetor = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(regiaoCq);
+        cqCabeca = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqCauda = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMascara = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return 0;
+    }
+
+    /** @brief Descritor do anel. */
+    int descritor() const { return fd; }
+
+    /**
+     * @brief Registra uma tabela de descritores fixos (acessados por índice com IOSQE_FIXED_FILE).
+     * @return 0 ou -errno.
+     */
+    int registrarArquivos(const int* fds, unsigned n) {
+        int r = static_cast<int>(syscall(__NR_io_uring_register, fd, IORING_REGISTER_FILES, fds, n));
+        return r < 0 ? -errno : 0;
+    }
+
+    /**
+     * @brief Registra um anel de buffers fornecidos para o grupo @p grupo.
+     * @param anel Memória do anel (alinhada à página, @p entradas × sizeof(io_uring_buf)).
+     * @return 0 ou -errno.
+     */
+    int registrarAnelBuffers(io_uring_buf_ring* anel, unsigned entradas, uint16_t grupo) {
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(anel);
+        reg.ring_entries = entradas;
+        reg.bgid = grupo;
+        int r = static_cast<int>(syscall(__NR_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &reg, 1));
+        return r < 0 ? -errno : 0;
+    }
+
+    /**
+     * @brief Obtém uma SQE livre, já zerada.
+     * @return Ponteiro para a SQE, ou nullptr se a fila de submissão estiver cheia.
+     */
+    io_uring_sqe* obterSqe() {
+        unsigned cabeca = lerAdquirindo(sqCabeca);
+        unsigned cauda = *sqCauda + pendentes;
+        if (cauda - cabeca >= params.sq_entries) {
+            return nullptr;
+        }
+        unsigned indice = cauda & *sqMascara;
+        sqVetor[indice] = indice;
+        pendentes++;
+        io_uring_sqe* sqe = &sqes[indice];
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    /**
+     * @brief Publica as SQEs pendentes e espera por pelo menos @p minimo conclusões.
+     * @return Número de SQEs consumidas pelo kernel ou -errno.
+     */
+    int submeterEEsperar(unsigned minimo) {
+        unsigned submeter = pendentes;
+        escreverLiberando(sqCauda, *sqCauda + pendentes);
+        pendentes = 0;
+        int r = sysEnter(fd, submeter, minimo, minimo > 0 ? IORING_ENTER_GETEVENTS : 0);
+        return r < 0 ? -errno : r;
+    }
+
+    /**
+     * @brief Percorre as conclusões disponíveis, chamando @p tratar para cada CQE.
+     * @return Número de CQEs consumidas.
+     */
+    template <typename Funcao>
+    unsigned consumirConclusoes(Funcao&& tratar) {
+        unsigned cabeca = *cqCabeca;
+        unsigned cauda = lerAdquirindo(cqCauda);
+        unsigned n = 0;
+        for (; cabeca != cauda; cabeca++, n++) {
+            tratar(cqes[cabeca & *cqMascara]);
+        }
+        escreverLiberando(cqCabeca, cabeca);
+        return n;
+    }
+};
+
+#endif // ANEL_IO_URING_HPP
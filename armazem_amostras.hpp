@@ -0,0 +1,151 @@
+/**
+ * @file armazem_amostras.hpp
+ * @brief Armazenamento das amostras recebidas em um arquivo CSV, apenas por anexação.
+ *
+ * @details As amostras são formatadas em um de dois buffers. Quando o buffer ativo enche (ou no
+ * temporizador do laço de eventos), ele é entregue para escrita e o outro passa a receber as
+ * amostras, de modo que a escrita em disco pode estar em andamento (ex.: via io_uring) sem
+ * bloquear a recepção.
+ */
+
+#ifndef ARMAZEM_AMOSTRAS_HPP
+#define ARMAZEM_AMOSTRAS_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+#include "log_assincrono.hpp"
+#include "protocolo_ldr.hpp"
+
+/** @def ARMAZEM_TAMANHO_BUFFER
+ * @brief Tamanho de cada um dos dois buffers de escrita.
+ */
+#define ARMAZEM_TAMANHO_BUFFER 65536
+
+/**
+ * @class ArmazemAmostras
+ * @brief Arquivo de amostras `t_ns,id_sensor,valor` com buffer duplo.
+ */
+class ArmazemAmostras {
+private:
+    /**< Descritor do arquivo (aberto com O_APPEND). */
+    int fd = -1;
+
+    /**< Os dois buffers de escrita. */
+    char buffers[2][ARMAZEM_TAMANHO_BUFFER];
+
+    /**< Bytes ocupados em cada buffer. */
+    size_t ocupado[2] = {0, 0};
+
+    /**< Índice do buffer que recebe novas amostras. */
+    int ativo = 0;
+
+    /**< Indica que o outro buffer foi entregue para escrita e ainda não foi liberado. */
+    bool emEscrita = false;
+
+    /**< Amostras descartadas porque os dois buffers estavam ocupados (lido por outros threads). */
+    std::atomic<uint64_t> descartadas{0};
+
+public:
+    /**
+     * @brief Abre (ou cria) o arquivo de amostras.
+     * @param caminho Caminho do arquivo.
+     * @return true em caso de sucesso.
+     */
+    bool abrir(const std::string& caminho) {
+        fd = open(caminho.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        return fd >= 0;
+    }
+
+    ~ArmazemAmostras() {
+        if (fd >= 0) {
+            descarregar();
+            close(fd);
+        }
+    }
+
+    /** @brief Descritor do arquivo (para registro como arquivo fixo no io_uring). */
+    int descritor() const { return fd; }
+
+    /** @brief Número de amostras descartadas por falta de espaço nos buffers. */
+    uint64_t amostrasDescartadas() const { return descartadas.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Anexa uma amostra ao buffer ativo.
+     *
+     * @details Se o buffer ativo já estava cheio, a amostra é descartada e contada.
+     *
+     * @return false se o buffer ativo está cheio (o chamador deve entregá-lo para escrita).
+     */
+    bool anexar(const AmostraLDR& a) {
+        size_t& n = ocupado[ativo];
+        if (ARMAZEM_TAMANHO_BUFFER - n < 48) {
+            // Só o thread do laço escreve: dispensa o incremento atômico.
+            descartadas.store(descartadas.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        int escrito = snprintf(buffers[ativo] + n, ARMAZEM_TAMANHO_BUFFER - n, "%llu,%u,%d\n",
+                               static_cast<unsigned long long>(a.t_ns), a.id_sensor, a.valor);
+        n += static_cast<size_t>(escrito);
+        return ARMAZEM_TAMANHO_BUFFER - n >= 48;
+    }
+
+    /**
+     * @brief Entrega o buffer ativo para escrita e passa a usar o outro.
+     *
+     * @param dados Recebe o início dos dados a escrever.
+     * @param tamanho Recebe o número de bytes.
+     * @return false se não há dados ou se a escrita anterior ainda não foi liberada.
+     */
+    bool trocar(const char*& dados, size_t& tamanho) {
+        if (emEscrita || ocupado[ativo] == 0) {
+            return false;
+        }
+        dados = buffers[ativo];
+        tamanho = ocupado[ativo];
+        ativo ^= 1;
+        emEscrita = true;
+        return true;
+    }
+
+    /**
+     * @brief Libera o buffer entregue em trocar() após a conclusão da escrita.
+     */
+    void liberar() {
+        ocupado[ativo ^ 1] = 0;
+        emEscrita = false;
+    }
+
+    /**
+     * @brief Escreve de forma síncrona o que estiver pendente (usado pelo backend epoll).
+     * @details Uma escrita interrompida por sinal é repetida; outro erro é registrado e o
+     * restante do buffer, descartado.
+     */
+    void descarregar() {
+        const char* dados;
+        size_t tamanho;
+        while (trocar(dados, tamanho)) {
+            while (tamanho > 0) {
+                ssize_t r = write(fd, dados, tamanho);
+                if (r < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (r < 0) {
+                    LOG_ERRO("Falha ao escrever amostras", campoErrno(), campo("bytes_perdidos", tamanho));
+                    break;
+                }
+                dados += r;
+                tamanho -= static_cast<size_t>(r);
+            }
+            liberar();
+        }
+    }
+};
+
+#endif // ARMAZEM_AMOSTRAS_HPP
@@ -7,16 +7,116 @@
  * em uma estimativa percentual de luminosidade (0% = escuro, 100% = claro).
  * O valor lido é então enviado via protocolo UDP (datagrama) para o servidor
  * rodando no endereço SERVER_IP (Host Windows/WSL) na porta 8080.
+ *
+ * Cada leitura vira uma amostra com instante (CLOCK_REALTIME) e número de sequência, anexada a
+ * um spool local em arquivo (spool_amostras.hpp) antes do envio. Enquanto o coletor está
+ * inalcançável, as amostras ficam retidas no spool; quando a rede volta, o atraso é drenado a
+ * uma taxa limitada em datagramas binários (protocolo_ldr.hpp), com os instantes e as
+ * sequências originais.
+ *
+ * No modo confiável (`-R`), os datagramas levam a flag LDR_FLAG_CONFIAVEL e ficam guardados em
+ * uma janela de retransmissão (confiabilidade_udp.hpp) até o coletor confirmá-los; o thread de
+ * transmissão trata as confirmações recebidas e reenvia apenas os datagramas que faltam.
+ *
+ * No modo FEC (`-F K,M`), a cada K datagramas o cliente envia M pacotes de reparo com a paridade
+ * XOR intercalada do grupo (fec_udp.hpp), com os quais o coletor reconstrói um datagrama perdido
+ * sem retransmissão.
+ *
+ * A taxa de amostragem é adaptativa (amostragem_adaptativa.hpp): ociosa enquanto o sinal filtrado
+ * está parado e de rajada quando a sua derivada ou a variância da leitura passam dos limiares. Na
+ * rajada, as leituras são enviadas em lotes a cada INTERVALO_ENVIO_RAJADA_MS, com a taxa ativa
+ * no cabeçalho de cada datagrama.
+ *
+ * Com `-e`, a leitura ociosa dá lugar aos eventos de limiar do ADC (eventos_iio.hpp): o cliente
+ * arma uma janela em torno da última leitura e dorme no descritor de eventos do IIO até a
+ * luminosidade sair dela, quando entra direto na rajada; sem evento, lê uma vez por batimento.
+ *
+ * A aquisição e a transmissão são dois estágios em threads separados, ligados por uma fila sem
+ * trava de um produtor e um consumidor (fila_spsc.hpp): o thread de aquisição só lê o ADC,
+ * carimba a amostra e a coloca na fila; o de transmissão anexa ao spool, agrupa, codifica e
+ * envia. Um envio lento ou um coletor inalcançável nunca atrasam a próxima leitura. O atraso de
+ * cada despertar da aquisição é medido e informado no log a cada RELATORIO_JITTER_S.
+ *
+ * Com `-T`, o modo de tempo real (tempo_real.hpp) trava a memória, fixa o thread de aquisição
+ * em um núcleo e o coloca em SCHED_FIFO; o de transmissão fica sem prioridade de tempo real.
+ *
+ * Com `-C`, o socket é conectado ao coletor uma vez: os envios usam send() com a rota em cache,
+ * e um ICMP de porta inalcançável volta como ECONNREFUSED, tratado como um estado ("coletor
+ * recusando") em vez de um erro por datagrama; enquanto dura, sai uma amostra por segundo.
+ *
+ * Com `-G`, o atraso do spool sai em envios segmentados (gso_udp.hpp): um único sendmsg() com
+ * UDP_SEGMENT leva até GSO_MAX_SEGMENTOS datagramas cheios, divididos pelo kernel na saída. Sem
+ * suporte no kernel, o cliente volta ao envio de um datagrama por vez. Com `-Z`, esses envios
+ * também saem sem cópia (copia_zero.hpp): a carga é codificada em um buffer de um pool que só
+ * volta a ser usado depois da notificação de conclusão do kernel.
+ *
+ * Com `-M`, o cliente publica em um grupo multicast (multicast_udp.hpp) em vez de SERVER_IP:
+ * qualquer número de coletores que entrem no grupo recebe o mesmo fluxo, com uma única
+ * transmissão da placa. O modo confiável (`-R`) não se aplica, pois as confirmações de vários
+ * coletores se misturariam.
+ *
+ * Com `-S`, o cliente pede ao coletor, a cada PERIODO_S segundos (a cada segundo até as primeiras
+ * SINC_FILTRO respostas), uma troca de sincronização de relógio (sincronizacao_relogio.hpp). O
+ * relógio da placa não é ajustado: o coletor estima o desvio e a deriva e corrige os instantes
+ * das amostras na ingestão. Os pedidos saem pelo mesmo socket das amostras.
+ *
+ * O laço não aloca memória em regime: o ADC fica aberto e é relido com pread(), convertido com
+ * std::from_chars, e os datagramas são codificados em buffers fixos (empacotamento direto do
+ * cabeçalho binário ou std::to_chars no formato texto de `-t`).
+ *
+ * Uso: `clienteUDP_sensor_ldr [-f SPOOL] [-c CAPACIDADE] [-r AMOSTRAS_POR_S] [-s ID_SENSOR] [-R] [-F K,M]
+ * [-a OCIOSA_HZ,RAJADA_HZ] [-l DERIVADA,VARIANCIA] [-m MANUTENCAO_MS] [-e LARGURA[,BATIMENTO_S]]
+ * [-T NUCLEO[,PRIORIDADE]] [-t] [-C] [-G [-Z]]
+ * [-M GRUPO[,TTL[,INTERFACE]]] [-S PERIODO_S] [-y AMOSTRAS[,MS]]`
+ * - `-f`: arquivo do spool (padrão `spool_ldr.bin`);
+ * - `-c`: amostras retidas no spool (potência de 2);
+ * - `-y`: sincroniza o spool em disco a cada AMOSTRAS anexadas ou MS milissegundos, o que vier
+ *   antes (padrão `SPOOL_SINCRONIZAR_A_CADA,SPOOL_SINCRONIZAR_MS`; `1,0` a cada amostra);
+ * - `-r`: taxa de recuperação do atraso, em amostras por segundo (além da leitura atual);
+ * - `-s`: identificador do sensor no protocolo binário;
+ * - `-R`: modo confiável (confirmação seletiva e retransmissão);
+ * - `-F`: modo FEC com grupos de K datagramas e M reparos (ex.: `-F 8,2`);
+ * - `-a`: taxas de amostragem ociosa e de rajada, em Hz (padrão `1,20`; iguais: taxa fixa);
+ * - `-l`: limiares da derivada (%/s) e da variância (%²) que iniciam a rajada (padrão `10,4`);
+ * - `-m`: tempo sem atividade até voltar à taxa ociosa, em ms (padrão 5000);
+ * - `-e`: eventos de limiar com janela de ±LARGURA pontos percentuais e uma leitura de batimento
+ *   a cada BATIMENTO_S segundos sem evento (padrão 30);
+ * - `-T`: modo de tempo real, com a amostragem fixa no NUCLEO em SCHED_FIFO (padrão 80);
+ * - `-t`: formato texto dos coletores antigos, uma amostra por datagrama (incompatível com `-R` e `-F`);
+ * - `-C`: socket conectado ao coletor, com BUFFER_ENVIO_CONECTADO bytes de buffer de envio;
+ * - `-G`: drenagem do spool com segmentação UDP (GSO) (incompatível com `-R` e `-t`);
+ * - `-Z`: envios segmentados sem cópia (MSG_ZEROCOPY) (requer `-G`);
+ * - `-M`: publica no grupo multicast GRUPO (ex.: MULTICAST_GRUPO_PADRAO), com o TTL (padrão 1) e a
+ *   interface de saída (ex.: `127.0.0.1` para testes no loopback) indicados (incompatível com `-R`);
+ * - `-S`: sincronização do relógio com o coletor a cada PERIODO_S segundos (incompatível com `-M` e `-t`).
  */
 
-#include <iostream>
-#include <fstream>
+#include <charconv>
 #include <cstring>
+#include <fcntl.h>
 #include <unistd.h>
 #include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h> // Funções de socket (POSIX)
 #include <arpa/inet.h> // Funções de conversão de endereço (inet_pton)
-#include <string> // Necessário para std::string e std::to_string
+#include <string> // Necessário para std::string
+#include "amostragem_adaptativa.hpp" // Taxa de amostragem ociosa/rajada conforme a atividade do sinal
+#include "confiabilidade_udp.hpp" // Confirmação seletiva e retransmissão (modo confiável)
+#include "eventos_iio.hpp" // Eventos de limiar do ADC (acorda o cliente só quando a luz muda)
+#include "fec_udp.hpp" // Pacotes de reparo com paridade XOR (modo FEC)
+#include "fila_spsc.hpp" // Fila sem trava entre a amostragem e a transmissão (modo de tempo real)
+#include "log_assincrono.hpp" // Log assíncrono com limitação de taxa (não bloqueia o laço)
+#include "multicast_udp.hpp" // Publicação em grupo multicast (vários coletores, uma transmissão)
+#include "protocolo_ldr.hpp" // Formato binário dos datagramas
+#include "sincronizacao_relogio.hpp" // Trocas de sincronização do relógio da placa com o coletor
+#include "spool_amostras.hpp" // Spool local das amostras pendentes de envio
+#include "tempo_real.hpp" // Memória travada, SCHED_FIFO, afinidade e medição de jitter
 
 using namespace std;
 
@@ -30,10 +130,51 @@ using namespace std;
  */
 #define PORT 8080
 
-/** @def BUFFER_SIZE
- * @brief Tamanho máximo do buffer de comunicação.
+/** @def SPOOL_ARQUIVO
+ * @brief Arquivo padrão do spool de amostras.
+ */
+#define SPOOL_ARQUIVO "spool_ldr.bin"
+
+/** @def TAXA_RECUPERACAO
+ * @brief Amostras atrasadas reenviadas por segundo, por padrão, quando a rede volta.
+ */
+#define TAXA_RECUPERACAO 256
+
+/** @def INTERVALO_ENVIO_RAJADA_MS
+ * @brief Intervalo entre envios durante a rajada (as leituras do intervalo vão em um lote).
+ */
+#define INTERVALO_ENVIO_RAJADA_MS 100
+
+/** @def BATIMENTO_EVENTOS_S
+ * @brief Intervalo padrão entre leituras sem evento de limiar, no modo de eventos.
+ */
+#define BATIMENTO_EVENTOS_S 30
+
+/** @def PRIORIDADE_TEMPO_REAL
+ * @brief Prioridade SCHED_FIFO padrão do thread de amostragem no modo de tempo real.
+ */
+#define PRIORIDADE_TEMPO_REAL 80
+
+/** @def FILA_LEITURAS
+ * @brief Leituras em trânsito entre a amostragem e a transmissão (potência de 2).
+ */
+#define FILA_LEITURAS 4096
+
+/** @def RELATORIO_JITTER_S
+ * @brief Intervalo entre os relatórios de jitter da amostragem.
  */
-#define BUFFER_SIZE 1024
+#define RELATORIO_JITTER_S 10
+
+/** @def BUFFER_ENVIO_CONECTADO
+ * @brief SO_SNDBUF do socket conectado (absorve a drenagem do spool e os reparos do FEC).
+ */
+#define BUFFER_ENVIO_CONECTADO (256 * 1024)
+
+/** @def RECUSA_EXPIRA_S
+ * @brief Segundos sem ECONNREFUSED até o coletor voltar a ser considerado disponível (com uma
+ * sonda por segundo e a porta fechada, há uma recusa a cada 2 s).
+ */
+#define RECUSA_EXPIRA_S 3
 
 /**
  * @class SensorLDR
@@ -60,6 +201,12 @@ private:
     /**< Resistência fixa usada no divisor resistivo (ohms). */
     const float R_FIXO = 10000.0; 
 
+    /**< Descritor do arquivo do ADC, aberto na primeira leitura e relido com pread(). */
+    int fdAdc = -1;
+
+    /**< Eventos de limiar do canal do ADC (opcionais, ver habilitarEventos()). */
+    EventosLimiarIIO eventos;
+
 public:
     /**
      * @brief Construtor da classe SensorLDR.
@@ -69,22 +216,41 @@ public:
         path = adcPath;
     }
 
+    SensorLDR(const SensorLDR&) = delete;
+    SensorLDR& operator=(const SensorLDR&) = delete;
+
+    ~SensorLDR() {
+        if (fdAdc >= 0) {
+            close(fdAdc);
+        }
+    }
+
     /**
      * @brief Lê o valor cru do ADC.
      *
      * @details A leitura é feita diretamente do arquivo de dispositivo (sysfs) configurado no path.
+     * O arquivo fica aberto entre as leituras: cada uma é um pread() do início (o sysfs gera o
+     * valor de novo a cada leitura do offset 0) e um std::from_chars, sem alocação.
      *
      * @return Valor inteiro lido diretamente do ADC.
      */
     int lerValor() {
-        std::ifstream file(path);
+        if (fdAdc < 0) {
+            fdAdc = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        char texto[16];
+        ssize_t n = fdAdc >= 0 ? pread(fdAdc, texto, sizeof(texto), 0) : -1;
         int valor = 0;
-        if (file.is_open()) {
-            file >> valor;
-            file.close();
+        if (n > 0) {
+            from_chars(texto, texto + n, valor);
         } else {
             // Em um sistema embarcado real, aqui deve haver um tratamento de erro mais robusto.
-            cerr << "Erro: Nao foi possivel abrir o arquivo ADC em " << path << endl;
+            // O log é limitado por ponto de chamada: uma falha persistente não inunda o terminal.
+            LOG_ERRO("Nao foi possivel ler o arquivo ADC", campo("caminho", path.c_str()), campoErrno());
+            if (fdAdc >= 0) {
+                close(fdAdc); // reaberto na próxima leitura (ex.: driver recarregado)
+                fdAdc = -1;
+            }
         }
         return valor;
     }
@@ -121,31 +287,501 @@ public:
         
         return static_cast<int>(porcentagem);
     }
+
+    /**
+     * @brief Valor cru do ADC correspondente a @p percentual (inverso de lerLuminosidadePercentual()).
+     */
+    int valorBrutoPara(double percentual) const {
+        double log_r_claro = log(R_CLARO);
+        double log_r_escuro = log(R_ESCURO);
+        double r_ldr = exp(log_r_escuro - percentual / 100.0 * (log_r_escuro - log_r_claro));
+        // Inverso do divisor de tensão: V_LDR = ADC_MAX * R_FIXO / (R_LDR + R_FIXO)
+        return static_cast<int>(lround(ADC_MAX * R_FIXO / (r_ldr + R_FIXO)));
+    }
+
+    /**
+     * @brief Habilita os eventos de limiar do canal do ADC lido por este sensor.
+     *
+     * @details O dispositivo e o canal vêm do caminho (`.../iio:deviceN/in_voltage<C>_raw`).
+     *
+     * @return 0 ou -errno (o driver pode não ter eventos de limiar).
+     */
+    int habilitarEventos() {
+        size_t barra = path.find_last_of('/');
+        unsigned canal;
+        if (barra == std::string::npos || sscanf(path.c_str() + barra + 1, "in_voltage%u_raw", &canal) != 1) {
+            return -EINVAL;
+        }
+        return eventos.abrir(path.substr(0, barra), canal);
+    }
+
+    /** @brief true se os eventos de limiar estão habilitados. */
+    bool eventosHabilitados() const { return eventos.ativo(); }
+
+    /**
+     * @brief Arma a janela de ±@p largura pontos percentuais em torno de @p percentual.
+     *
+     * @details Os eventos acumulados com a janela anterior são descartados. Um lado da janela
+     * que passe de 0% ou de 100% fica fora da faixa do ADC e nunca dispara.
+     *
+     * @return 0 ou -errno.
+     */
+    int armarJanela(int percentual, int largura) {
+        eventos.descartarPendentes();
+        int descida = percentual - largura <= 0 ? 0 : valorBrutoPara(percentual - largura);
+        int subida = percentual + largura >= 100 ? static_cast<int>(ADC_MAX) : valorBrutoPara(percentual + largura);
+        return eventos.armar(descida, subida);
+    }
+
+    /**
+     * @brief Bloqueia até um evento de limiar ou até @p prazoNs (CLOCK_MONOTONIC).
+     * @return 1 com @p evento preenchido, 0 no prazo ou -errno.
+     */
+    int aguardarEvento(uint64_t prazoNs, EventoLimiar& evento) {
+        return eventos.aguardar(prazoNs, evento);
+    }
 };
 
+/**
+ * @brief Instante atual em CLOCK_MONOTONIC, em nanossegundos.
+ */
+static uint64_t monotonicoNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @brief Instante atual em CLOCK_REALTIME (o relógio dos carimbos das amostras), em nanossegundos.
+ */
+static uint64_t relogioRealNs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @brief Dorme até @p prazoNs (CLOCK_MONOTONIC).
+ */
+static void esperarAte(uint64_t prazoNs) {
+    timespec prazo;
+    prazo.tv_sec = static_cast<time_t>(prazoNs / 1000000000ull);
+    prazo.tv_nsec = static_cast<long>(prazoNs % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &prazo, nullptr) == EINTR) {
+    }
+}
+
+/**
+ * @class Transmissor
+ * @brief Envio das amostras: spool, socket, janela de retransmissão e codificador FEC.
+ *
+ * @details Usado apenas pelo thread de transmissão, com as leituras que recebe pela fila: o
+ * thread de amostragem não toca no spool nem no socket.
+ */
+class Transmissor {
+public:
+    SpoolAmostras& spool;           /**< Amostras pendentes de envio. */
+    int sock;                       /**< Socket UDP. */
+    sockaddr_in destino;            /**< Coletor (ou grupo multicast). */
+    const char* nomeDestino = SERVER_IP; /**< Endereço do destino, para o log. */
+    bool confiavel;                 /**< Modo confiável (-R). */
+    uint64_t taxaRecuperacao;       /**< Amostras atrasadas enviadas por segundo. */
+    JanelaRetransmissao janela;     /**< Datagramas à espera da confirmação do coletor. */
+    CodificadorFec fec;             /**< Paridade dos grupos do modo FEC. */
+    bool usarFec;                   /**< Modo FEC (-F). */
+    bool texto = false;             /**< Formato texto (-t). */
+    bool conectado = false;         /**< Socket conectado ao coletor (-C). */
+    bool recusando = false;         /**< O coletor respondeu com porta inalcançável (só com -C). */
+    BufferGso* gso = nullptr;       /**< Buffers do envio segmentado (-G). */
+    EnvioCopiaZero* copiaZero = nullptr; /**< Pool do envio sem cópia (-Z). */
+    bool avisoGso = false;          /**< A falta de suporte a GSO já foi para o log. */
+    uint64_t ultimaRecusa = 0;      /**< Instante do último ECONNREFUSED (CLOCK_MONOTONIC). */
+    uint64_t ultimoEnvio = 0;       /**< Instante do último envio (CLOCK_MONOTONIC). */
+    uint64_t novas = 0;             /**< Leituras anexadas desde o último envio. */
+    SondaRelogio* sonda = nullptr;  /**< Pedidos de sincronização de relógio (-S). */
+    uint64_t periodoSincNs = 0;     /**< Intervalo entre os pedidos, após os iniciais. */
+    uint64_t proximaSinc = 0;       /**< Instante do próximo pedido (CLOCK_MONOTONIC). */
+
+    Transmissor(SpoolAmostras& spoolAmostras, int socketUdp, const sockaddr_in& coletor, bool modoConfiavel,
+                uint64_t recuperacao, unsigned fecK, unsigned fecM)
+        : spool(spoolAmostras), sock(socketUdp), destino(coletor), confiavel(modoConfiavel),
+          taxaRecuperacao(recuperacao), fec(fecK, fecM), usarFec(fecK > 0) {
+        ultimoEnvio = monotonicoNs() - 1000000000ull;
+    }
+
+    /** @brief Anexa uma leitura ao spool. */
+    void anexar(const AmostraLDR& amostra) {
+        spool.anexar(amostra);
+        novas++;
+    }
+
+    /**
+     * @brief true se é hora de enviar: a cada leitura na taxa ociosa, ou a cada
+     * INTERVALO_ENVIO_RAJADA_MS na rajada (as leituras do intervalo vão juntas em um lote).
+     */
+    bool deveEnviar(bool rajada, uint64_t agora) const {
+        return !rajada || agora - ultimoEnvio >= INTERVALO_ENVIO_RAJADA_MS * 1000000ull;
+    }
+
+    /**
+     * @brief Registra um ECONNREFUSED do socket conectado (ICMP de porta inalcançável do coletor).
+     * @details Só a entrada no estado vai para o log, não cada datagrama recusado.
+     */
+    void registrarRecusa(uint64_t agora) {
+        ultimaRecusa = agora;
+        if (!recusando) {
+            recusando = true;
+            LOG_AVISO("Coletor recusando datagramas (porta inalcancavel); amostras retidas no spool",
+                      campo("destino", nomeDestino), campo("porta", PORT), campo("pendentes", spool.pendentes()));
+        }
+    }
+
+    /** @brief Sai do estado de recusa após RECUSA_EXPIRA_S sem novo ECONNREFUSED. */
+    void verificarRecusa(uint64_t agora) {
+        if (recusando && agora - ultimaRecusa >= RECUSA_EXPIRA_S * 1000000000ull) {
+            recusando = false;
+            LOG_INFO("Coletor voltou a aceitar datagramas", campo("pendentes", spool.pendentes()));
+        }
+    }
+
+    /** @brief true sem amostras atrasadas no spool nem datagramas à espera de confirmação. */
+    bool emDia() const {
+        return spool.pendentes() == 0 && !(confiavel && janela.pendentes() > 0);
+    }
+
+    /**
+     * @brief Envia as amostras pendentes, da mais antiga para a mais nova.
+     * @details O UDP é um protocolo sem conexão e não confiável; a chegada do pacote
+     * não é garantida pelo protocolo e é gerenciada pela aplicação (se necessário).
+     * O uso do UDP prioriza a baixa latência de dados de status em tempo real. Uma falha
+     * local do sendto() (rede inalcançável, sem rota, sem buffers) mantém as amostras no
+     * spool; depois dela, o atraso é drenado a até `taxaRecuperacao` amostras por segundo.
+     *
+     * @param taxaDhz Taxa de amostragem ativa (décimos de Hz).
+     * @param ultima Última leitura (para o log).
+     */
+    void enviar(uint64_t agora, uint16_t taxaDhz, const AmostraLDR& ultima) {
+        ConfiguracaoEnvio envio;
+        envio.janela = confiavel ? &janela : nullptr;
+        envio.agoraNs = agora;
+        envio.fec = usarFec ? &fec : nullptr;
+        envio.taxaDhz = taxaDhz;
+        envio.texto = texto;
+        envio.conectado = conectado;
+        envio.gso = gso;
+        envio.copiaZero = copiaZero;
+        if (copiaZero != nullptr) {
+            copiaZero->processarConclusoes();
+        }
+        uint64_t recuperacao = taxaRecuperacao * (agora - ultimoEnvio) / 1000000000ull;
+        uint64_t lidas = novas;
+        // Com o coletor recusando, cada datagrama aceito pelo socket se perderia: sai só uma
+        // amostra por segundo, que serve de sonda, e as demais esperam no spool.
+        uint64_t maximo = recusando ? (agora - ultimoEnvio >= 1000000000ull ? 1 : 0) : lidas + recuperacao;
+        int64_t enviadas = maximo > 0 ? drenarSpool(spool, sock, destino, maximo, envio) : 0;
+        if (maximo == 0) {
+            novas = 0;
+            return;
+        }
+        ultimoEnvio = agora;
+        novas = 0;
+        if (gso != nullptr && gso->indisponivel && !avisoGso) {
+            avisoGso = true;
+            LOG_AVISO("Kernel sem segmentacao UDP (GSO); mantido o envio de um datagrama por vez");
+        }
+
+        if (enviadas == -ECONNREFUSED) {
+            registrarRecusa(agora);
+        } else if (enviadas < 0) {
+            errno = static_cast<int>(-enviadas);
+            LOG_ERRO("Erro ao enviar datagrama; amostra retida no spool", campoErrno(),
+                     campo("destino", nomeDestino), campo("porta", PORT), campo("pendentes", spool.pendentes()));
+        } else if (recusando) {
+            // Sonda: o estado de recusa já está no log.
+        } else if (spool.pendentes() > 0 || static_cast<uint64_t>(enviadas) > lidas) {
+            LOG_INFO("Recuperando amostras do spool", campo("enviadas", enviadas),
+                     campo("pendentes", spool.pendentes()), campo("descartadas", spool.descartadas()));
+        } else {
+            // Uma única linha estruturada por envio, escrita pelo thread de log (sem flush aqui)
+            LOG_INFO("Datagrama enviado", campo("destino", nomeDestino), campo("porta", PORT),
+                     campo("seq", ultima.seq), campo("luminosidade", ultima.valor), campo("amostras", enviadas),
+                     campo("taxa_hz", taxaDhz / 10.0));
+        }
+    }
+
+    /**
+     * @brief Envia um pedido de sincronização de relógio, se é a hora (só com -S).
+     * @details t1 é lido logo antes do envio; uma falha só adia o pedido para o próximo período.
+     */
+    void sincronizar(uint64_t agora) {
+        if (sonda == nullptr || agora < proximaSinc) {
+            return;
+        }
+        char pedido[sizeof(CabecalhoSincLDR)];
+        size_t tamanho = sonda->codificarPedido(pedido, relogioRealNs());
+        enviarDatagrama(sock, pedido, tamanho, destino, conectado);
+        proximaSinc = agora + (sonda->respostasRecebidas() < SINC_FILTRO ? SINC_PERIODO_INICIAL_S * 1000000000ull
+                                                                         : periodoSincNs);
+    }
+
+    /**
+     * @brief Processa as respostas já recebidas do coletor (confirmações e, com -S, respostas de
+     * sincronização) e retransmite os datagramas da janela com lacuna confirmada ou sem
+     * confirmação além do tempo de retransmissão (não bloqueia).
+     */
+    void tratarRespostas(uint64_t agora) {
+        char datagrama[sizeof(CabecalhoAckLDR) + LDR_ACK_PALAVRAS * sizeof(uint64_t)];
+        ssize_t n;
+        while ((n = recv(sock, datagrama, sizeof(datagrama), MSG_DONTWAIT)) >= 0) {
+            if (sonda != nullptr && ehSincronizacao(datagrama, static_cast<size_t>(n))) {
+                // t4: chegada da resposta, lida antes de qualquer outro trabalho
+                if (sonda->processarResposta(datagrama, static_cast<size_t>(n), relogioRealNs()) &&
+                    sonda->respostasRecebidas() <= SINC_FILTRO) {
+                    LOG_INFO("Troca de sincronizacao de relogio", campo("desvio_ms", sonda->desvioNs() / 1e6),
+                             campo("atraso_us", sonda->atrasoNs() / 1e3), campo("respostas", sonda->respostasRecebidas()));
+                }
+            } else if (confiavel) {
+                janela.processarAck(datagrama, static_cast<size_t>(n), agora);
+            }
+        }
+        if (errno == ECONNREFUSED) {
+            registrarRecusa(agora);
+        }
+        if (!confiavel) {
+            return;
+        }
+        uint32_t reenviados = janela.retransmitir(agora, [&](const char* dados, size_t tamanho) {
+            return enviarDatagrama(sock, dados, tamanho, destino, conectado) >= 0;
+        });
+        if (reenviados > 0) {
+            LOG_INFO("Datagramas retransmitidos", campo("reenviados", reenviados), campo("pendentes", janela.pendentes()),
+                     campo("total", janela.datagramasRetransmitidos()),
+                     campo("abandonados", janela.datagramasAbandonados()));
+        }
+    }
+};
+
+/**
+ * @brief Leitura passada do thread de amostragem ao de transmissão.
+ */
+struct LeituraAmostrada {
+    AmostraLDR amostra;   /**< Amostra carimbada. */
+    uint16_t taxaDhz;     /**< Taxa ativa na leitura (décimos de Hz). */
+    bool rajada;          /**< true durante a rajada. */
+};
+
+/**< Fila entre o thread de amostragem e o de transmissão. */
+typedef FilaSpsc<LeituraAmostrada, FILA_LEITURAS> FilaLeituras;
+
+/**
+ * @brief Estágio de transmissão: agrupa, codifica e envia as leituras (sem prioridade de tempo real).
+ *
+ * @details Acorda pelo eventfd @p aviso (fila que estava vazia recebeu uma leitura), pelas
+ * respostas do coletor ou a cada 100 ms; anexa as leituras da fila ao spool, envia a cada
+ * leitura na taxa ociosa ou a cada INTERVALO_ENVIO_RAJADA_MS na rajada, registra no log os
+ * envios e as trocas de taxa, e publica em @p emDia se o spool e a janela estão vazios (para o
+ * thread de amostragem poder dormir nos eventos de limiar). Um envio lento ou um coletor
+ * inalcançável só atrasam este thread: as leituras se acumulam na fila e no spool.
+ */
+static void executarTransmissor(Transmissor& t, FilaLeituras& fila, int aviso, std::atomic<bool>& emDia) {
+    LeituraAmostrada leitura{};
+    uint16_t taxaAnterior = 0;
+    while (true) {
+        pollfd p[2] = {{aviso, POLLIN, 0}, {t.sock, POLLIN, 0}};
+        poll(p, t.confiavel || t.sonda != nullptr ? 2 : 1, 100);
+        uint64_t avisos;
+        (void)!read(aviso, &avisos, sizeof(avisos));
+        uint64_t agora = monotonicoNs();
+        while (fila.retirar(leitura)) {
+            t.anexar(leitura.amostra);
+            if (leitura.taxaDhz != taxaAnterior) {
+                if (taxaAnterior != 0) {
+                    LOG_INFO("Taxa de amostragem alterada", campo("taxa_hz", leitura.taxaDhz / 10.0),
+                             campo("rajada", leitura.rajada ? "sim" : "nao"), campo("seq", leitura.amostra.seq));
+                }
+                taxaAnterior = leitura.taxaDhz;
+            }
+        }
+        // Sem leitura nova (ex.: dormindo nos eventos), o atraso do spool segue a cada segundo.
+        if (t.novas > 0 ? t.deveEnviar(leitura.rajada, agora)
+                        : t.spool.pendentes() > 0 && agora - t.ultimoEnvio >= 1000000000ull) {
+            t.enviar(agora, leitura.taxaDhz, leitura.amostra);
+        }
+        t.sincronizar(agora);
+        if (t.confiavel || t.sonda != nullptr) {
+            t.tratarRespostas(agora);
+        }
+        t.verificarRecusa(agora);
+        emDia.store(t.emDia(), std::memory_order_release);
+    }
+}
+
 /**
  * @brief Função principal.
  *
- * @details Configura o socket UDP para enviar dados para o servidor 192.168.42.10:8080.
- * Cria um objeto SensorLDR, lê continuamente a luminosidade, converte o valor inteiro
- * para string e envia o datagrama para o servidor a cada segundo.
+ * @details Configura o socket UDP para enviar dados para o servidor 192.168.42.10:8080 e inicia
+ * o thread de transmissão. Cria um objeto SensorLDR e, na taxa ativa do agendador, lê a
+ * luminosidade e passa a amostra ao transmissor, que a anexa ao spool e envia as pendentes (as
+ * novas e até `-r` atrasadas por segundo) em datagramas binários.
  *
  * @return 0 em caso de execução normal.
  */
-int main() {
+int main(int argc, char* argv[]) {
+    string arquivoSpool = SPOOL_ARQUIVO;
+    uint32_t capacidadeSpool = SPOOL_CAPACIDADE_PADRAO;
+    uint32_t sincronizarACada = SPOOL_SINCRONIZAR_A_CADA;
+    uint32_t sincronizarMs = SPOOL_SINCRONIZAR_MS;
+    uint64_t taxaRecuperacao = TAXA_RECUPERACAO;
+    uint32_t idSensor = 0;
+    bool confiavel = false;
+    bool texto = false;
+    bool conectar = false;
+    bool segmentar = false;
+    bool semCopia = false;
+    string grupoMulticast;
+    int ttlMulticast = MULTICAST_TTL_PADRAO;
+    string interfaceMulticast;
+    unsigned fecK = 0, fecM = 0;
+    ConfiguracaoAmostragem configAmostragem;
+    int larguraEventos = 0;
+    unsigned batimentoS = BATIMENTO_EVENTOS_S;
+    int nucleoTempoReal = -1;
+    int prioridadeTempoReal = PRIORIDADE_TEMPO_REAL;
+    unsigned periodoSincS = 0;
+    int opcao;
+    while ((opcao = getopt(argc, argv, "f:c:r:s:RF:a:l:m:e:T:tCGZM:S:y:")) != -1) {
+        switch (opcao) {
+            case 'f': arquivoSpool = optarg; break;
+            case 'c': capacidadeSpool = static_cast<uint32_t>(strtoul(optarg, nullptr, 10)); break;
+            case 'r': taxaRecuperacao = strtoull(optarg, nullptr, 10); break;
+            case 's': idSensor = static_cast<uint32_t>(strtoul(optarg, nullptr, 10)); break;
+            case 'R': confiavel = true; break;
+            case 't': texto = true; break;
+            case 'C': conectar = true; break;
+            case 'G': segmentar = true; break;
+            case 'Z': semCopia = true; break;
+            case 'M': {
+                char grupo[INET_ADDRSTRLEN] = "", interface[INET_ADDRSTRLEN] = "";
+                if (sscanf(optarg, "%15[^,],%d,%15s", grupo, &ttlMulticast, interface) < 1 || ttlMulticast < 0 ||
+                    ttlMulticast > 255) {
+                    fprintf(stderr, "Opcao -M invalida: use GRUPO[,TTL[,INTERFACE]] (ex.: %s,1)\n",
+                            MULTICAST_GRUPO_PADRAO);
+                    return 1;
+                }
+                grupoMulticast = grupo;
+                interfaceMulticast = interface;
+                break;
+            }
+            case 'F':
+                if (sscanf(optarg, "%u,%u", &fecK, &fecM) != 2 || fecK == 0 || fecM == 0) {
+                    fprintf(stderr, "Opcao -F invalida: use K,M (ex.: 8,2)\n");
+                    return 1;
+                }
+                break;
+            case 'a':
+                if (sscanf(optarg, "%lf,%lf", &configAmostragem.taxaOciosaHz, &configAmostragem.taxaRajadaHz) != 2) {
+                    fprintf(stderr, "Opcao -a invalida: use OCIOSA_HZ,RAJADA_HZ (ex.: 1,20)\n");
+                    return 1;
+                }
+                break;
+            case 'l':
+                if (sscanf(optarg, "%lf,%lf", &configAmostragem.limiarDerivada, &configAmostragem.limiarVariancia) != 2) {
+                    fprintf(stderr, "Opcao -l invalida: use DERIVADA,VARIANCIA (ex.: 10,4)\n");
+                    return 1;
+                }
+                break;
+            case 'm': configAmostragem.manutencaoMs = static_cast<uint32_t>(strtoul(optarg, nullptr, 10)); break;
+            case 'e':
+                if (sscanf(optarg, "%d,%u", &larguraEventos, &batimentoS) < 1 || larguraEventos <= 0 || batimentoS == 0) {
+                    fprintf(stderr, "Opcao -e invalida: use LARGURA[,BATIMENTO_S] (ex.: 5,30)\n");
+                    return 1;
+                }
+                break;
+            case 'y':
+                if (sscanf(optarg, "%u,%u", &sincronizarACada, &sincronizarMs) < 1 || sincronizarACada == 0) {
+                    fprintf(stderr, "Opcao -y invalida: use AMOSTRAS[,MS] (ex.: %d,%d)\n", SPOOL_SINCRONIZAR_A_CADA,
+                            SPOOL_SINCRONIZAR_MS);
+                    return 1;
+                }
+                break;
+            case 'S':
+                if (sscanf(optarg, "%u", &periodoSincS) != 1 || periodoSincS == 0) {
+                    fprintf(stderr, "Opcao -S invalida: use PERIODO_S (ex.: 64)\n");
+                    return 1;
+                }
+                break;
+            case 'T':
+                if (sscanf(optarg, "%d,%d", &nucleoTempoReal, &prioridadeTempoReal) < 1 || nucleoTempoReal < 0) {
+                    fprintf(stderr, "Opcao -T invalida: use NUCLEO[,PRIORIDADE] (ex.: 3,80)\n");
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "Uso: %s [-f SPOOL] [-c CAPACIDADE] [-r AMOSTRAS_POR_S] [-s ID_SENSOR] [-R] [-F K,M] "
+                        "[-a OCIOSA_HZ,RAJADA_HZ] [-l DERIVADA,VARIANCIA] [-m MANUTENCAO_MS] [-e LARGURA[,BATIMENTO_S]] "
+                        "[-T NUCLEO[,PRIORIDADE]] [-t] [-C] [-G [-Z]] [-M GRUPO[,TTL[,INTERFACE]]] [-S PERIODO_S] "
+                        "[-y AMOSTRAS[,MS]]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (texto && (confiavel || fecK > 0)) {
+        fprintf(stderr, "Opcao -t invalida com -R ou -F: o formato texto nao tem sequencia\n");
+        return 1;
+    }
+    if (segmentar && (confiavel || texto)) {
+        fprintf(stderr, "Opcao -G invalida com -R ou -t: so a drenagem binaria sem janela e segmentada\n");
+        return 1;
+    }
+    if (!grupoMulticast.empty() && confiavel) {
+        fprintf(stderr, "Opcao -M invalida com -R: as confirmacoes de varios coletores se misturariam\n");
+        return 1;
+    }
+    if (periodoSincS > 0 && (!grupoMulticast.empty() || texto)) {
+        fprintf(stderr, "Opcao -S invalida com -M ou -t: so um coletor responde, e so aos instantes binarios\n");
+        return 1;
+    }
+    if (semCopia && !segmentar) {
+        fprintf(stderr, "Opcao -Z requer -G: so os envios segmentados saem sem copia\n");
+        return 1;
+    }
+
+    // Spool local: as amostras só saem dele depois de enviadas, inclusive entre execuções
+    SpoolAmostras spool;
+    int r = spool.abrir(arquivoSpool, capacidadeSpool, sincronizarACada, sincronizarMs);
+    if (r < 0) {
+        errno = -r;
+        LOG_ERRO("Erro ao abrir o spool de amostras", campoErrno(), campo("arquivo", arquivoSpool.c_str()));
+        return -1;
+    }
+    // A sequência continua da última amostra registrada, para o coletor não ver um recomeço
+    AmostraLDR ultima;
+    uint32_t seq = spool.ultimaAmostra(ultima) ? ultima.seq + 1 : 0;
+    LOG_INFO("Spool de amostras aberto", campo("arquivo", arquivoSpool.c_str()), campo("pendentes", spool.pendentes()),
+             campo("capacidade", spool.capacidade()), campo("descartadas", spool.descartadas()),
+             campo("sincronizar_a_cada", sincronizarACada), campo("sincronizar_ms", sincronizarMs));
+
     // Inicializa o sensor LDR com o caminho do arquivo ADC no sysfs da placa
     SensorLDR ldr("/sys/bus/iio/devices/iio:device0/in_voltage13_raw");
+    if (larguraEventos > 0) {
+        r = ldr.habilitarEventos();
+        if (r < 0) {
+            errno = -r;
+            LOG_ERRO("Eventos de limiar indisponiveis; mantida a leitura periodica", campoErrno());
+        } else {
+            LOG_INFO("Eventos de limiar habilitados", campo("largura", larguraEventos), campo("batimento_s", batimentoS));
+        }
+    }
 
     int client_socket;
     struct sockaddr_in server_addr;
-    char buffer[BUFFER_SIZE];
     
     // 1. Criar o Socket
     // AF_INET: Endereços IPv4
     // SOCK_DGRAM: Protocolo UDP (datagrama, sem conexão)
-    client_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    // SOCK_NONBLOCK: com o buffer de envio cheio, a amostra fica no spool em vez de parar o transmissor
+    client_socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
     if (client_socket < 0) {
-        perror("Erro ao criar o socket UDP do cliente");
+        LOG_ERRO("Erro ao criar o socket UDP do cliente", campoErrno());
         return -1;
     }
 
@@ -154,60 +790,191 @@ int main() {
     server_addr.sin_family = AF_INET;
     server_addr.sin_port = htons(PORT); // Converte a porta (8080) para a ordem de bytes de rede
 
-    // Converter endereço IP de string para formato binário
-    if (inet_pton(AF_INET, SERVER_IP, &server_addr.sin_addr) <= 0) {
-        perror("Endereco IP invalido/nao suportado");
+    // Converter endereço IP de string para formato binário (o grupo de -M substitui SERVER_IP)
+    const char* ipDestino = grupoMulticast.empty() ? SERVER_IP : grupoMulticast.c_str();
+    if (inet_pton(AF_INET, ipDestino, &server_addr.sin_addr) <= 0) {
+        LOG_ERRO("Endereco IP invalido/nao suportado", campo("ip", ipDestino));
         close(client_socket);
         return -1;
     }
-    
-    cout << "Socket UDP criado com sucesso." << endl;
+
+    // Publicação multicast (-M): TTL e interface de saída do grupo
+    if (!grupoMulticast.empty()) {
+        if (!ehMulticast(server_addr.sin_addr)) {
+            LOG_ERRO("Endereco de -M nao e um grupo multicast", campo("ip", ipDestino));
+            close(client_socket);
+            return -1;
+        }
+        r = configurarPublicacaoMulticast(client_socket, ttlMulticast,
+                                          interfaceMulticast.empty() ? nullptr : interfaceMulticast.c_str());
+        if (r < 0) {
+            errno = -r;
+            LOG_ERRO("Erro ao configurar a publicacao multicast", campoErrno(), campo("grupo", ipDestino),
+                     campo("interface", interfaceMulticast));
+            close(client_socket);
+            return -1;
+        }
+        LOG_INFO("Publicando no grupo multicast", campo("grupo", ipDestino), campo("porta", PORT),
+                 campo("ttl", ttlMulticast), campo("interface", interfaceMulticast));
+    }
+
+    // Socket conectado (-C): a rota é resolvida uma vez, e os erros ICMP do coletor chegam ao socket
+    if (conectar) {
+        int tamanho = BUFFER_ENVIO_CONECTADO;
+        setsockopt(client_socket, SOL_SOCKET, SO_SNDBUF, &tamanho, sizeof(tamanho));
+        socklen_t n = sizeof(tamanho);
+        getsockopt(client_socket, SOL_SOCKET, SO_SNDBUF, &tamanho, &n);
+        if (connect(client_socket, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)) < 0) {
+            LOG_AVISO("Nao foi possivel conectar o socket UDP; mantido o envio com sendto()", campoErrno());
+            conectar = false;
+        } else {
+            LOG_INFO("Socket UDP conectado ao coletor", campo("destino", ipDestino), campo("porta", PORT),
+                     campo("sndbuf", tamanho));
+        }
+    }
+
+    // Spool, janela de retransmissão do modo confiável e paridade do modo FEC (limites de K e M
+    // aplicados pelo codificador)
+    Transmissor transmissor(spool, client_socket, server_addr, confiavel, taxaRecuperacao, fecK, fecM);
+    transmissor.texto = texto;
+    transmissor.conectado = conectar;
+    transmissor.nomeDestino = ipDestino;
+    // Buffers do envio segmentado (-G): reservados uma vez, fora da pilha do transmissor
+    static BufferGso bufferGso;
+    transmissor.gso = segmentar ? &bufferGso : nullptr;
+    // Envio sem cópia (-Z): os buffers em voo pertencem ao kernel até a notificação de conclusão
+    static EnvioCopiaZero copiaZero;
+    if (semCopia) {
+        r = copiaZero.iniciar(client_socket);
+        if (r < 0) {
+            errno = -r;
+            LOG_AVISO("Envio sem copia (MSG_ZEROCOPY) indisponivel; mantida a copia", campoErrno());
+            semCopia = false;
+        } else {
+            transmissor.copiaZero = &copiaZero;
+        }
+    }
+    // Sincronização de relógio (-S): pedidos pelo socket das amostras, tratados pelo transmissor
+    static SondaRelogio sonda(idSensor);
+    if (periodoSincS > 0) {
+        transmissor.sonda = &sonda;
+        transmissor.periodoSincNs = periodoSincS * 1000000000ull;
+    }
+    LOG_INFO("Socket UDP criado com sucesso.", campo("confiavel", confiavel ? "sim" : "nao"), campo("fec_k", fecK),
+             campo("fec_m", fecM), campo("formato", texto ? "texto" : "binario"),
+             campo("gso", segmentar ? "sim" : "nao"), campo("copia_zero", semCopia ? "sim" : "nao"),
+             campo("sincronizacao_s", periodoSincS));
+
+    // Estágio de transmissão: thread próprio, alimentado por uma fila sem trava. É criado antes
+    // de o thread de amostragem travar a memória e subir de prioridade (fica em SCHED_OTHER).
+    static FilaLeituras fila;
+    std::atomic<bool> transmissorEmDia{false};
+    uint64_t leiturasDescartadas = 0;
+    int aviso = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (aviso < 0) {
+        LOG_ERRO("Erro ao criar o eventfd do transmissor", campoErrno());
+        return -1;
+    }
+    std::thread(executarTransmissor, std::ref(transmissor), std::ref(fila), aviso, std::ref(transmissorEmDia)).detach();
+
+    // Modo de tempo real: memória travada, núcleo fixo e SCHED_FIFO no thread de amostragem
+    if (nucleoTempoReal >= 0) {
+        if ((r = travarMemoria()) < 0) {
+            errno = -r;
+            LOG_AVISO("Nao foi possivel travar a memoria", campoErrno());
+        }
+        if ((r = fixarNucleo(nucleoTempoReal)) < 0) {
+            errno = -r;
+            LOG_AVISO("Nao foi possivel fixar a amostragem no nucleo", campoErrno(), campo("nucleo", nucleoTempoReal));
+        }
+        if ((r = escalonarFifo(prioridadeTempoReal)) < 0) {
+            errno = -r;
+            LOG_AVISO("Nao foi possivel usar SCHED_FIFO", campoErrno(), campo("prioridade", prioridadeTempoReal));
+        }
+        LOG_INFO("Modo de tempo real", campo("nucleo", nucleoTempoReal), campo("prioridade", prioridadeTempoReal));
+    }
+
+    // Taxa de amostragem conforme a atividade do sinal
+    AgendadorAmostragem agendador(configAmostragem);
+    // Atraso de cada despertar em relação ao instante agendado, informado a cada RELATORIO_JITTER_S
+    MedidorJitter jitter;
+    uint64_t proximaLeitura = monotonicoNs();
+    uint64_t proximoRelatorio = proximaLeitura + RELATORIO_JITTER_S * 1000000000ull;
+    bool medirDespertar = false;
 
     /**
-     * @brief Loop principal de leitura e envio.
-     * @details O loop executa leituras e envios a cada 1 segundo.
+     * @brief Estágio de aquisição: lê e carimba uma amostra por período da taxa ativa.
+     * @details Cada leitura vai pela fila ao thread de transmissão, que a anexa ao spool e a
+     * envia; este laço nunca espera pela rede. Com a fila cheia (transmissão parada por mais
+     * de FILA_LEITURAS leituras), a leitura é descartada e contada.
      */
     while (true) {
-        memset(buffer, 0, BUFFER_SIZE);
-
-        // O valor lido do sensor é um INT
-        int val = ldr.lerLuminosidadePercentual();
+        if (medirDespertar) {
+            jitter.registrar(proximaLeitura, monotonicoNs());
+        }
+        // Carimba a leitura com o instante e a sequência originais, preservados no spool
+        timespec agora;
+        clock_gettime(CLOCK_REALTIME, &agora);
+        AmostraLDR amostra;
+        amostra.t_ns = static_cast<uint64_t>(agora.tv_sec) * 1000000000ull + static_cast<uint64_t>(agora.tv_nsec);
+        amostra.id_sensor = idSensor;
+        amostra.seq = seq++;
+        amostra.valor = ldr.lerLuminosidadePercentual();
 
-        // Converte o valor inteiro (int) para uma string C++ (std::string)
-        string val_str = to_string(val);
+        uint64_t agoraMono = monotonicoNs();
+        agendador.registrar(amostra.valor, agoraMono);
+        if (!fila.colocar(LeituraAmostrada{amostra, agendador.taxaDhz(), agendador.emRajada()})) {
+            leiturasDescartadas++;
+        } else if (fila.tamanho() == 1) {
+            // Só a leitura que encontra a fila vazia acorda o transmissor; as seguintes ele
+            // encontra ao esvaziá-la (ou no seu temporizador de 100 ms)
+            uint64_t um = 1;
+            (void)!write(aviso, &um, sizeof(um));
+        }
+        if (agoraMono >= proximoRelatorio && jitter.despertares() > 0) {
+            LOG_INFO("Jitter de amostragem", campo("despertares", jitter.despertares()),
+                     campo("medio_us", jitter.medioUs()), campo("p99_us", jitter.percentilUs(0.99)),
+                     campo("max_us", jitter.maximoUs()), campo("descartadas", leiturasDescartadas));
+            jitter.zerar();
+            proximoRelatorio = agoraMono + RELATORIO_JITTER_S * 1000000000ull;
+        }
 
-        // Obtém o ponteiro C-style (const char*) da string para uso na função sendto()
-        const char *message = val_str.c_str(); 
-    
-        // Calcula o tamanho da mensagem (apenas o tamanho da string, sem o terminador nulo)
-        size_t message_len = val_str.length();
-
-        /**
-         * @brief Envia o datagrama UDP.
-         * @details O UDP é um protocolo sem conexão e não confiável; a chegada do pacote
-         * não é garantida pelo protocolo e é gerenciada pela aplicação (se necessário).
-         * O uso do UDP prioriza a baixa latência de dados de status em tempo real.
-         * @param client_socket O descritor do socket.
-         * @param message O ponteiro para os dados a serem enviados.
-         * @param message_len O tamanho dos dados.
-         * @param 0 Flags (geralmente 0 para UDP).
-         * @param server_addr O endereço de destino.
-         * @param sizeof(server_addr) O tamanho da estrutura de endereço.
-         */
-        ssize_t bytes_sent = sendto(client_socket, message, message_len, 0, (const struct sockaddr *)&server_addr, sizeof(server_addr));
-
-        if (bytes_sent == -1) {
-            perror("Erro ao enviar datagrama");
-        } 
-        else{
-            cout << "Datagrama enviado (" << bytes_sent << " bytes) para " << SERVER_IP << ":" << PORT << endl;
-            cout << "Luminosidade: " << message << "%" << std::endl;
-            sleep(1); // Espera 1 segundo antes da próxima leitura/envio
+        // Espera o período da taxa ativa antes da próxima leitura/envio
+        proximaLeitura += agendador.periodoNs();
+        if (proximaLeitura < agoraMono) {
+            proximaLeitura = agoraMono; // atrasado (ex.: suspensão): não tenta recuperar leituras perdidas
+        }
+        medirDespertar = true;
+        // Ociosa, sem nada a confirmar nem atrasado no spool: dorme até um evento de limiar
+        bool dormirEmEventos = ldr.eventosHabilitados() && !agendador.emRajada() &&
+                               transmissorEmDia.load(std::memory_order_acquire);
+        if (dormirEmEventos && (r = ldr.armarJanela(amostra.valor, larguraEventos)) < 0) {
+            errno = -r;
+            LOG_ERRO("Erro ao armar os limiares do ADC", campoErrno());
+            dormirEmEventos = false;
+        }
+        if (dormirEmEventos) {
+            EventoLimiar evento;
+            int e = ldr.aguardarEvento(agoraMono + batimentoS * 1000000000ull, evento);
+            proximaLeitura = monotonicoNs();
+            medirDespertar = false; // o despertar por evento não tem instante agendado
+            if (e > 0) {
+                agendador.forcarRajada(proximaLeitura);
+                LOG_INFO("Evento de limiar", campo("direcao", evento.subida ? "claro" : "escuro"),
+                         campo("taxa_hz", agendador.taxaHz()));
+            } else if (e < 0) {
+                errno = -e;
+                LOG_ERRO("Erro ao aguardar evento de limiar", campoErrno());
+                proximaLeitura = agoraMono + agendador.periodoNs();
+                esperarAte(proximaLeitura);
+            }
+        } else {
+            esperarAte(proximaLeitura);
         }
     }
     // O loop é infinito, o código abaixo só seria executado em caso de interrupção
     // 4. Fechar o Socket
     close(client_socket);
-    cout << "Socket fechado. Cliente UDP encerrado." << endl;
+    LOG_INFO("Socket fechado. Cliente UDP encerrado.");
     return 0;
 }
\ No newline at end of file
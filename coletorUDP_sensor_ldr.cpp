@@ -0,0 +1,382 @@
+/**
+ * @file coletorUDP_sensor_ldr.cpp
+ * @brief Coletor nativo dos datagramas do sensor LDR (alternativa de alto desempenho ao servidor Python).
+ *
+ * @details Recebe os datagramas UDP enviados pelo `clienteUDP_sensor_ldr`, decodifica cada um em
+ * amostras de tamanho fixo e as anexa ao arquivo de amostras. A recepção é dividida entre N
+ * trabalhadores, cada um com o seu socket SO_REUSEPORT, o seu núcleo e o seu laço de eventos
+ * (ver coletor_multinucleo.hpp). Cada laço atende a recepção, a escrita em disco e o seu
+ * temporizador, com dois backends:
+ * - `uring` (padrão): io_uring com recvmsg multishot, anel de buffers fornecidos e descritores fixos;
+ * - `epoll`: epoll + recvmmsg, usado automaticamente se o kernel não suportar o io_uring.
+ *
+ * Os contadores e as tabelas de sensores de cada núcleo só são agregados na consulta periódica
+ * feita pelo thread principal.
+ *
+ * Cada amostra também passa pelo motor de alertas (motor_alertas.hpp); as transições são
+ * registradas no log. Sem `-A`, valem as regras do servidor Python: escuridão abaixo de 10% e luz
+ * intensa acima de 90%, com histerese de 3 pontos e duração mínima de 50 ms.
+ *
+ * Com `-u`, o fluxo decodificado é difundido aos assinantes de um socket Unix (ver
+ * difusao_amostras.hpp): interface, arquivamento e exportadores recebem os mesmos datagramas
+ * binários sem disputar a porta UDP, e também as transições de alerta (CabecalhoAlertaLDR) assim
+ * que são detectadas, sem o limite de taxa do log.
+ *
+ * Com `-m`, as amostras também são publicadas em um anel em memória compartilhada (ver
+ * anel_compartilhado.hpp), lido pelos consumidores locais sem chamadas de sistema.
+ *
+ * Com `-w`, cada lote é anexado antes de tudo a um diário de escrita antecipada segmentado (ver
+ * diario_amostras.hpp), sincronizado em disco por commit em grupo; a cauda deixada por uma queda
+ * é recuperada na próxima execução.
+ *
+ * Com `-G`, o socket recebe com UDP_GRO (gso_udp.hpp): datagramas consecutivos do mesmo remetente
+ * chegam juntos em uma leitura e são separados no laço. Só o backend epoll o suporta; com `-G`,
+ * os trabalhadores usam o epoll.
+ *
+ * Com `-M`, o coletor também recebe o grupo multicast em que as placas publicam (cliente com
+ * `-M`), ao lado de outros coletores que entraram no mesmo grupo. Cada remetente novo é
+ * registrado no log, e a linha de estatísticas informa quantos já foram vistos.
+ *
+ * Com `-e`, o coletor opera como gateway (gateway_lotes.hpp): além do processamento local, junta
+ * as amostras de todas as placas por janela e as repassa a um coletor central em lotes
+ * comprimidos, por um único fluxo UDP. O central decodifica os lotes sem opção alguma.
+ *
+ * As placas que pedem sincronização de relógio (cliente com `-S`) são respondidas sem opção
+ * alguma (sincronizacao_relogio.hpp): o coletor estima o desvio e a deriva do relógio de cada uma
+ * e corrige na ingestão os instantes das suas amostras. A cada minuto, um resumo da estimativa
+ * de todas as placas (pior incerteza, maior deriva e maior adiantamento) é registrado no log.
+ * Com `-r`, a estimativa de cada placa também é gravada, no mesmo minuto, em um arquivo CSV
+ * reescrito por inteiro (ver exportarRelogios()), fora do log e do seu limite de taxa.
+ *
+ * Uso: `coletorUDP_sensor_ldr [-b uring|epoll] [-n TRABALHADORES] [-s] [-i IP] [-p PORTA] [-a ARQUIVO] [-A REGRA]... [-u SOCKET] [-m NOME] [-w PREFIXO] [-g MS[,BYTES]] [-G] [-M GRUPO[,INTERFACE]] [-e IP:PORTA[,JANELA_MS]] [-r ARQUIVO]`
+ * - `-s`: direciona os datagramas por id_sensor (BPF), um sensor por núcleo;
+ * - `-A`: regra de alerta `sensor,tipo,limiar,histerese,duracao_ms` (ver lerRegraAlerta());
+ * - `-u`: caminho do socket Unix SOCK_SEQPACKET de difusão;
+ * - `-m`: nome do anel em memória compartilhada (ex.: `/coletor_ldr`);
+ * - `-w`: prefixo dos segmentos do diário (ex.: `diario/ldr`);
+ * - `-g`: commit em grupo do diário a cada MS milissegundos ou BYTES pendentes (padrão `10,262144`);
+ * - `-G`: recepção agregada (UDP_GRO);
+ * - `-M`: grupo multicast e interface por onde entrar nele (padrão `0.0.0.0`: a da rota do grupo);
+ * - `-e`: coletor central e janela de agregação do modo gateway (padrão 100 ms);
+ * - `-r`: arquivo CSV com a sincronização de relógio de cada placa.
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "coletor_multinucleo.hpp"
+#include "log_assincrono.hpp"
+
+/** @def UDP_IP
+ * @brief Endereço de escuta padrão (todas as interfaces).
+ */
+#define UDP_IP "0.0.0.0"
+
+/** @def UDP_PORT
+ * @brief Porta UDP padrão; deve corresponder à porta configurada no cliente C++.
+ */
+#define UDP_PORT 8080
+
+/** @def ARQUIVO_AMOSTRAS
+ * @brief Arquivo de amostras padrão.
+ */
+#define ARQUIVO_AMOSTRAS "amostras_ldr.csv"
+
+/**< Término solicitado por SIGINT/SIGTERM. */
+static std::atomic<bool> encerrar{false};
+
+/**< Transições de alerta que não couberam na fila do log (somadas entre os trabalhadores). */
+static std::atomic<uint64_t> alertasDescartados{0};
+
+/**
+ * @brief Tratador de SIGINT/SIGTERM: solicita o término do coletor.
+ */
+static void aoSinal(int) {
+    encerrar.store(true);
+}
+
+/**
+ * @brief Grava a sincronização de relógio de cada placa em um arquivo CSV.
+ *
+ * @details Uma linha por placa sincronizada (`sensor,adiantamento_ms,deriva_ppm,incerteza_us,trocas`).
+ * O arquivo é escrito ao lado, em `ARQUIVO.tmp`, e renomeado sobre o anterior: quem o lê vê
+ * sempre uma exportação completa.
+ *
+ * @param coletor Coletor cujas tabelas de sensores são percorridas.
+ * @param caminho Arquivo de destino.
+ * @return Número de placas exportadas, ou -1 se o arquivo não pôde ser gravado.
+ */
+static long exportarRelogios(ColetorMultinucleo& coletor, const std::string& caminho) {
+    std::string temporario = caminho + ".tmp";
+    FILE* arquivo = fopen(temporario.c_str(), "w");
+    if (arquivo == nullptr) {
+        return -1;
+    }
+    long placas = 0;
+    fprintf(arquivo, "sensor,adiantamento_ms,deriva_ppm,incerteza_us,trocas\n");
+    for (size_t i = 0; i < coletor.tamanho(); i++) {
+        coletor.laco(i).tabelaSensores().paraCada([&](const ResumoSensor& s) {
+            uint64_t trocas = s.trocasRelogio.load(std::memory_order_relaxed);
+            if (trocas == 0) {
+                return;
+            }
+            placas++;
+            fprintf(arquivo, "%u,%.3f,%.3f,%.1f,%llu\n", s.id.load(std::memory_order_relaxed),
+                    s.adiantamentoNs.load(std::memory_order_relaxed) / 1e6,
+                    s.derivaPpb.load(std::memory_order_relaxed) / 1e3,
+                    s.incertezaNs.load(std::memory_order_relaxed) / 1e3,
+                    static_cast<unsigned long long>(trocas));
+        });
+    }
+    bool gravado = fflush(arquivo) == 0 && !ferror(arquivo);
+    if (fclose(arquivo) != 0 || !gravado || rename(temporario.c_str(), caminho.c_str()) != 0) {
+        int erro = errno;
+        unlink(temporario.c_str());
+        errno = erro;
+        return -1;
+    }
+    return placas;
+}
+
+/**
+ * @brief Função principal.
+ *
+ * @details Interpreta as opções, inicia os trabalhadores e, a cada segundo, agrega e registra
+ * as estatísticas de todos os núcleos até receber SIGINT/SIGTERM.
+ *
+ * @return 0 em caso de execução normal.
+ */
+int main(int argc, char* argv[]) {
+    std::string nomeBackend = "uring";
+    std::string ip = UDP_IP;
+    int porta = UDP_PORT;
+    std::string arquivo = ARQUIVO_AMOSTRAS;
+    unsigned trabalhadores = 1;
+    bool porSensor = false;
+    std::vector<RegraAlerta> regras;
+    std::string socketDifusao;
+    std::string anelCompartilhado;
+    std::string prefixoDiario;
+    ConfiguracaoDiario configuracaoDiario;
+    bool gro = false;
+    std::string grupoMulticast;
+    std::string interfaceMulticast = "0.0.0.0";
+    std::string ipCentral;
+    int portaCentral = UDP_PORT;
+    uint32_t janelaGatewayMs = GATEWAY_JANELA_PADRAO_MS;
+    std::string arquivoRelogios;
+
+    int opcao;
+    while ((opcao = getopt(argc, argv, "b:n:si:p:a:A:u:m:w:g:GM:e:r:")) != -1) {
+        switch (opcao) {
+            case 'b': nomeBackend = optarg; break;
+            case 'n': trabalhadores = static_cast<unsigned>(atoi(optarg)); break;
+            case 's': porSensor = true; break;
+            case 'i': ip = optarg; break;
+            case 'p': porta = atoi(optarg); break;
+            case 'a': arquivo = optarg; break;
+            case 'u': socketDifusao = optarg; break;
+            case 'm': anelCompartilhado = optarg; break;
+            case 'w': prefixoDiario = optarg; break;
+            case 'G': gro = true; break;
+            case 'r': arquivoRelogios = optarg; break;
+            case 'M': {
+                grupoMulticast = optarg;
+                size_t virgula = grupoMulticast.find(',');
+                if (virgula != std::string::npos) {
+                    interfaceMulticast = grupoMulticast.substr(virgula + 1);
+                    grupoMulticast.resize(virgula);
+                }
+                break;
+            }
+            case 'e': {
+                char ipLido[16];
+                unsigned janela = GATEWAY_JANELA_PADRAO_MS;
+                if (sscanf(optarg, "%15[^:]:%d,%u", ipLido, &portaCentral, &janela) < 2 || janela == 0) {
+                    fprintf(stderr, "Coletor central invalido: %s\n", optarg);
+                    return 1;
+                }
+                ipCentral = ipLido;
+                janelaGatewayMs = janela;
+                break;
+            }
+            case 'g': {
+                char* fim;
+                configuracaoDiario.intervaloMs = static_cast<uint32_t>(strtoul(optarg, &fim, 10));
+                if (*fim == ',') {
+                    configuracaoDiario.limiteBytes = strtoull(fim + 1, nullptr, 10);
+                }
+                break;
+            }
+            case 'A': {
+                RegraAlerta regra;
+                if (!lerRegraAlerta(optarg, regra)) {
+                    fprintf(stderr, "Regra de alerta invalida: %s\n", optarg);
+                    return 1;
+                }
+                regras.push_back(regra);
+                break;
+            }
+            default:
+                fprintf(stderr, "Uso: %s [-b uring|epoll] [-n TRABALHADORES] [-s] [-i IP] [-p PORTA] [-a ARQUIVO]"
+                                " [-A sensor,tipo,limiar,histerese,duracao_ms]... [-u SOCKET] [-m NOME]"
+                                " [-w PREFIXO] [-g MS[,BYTES]] [-G] [-M GRUPO[,INTERFACE]]"
+                                " [-e IP:PORTA[,JANELA_MS]] [-r ARQUIVO]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (regras.empty()) {
+        RegraAlerta escuridao;
+        lerRegraAlerta("*,abaixo,10,3,50", escuridao);
+        escuridao.nome = "Escuridao detectada (possivel violacao)";
+        RegraAlerta luz;
+        lerRegraAlerta("*,acima,90,3,50", luz);
+        luz.nome = "Luz intensa detectada (involucro aberto)";
+        regras = {escuridao, luz};
+    }
+    if (trabalhadores == 0) {
+        trabalhadores = 1;
+    }
+
+    struct sigaction acao{};
+    acao.sa_handler = aoSinal;
+    sigaction(SIGINT, &acao, nullptr);
+    sigaction(SIGTERM, &acao, nullptr);
+
+    ColetorMultinucleo coletor;
+    // Sem limite de taxa: numa rajada de alertas cada transição é registrada; as que não couberem
+    // na fila são contadas. Com -u, os assinantes as recebem também pela difusão.
+    coletor.definirAlertas(regras, [](const EventoAlerta& e) {
+        bool registrado = e.ativo
+            ? LOG_SEM_LIMITE(NivelLog::AVISO, "ALERTA", campo("regra", e.regra->nome.c_str()),
+                             campo("sensor", e.id_sensor), campo("valor", e.valor), campo("t_ns", e.t_ns))
+            : LOG_SEM_LIMITE(NivelLog::INFO, "Alerta normalizado", campo("regra", e.regra->nome.c_str()),
+                             campo("sensor", e.id_sensor), campo("valor", e.valor), campo("t_ns", e.t_ns));
+        if (!registrado) {
+            alertasDescartados.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    if (!socketDifusao.empty()) {
+        coletor.habilitarDifusao(socketDifusao);
+    }
+    if (!anelCompartilhado.empty()) {
+        coletor.habilitarAnelCompartilhado(anelCompartilhado);
+    }
+    if (!prefixoDiario.empty()) {
+        coletor.habilitarDiario(prefixoDiario, configuracaoDiario);
+    }
+    if (!grupoMulticast.empty()) {
+        coletor.habilitarMulticast(grupoMulticast, interfaceMulticast);
+    }
+    if (!ipCentral.empty()) {
+        coletor.habilitarGateway(ipCentral, portaCentral, janelaGatewayMs, static_cast<uint32_t>(gethostid()));
+    }
+    if (gro) {
+        coletor.habilitarGro();
+        nomeBackend = "epoll";
+    }
+    if (!coletor.iniciar(ip, porta, trabalhadores, arquivo, nomeBackend, porSensor)) {
+        return 1;
+    }
+    // Como nas estatísticas, a configuração vai em mais de uma linha (LOG_TAMANHO_TEXTO): a
+    // recepção e, separados, os destinos das amostras, que levam caminhos.
+    LOG_INFO("Coletor UDP escutando", campo("ip", ip), campo("porta", porta), campo("backend", nomeBackend),
+             campo("trabalhadores", trabalhadores), campo("por_sensor", porSensor), campo("gro", gro),
+             campo("multicast", grupoMulticast));
+    LOG_INFO("Destinos", campo("arquivo", arquivo), campo("difusao", socketDifusao), campo("anel", anelCompartilhado));
+    if (!prefixoDiario.empty() || !ipCentral.empty() || !arquivoRelogios.empty()) {
+        LOG_INFO("Destinos adicionais", campo("diario", prefixoDiario), campo("central", ipCentral),
+                 campo("relogios", arquivoRelogios));
+    }
+
+    uint64_t anteriorDatagramas = 0;
+    for (unsigned segundos = 1; !encerrar.load(); segundos++) {
+        sleep(1);
+        ResumoColetor r = coletor.consultar();
+        rusage uso;
+        getrusage(RUSAGE_SELF, &uso);
+        // Uma linha não comporta todos os campos (LOG_TAMANHO_TEXTO): a recepção, a entrega e,
+        // quando em uso, o repasse e os relógios vão em linhas próprias.
+        LOG_INFO("Recepcao", campo("datagramas_s", r.datagramas - anteriorDatagramas),
+                 campo("total", r.datagramas), campo("amostras", r.amostras), campo("invalidos", r.invalidos),
+                 campo("sensores", r.sensores), campo("origens", r.origens), campo("fora_de_ordem", r.foraDeOrdem),
+                 campo("cpu_ms", static_cast<long>(uso.ru_utime.tv_sec * 1000 + uso.ru_utime.tv_usec / 1000 +
+                                                   uso.ru_stime.tv_sec * 1000 + uso.ru_stime.tv_usec / 1000)));
+        LOG_INFO("Entrega", campo("assinantes", r.assinantes), campo("fsyncs", r.sincronizacoes),
+                 campo("nao_duraveis", r.naoDuraveis), campo("duplicados", r.duplicados),
+                 campo("acks", r.confirmacoes), campo("recuperados_fec", r.recuperados),
+                 campo("agregados", r.agregados));
+        uint64_t alertasPerdidos = alertasDescartados.load(std::memory_order_relaxed);
+        if (alertasPerdidos > 0) {
+            LOG_AVISO("Alertas nao registrados (fila do log cheia)", campo("total", alertasPerdidos));
+        }
+        if (r.naoArmazenadas > 0) {
+            LOG_AVISO("Amostras nao gravadas (escrita do arquivo atrasada)", campo("total", r.naoArmazenadas));
+        }
+        if (r.lotesRecebidos > 0 || r.lotesEnviados > 0) {
+            LOG_INFO("Encaminhamento", campo("lotes_recebidos", r.lotesRecebidos), campo("lotes_enviados", r.lotesEnviados),
+                     campo("encaminhadas", r.encaminhadas),
+                     campo("compressao", r.bytesLotes > 0 ? static_cast<double>(r.bytesOriginais) / r.bytesLotes : 0.0));
+        }
+        if (r.placasSincronizadas > 0) {
+            LOG_INFO("Relogios", campo("sincronizadas", r.placasSincronizadas),
+                     campo("pior_incerteza_us", r.piorIncertezaNs / 1e3));
+        }
+        anteriorDatagramas = r.datagramas;
+        // A cada minuto, um resumo de todas as placas: uma linha por placa seria suprimida pelo
+        // limite de taxa do ponto de chamada com mais de LOG_TAXA_PADRAO placas. O detalhe por
+        // placa vai para o arquivo de -r.
+        if (segundos % 60 == 0 && !arquivoRelogios.empty() && exportarRelogios(coletor, arquivoRelogios) < 0) {
+            LOG_ERRO("Falha ao gravar os relogios das placas", campoErrno(),
+                     campo("arquivo", arquivoRelogios));
+        }
+        if (segundos % 60 == 0) {
+            uint64_t placas = 0;
+            uint32_t sensorIncerteza = 0, sensorDeriva = 0, sensorAdiantamento = 0;
+            int64_t incerteza = -1, deriva = 0, adiantamento = 0;
+            for (size_t i = 0; i < coletor.tamanho(); i++) {
+                coletor.laco(i).tabelaSensores().paraCada([&](const ResumoSensor& s) {
+                    if (s.trocasRelogio.load(std::memory_order_relaxed) == 0) {
+                        return;
+                    }
+                    placas++;
+                    uint32_t id = s.id.load(std::memory_order_relaxed);
+                    int64_t u = s.incertezaNs.load(std::memory_order_relaxed);
+                    int64_t d = s.derivaPpb.load(std::memory_order_relaxed);
+                    int64_t a = s.adiantamentoNs.load(std::memory_order_relaxed);
+                    if (u > incerteza) {
+                        incerteza = u;
+                        sensorIncerteza = id;
+                    }
+                    if (std::abs(d) >= std::abs(deriva)) {
+                        deriva = d;
+                        sensorDeriva = id;
+                    }
+                    if (std::abs(a) >= std::abs(adiantamento)) {
+                        adiantamento = a;
+                        sensorAdiantamento = id;
+                    }
+                });
+            }
+            if (placas > 0) {
+                LOG_INFO("Relogios das placas", campo("placas", placas),
+                         campo("pior_incerteza_us", incerteza / 1e3), campo("sensor", sensorIncerteza),
+                         campo("maior_deriva_ppm", deriva / 1e3), campo("sensor_deriva", sensorDeriva),
+                         campo("maior_adiantamento_ms", adiantamento / 1e6),
+                         campo("sensor_adiantamento", sensorAdiantamento));
+            }
+        }
+    }
+
+    coletor.parar();
+    coletor.encerrar();
+    LOG_INFO("Coletor UDP encerrado.");
+    return 0;
+}
@@ -0,0 +1,592 @@
+/**
+ * @file coletor_multinucleo.hpp
+ * @brief Recepção fragmentada por núcleo: um socket SO_REUSEPORT e um laço de eventos por trabalhador.
+ *
+ * @details Cada trabalhador abre o seu próprio socket associado ao mesmo endereço (SO_REUSEPORT),
+ * fixa o seu thread em um núcleo e executa um laço de recepção independente, com o seu próprio
+ * arquivo de amostras e a sua própria tabela de sensores: nenhuma estrutura é compartilhada
+ * entre núcleos no caminho de ingestão.
+ *
+ * Por padrão o kernel distribui os datagramas entre os sockets pelo hash do endereço de origem.
+ * Com o direcionamento por sensor habilitado, um programa BPF clássico escolhe o socket por
+ * `id_sensor % N`, lendo o identificador na posição fixa do cabeçalho binário: o fluxo de cada
+ * sensor é tratado sempre pelo mesmo núcleo, o que preserva a ordem sem travas. Datagramas no
+ * formato texto (sem cabeçalho) caem no hash padrão do kernel.
+ *
+ * Os pedidos de sincronização de relógio precisam chegar ao núcleo que recebe as amostras da placa,
+ * onde fica a estimativa usada na correção: o programa BPF os direciona pelo mesmo `id_sensor`, e
+ * no hash padrão basta que a placa os envie pelo mesmo socket das amostras.
+ *
+ * Com um grupo multicast, só o socket do primeiro trabalhador entra no grupo (multicast_udp.hpp):
+ * o kernel não distribui o multicast pelo grupo SO_REUSEPORT, e sim copia cada datagrama para
+ * todos os sockets da porta, o que duplicaria as amostras.
+ *
+ * Com a difusão habilitada, as transições de alerta de cada trabalhador são publicadas no anel
+ * (CabecalhoAlertaLDR) no momento em que são detectadas, entre os lotes de amostras.
+ *
+ * Em modo gateway, um GatewayLotes assina o anel de difusão e repassa as amostras de todos os
+ * trabalhadores ao coletor central, em lotes comprimidos por janela (gateway_lotes.hpp).
+ */
+
+#ifndef COLETOR_MULTINUCLEO_HPP
+#define COLETOR_MULTINUCLEO_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <memory>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <sys/socket.h>
+
+#include "anel_compartilhado.hpp"
+#include "armazem_amostras.hpp"
+#include "diario_amostras.hpp"
+#include "difusao_amostras.hpp"
+#include "gateway_lotes.hpp"
+#include "log_assincrono.hpp"
+#include "multicast_udp.hpp"
+#include "protocolo_ldr.hpp"
+#include "recepcao_udp.hpp"
+#include "recepcao_uring.hpp"
+
+/** @def PERIODO_TEMPORIZADOR_NS
+ * @brief Período do temporizador de cada laço (descarga do armazém).
+ */
+#define PERIODO_TEMPORIZADOR_NS (100 * 1000000ull)
+
+/**
+ * @brief Cria um socket UDP com SO_REUSEPORT associado a @p ip:@p porta.
+ * @return Descritor do socket, ou -1 em caso de erro (registrado no log).
+ */
+inline int criarSocketReusePort(const char* ip, int porta) {
+    int sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        LOG_ERRO("Erro ao criar o socket UDP", campoErrno());
+        return -1;
+    }
+    int um = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &um, sizeof(um));
+    // Buffer de recepção maior absorve rajadas enquanto o laço atende o disco.
+    int tamanho = 4 * 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &tamanho, sizeof(tamanho));
+
+    sockaddr_in endereco{};
+    endereco.sin_family = AF_INET;
+    endereco.sin_port = htons(static_cast<uint16_t>(porta));
+    if (inet_pton(AF_INET, ip, &endereco.sin_addr) <= 0) {
+        LOG_ERRO("Endereco IP invalido/nao suportado", campo("ip", ip));
+        close(sock);
+        return -1;
+    }
+    if (bind(sock, reinterpret_cast<sockaddr*>(&endereco), sizeof(endereco)) < 0) {
+        LOG_ERRO("Erro no bind do socket UDP", campoErrno(), campo("ip", ip), campo("porta", porta));
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+/**
+ * @brief Anexa ao grupo SO_REUSEPORT o programa BPF que escolhe o socket por `id_sensor % n`.
+ *
+ * @details O programa é anexado a um socket, mas vale para o grupo inteiro; o índice retornado
+ * é a ordem de bind dos sockets. Um índice inválido (0xFFFFFFFF, para datagramas sem o
+ * cabeçalho binário) faz o kernel recorrer ao hash padrão. Os pacotes de reparo FEC e os
+ * pedidos de sincronização de relógio trazem o id_sensor na mesma posição e seguem o mesmo
+ * caminho: o reparo chega ao núcleo que guardou os datagramas do grupo.
+ *
+ * @return 0 ou -errno.
+ */
+inline int anexarDirecionamentoPorSensor(int sock, unsigned n) {
+    sock_filter programa[] = {
+        // A = magia (16 bits, ordem da rede já convertida pelo BPF)
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, LDR_MAGIA, 3, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, LDR_MAGIA_FEC, 2, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, LDR_MAGIA_SINC, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, 0xFFFFFFFFu),
+        // A = id_sensor % n
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, LDR_OFFSET_ID_SENSOR),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, n),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+    sock_fprog prog{static_cast<unsigned short>(sizeof(programa) / sizeof(programa[0])), programa};
+    if (setsockopt(sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0) {
+        return -errno;
+    }
+    return 0;
+}
+
+/**
+ * @class TrabalhadorNucleo
+ * @brief Um trabalhador: socket, armazém e laço de recepção próprios, fixado em um núcleo.
+ */
+class TrabalhadorNucleo {
+private:
+    /**< Índice do trabalhador (também o índice do socket no grupo SO_REUSEPORT). */
+    unsigned indice;
+
+    /**< Núcleo em que o thread é fixado (-1 = sem afinidade). */
+    int nucleo;
+
+    /**< Socket próprio. */
+    int sock;
+
+    /**< Arquivo de amostras próprio. */
+    std::unique_ptr<ArmazemAmostras> armazem;
+
+    /**< Diário de escrita antecipada próprio (opcional). */
+    std::unique_ptr<DiarioAmostras> diario;
+
+    /**< Amostras recentes dos sensores atendidos por este trabalhador. */
+    SeriesAmostras series;
+
+    /**< Alertas dos sensores atendidos por este trabalhador. */
+    MotorAlertas alertas;
+
+    /**< Laço de recepção escolhido e o laço epoll de reserva (criado se o io_uring falhar). */
+    std::unique_ptr<BackendRecepcao> primario;
+    std::unique_ptr<BackendRecepcao> reserva;
+
+    /**< Laço em uso, consultado por outros threads. */
+    std::atomic<BackendRecepcao*> atual{nullptr};
+
+    /**< Término solicitado (impede que o laço de reserva inicie depois de parar()). */
+    std::atomic<bool> parando{false};
+
+    /**< Thread do laço. */
+    std::thread thread;
+
+    static std::unique_ptr<BackendRecepcao> criarBackend(const std::string& nome, int sock, ArmazemAmostras* armazem) {
+        if (nome == "epoll") {
+            return std::make_unique<BackendEpoll>(sock, armazem, PERIODO_TEMPORIZADOR_NS);
+        }
+        return std::make_unique<BackendUring>(sock, armazem, PERIODO_TEMPORIZADOR_NS);
+    }
+
+    void executar(std::string nomeBackend) {
+        if (nucleo >= 0) {
+            cpu_set_t conjunto;
+            CPU_ZERO(&conjunto);
+            CPU_SET(nucleo, &conjunto);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(conjunto), &conjunto) != 0) {
+                LOG_AVISO("Nao foi possivel fixar o trabalhador no nucleo", campo("trabalhador", indice),
+                          campo("nucleo", nucleo));
+            }
+        }
+        int r = primario->executar();
+        if (r < 0 && nomeBackend != "epoll") {
+            errno = -r;
+            LOG_AVISO("Backend io_uring indisponivel; usando epoll", campo("trabalhador", indice), campoErrno());
+            atual.store(reserva.get(), std::memory_order_release);
+            r = parando.load() ? 0 : reserva->executar();
+        }
+        if (r < 0) {
+            errno = -r;
+            LOG_ERRO("Erro no laco de recepcao", campo("trabalhador", indice), campoErrno());
+        }
+    }
+
+public:
+    /**
+     * @brief Construtor.
+     * @param indiceTrabalhador Índice do trabalhador.
+     * @param nucleoCpu Núcleo de afinidade (-1 = sem afinidade).
+     * @param socketUdp Socket SO_REUSEPORT já associado.
+     * @param armazemAmostras Arquivo de amostras do trabalhador.
+     * @param diarioAmostras Diário do trabalhador, já aberto (ou nullptr).
+     * @param nomeBackend "uring" ou "epoll".
+     * @param regras Regras de alerta.
+     * @param assinante Chamado, no thread do trabalhador, a cada transição de alerta (pode ser vazio).
+     * @param difusao Anel de difusão compartilhado entre os trabalhadores (ou nullptr).
+     * @param anelCompartilhado Anel em memória compartilhada (ou nullptr).
+     * @param gro Recepção agregada (UDP_GRO); com ela, o io_uring recusa e o laço epoll assume.
+     */
+    TrabalhadorNucleo(unsigned indiceTrabalhador, int nucleoCpu, int socketUdp,
+                      std::unique_ptr<ArmazemAmostras> armazemAmostras,
+                      std::unique_ptr<DiarioAmostras> diarioAmostras, const std::string& nomeBackend,
+                      const std::vector<RegraAlerta>& regras, const MotorAlertas::Assinante& assinante,
+                      AnelDifusao* difusao, AnelCompartilhado* anelCompartilhado, bool gro)
+        : indice(indiceTrabalhador), nucleo(nucleoCpu), sock(socketUdp), armazem(std::move(armazemAmostras)),
+          diario(std::move(diarioAmostras)) {
+        for (const RegraAlerta& r : regras) {
+            alertas.adicionarRegra(r);
+        }
+        if (assinante) {
+            alertas.assinar(assinante);
+        }
+        // As transições também vão aos assinantes da difusão, sem passar pelo log.
+        if (difusao != nullptr) {
+            alertas.assinar([difusao](const EventoAlerta& e) {
+                difusao->publicar([&](char* destino, size_t capacidade) {
+                    return codificarAlerta(destino, capacidade, e.id_sensor, e.ativo, e.valor, e.t_ns,
+                                           e.regra->nome.c_str());
+                });
+            });
+        }
+        primario = criarBackend(nomeBackend, sock, armazem.get());
+        reserva = criarBackend("epoll", sock, armazem.get());
+        primario->definirDiario(diario.get());
+        reserva->definirDiario(diario.get());
+        primario->definirSeries(&series);
+        reserva->definirSeries(&series);
+        primario->definirAlertas(&alertas);
+        reserva->definirAlertas(&alertas);
+        primario->definirDifusao(difusao);
+        reserva->definirDifusao(difusao);
+        primario->definirAnelCompartilhado(anelCompartilhado);
+        reserva->definirAnelCompartilhado(anelCompartilhado);
+        primario->definirGro(gro);
+        reserva->definirGro(gro);
+        atual.store(primario.get(), std::memory_order_release);
+        thread = std::thread(&TrabalhadorNucleo::executar, this, nomeBackend);
+    }
+
+    ~TrabalhadorNucleo() {
+        parar();
+        if (thread.joinable()) {
+            thread.join();
+        }
+        close(sock);
+    }
+
+    /** @brief Solicita o término do laço. */
+    void parar() {
+        parando.store(true);
+        primario->parar();
+        reserva->parar();
+    }
+
+    /** @brief Laço de recepção em uso (contadores e tabela de sensores). */
+    const BackendRecepcao& laco() const { return *atual.load(std::memory_order_acquire); }
+
+    /** @brief Diário do trabalhador (ou nullptr). */
+    const DiarioAmostras* diarioAmostras() const { return diario.get(); }
+
+    /** @brief Arquivo de amostras do trabalhador. */
+    const ArmazemAmostras& armazemAmostras() const { return *armazem; }
+};
+
+/**
+ * @brief Resultado agregado de todos os trabalhadores, calculado no momento da consulta.
+ */
+struct ResumoColetor {
+    uint64_t datagramas = 0; /**< Datagramas recebidos. */
+    uint64_t amostras = 0;   /**< Amostras decodificadas. */
+    uint64_t invalidos = 0;  /**< Datagramas inválidos. */
+    uint64_t naoArmazenadas = 0; /**< Amostras descartadas com os dois buffers do arquivo ocupados. */
+    uint64_t sensores = 0;   /**< Sensores distintos (somados entre núcleos). */
+    uint64_t foraDeOrdem = 0; /**< Amostras recebidas fora de ordem. */
+    uint64_t assinantes = 0;  /**< Assinantes conectados ao socket de difusão. */
+    uint64_t sincronizacoes = 0; /**< Commits (fdatasync) dos diários. */
+    uint64_t naoDuraveis = 0;    /**< Registros anexados aos diários e ainda não sincronizados. */
+    uint64_t duplicados = 0;     /**< Retransmissões do modo confiável descartadas por já terem chegado. */
+    uint64_t confirmacoes = 0;   /**< Confirmações seletivas enviadas aos remetentes. */
+    uint64_t recuperados = 0;    /**< Datagramas perdidos reconstruídos pelos reparos FEC. */
+    uint64_t agregados = 0;      /**< Leituras com mais de um datagrama (UDP_GRO). */
+    uint64_t origens = 0;        /**< Remetentes distintos (somados entre núcleos). */
+    uint64_t lotesRecebidos = 0; /**< Lotes comprimidos recebidos de gateways. */
+    uint64_t lotesEnviados = 0;  /**< Lotes repassados ao coletor central (modo gateway). */
+    uint64_t encaminhadas = 0;   /**< Amostras repassadas ao coletor central. */
+    uint64_t bytesOriginais = 0; /**< Bytes dos datagramas das placas repassados. */
+    uint64_t bytesLotes = 0;     /**< Bytes dos lotes repassados. */
+    uint64_t placasSincronizadas = 0; /**< Sensores com o relógio estimado (instantes corrigidos). */
+    int64_t piorIncertezaNs = 0;      /**< Maior incerteza da correção entre esses sensores. */
+};
+
+/**
+ * @class ColetorMultinucleo
+ * @brief Conjunto de trabalhadores que dividem a recepção de um mesmo endereço UDP.
+ */
+class ColetorMultinucleo {
+private:
+    /**< Trabalhadores, na ordem de bind dos sockets. */
+    std::vector<std::unique_ptr<TrabalhadorNucleo>> trabalhadores;
+
+    /**< Regras de alerta e assinante repassados a cada trabalhador. */
+    std::vector<RegraAlerta> regrasAlerta;
+    MotorAlertas::Assinante assinanteAlertas;
+
+    /**< Anel de difusão do fluxo decodificado e o seu repasse por socket Unix (opcionais). */
+    std::unique_ptr<AnelDifusao> difusao;
+    std::unique_ptr<ServidorDifusao> servidorDifusao;
+    std::string caminhoDifusao;
+
+    /**< Anel de amostras em memória compartilhada (opcional). */
+    std::unique_ptr<AnelCompartilhado> anelCompartilhado;
+    std::string nomeAnelCompartilhado;
+
+    /**< Prefixo e parâmetros dos diários de escrita antecipada ("" = sem diário). */
+    std::string prefixoDiario;
+    ConfiguracaoDiario configuracaoDiario;
+
+    /**< Recepção agregada (UDP_GRO) nos laços. */
+    bool gro = false;
+
+    /**< Grupo multicast ("" = só unicast) e interface por onde entrar nele. */
+    std::string grupoMulticast;
+    std::string interfaceMulticast;
+
+    /**< Repasse ao coletor central (modo gateway) e o seu destino ("" = desabilitado). */
+    std::unique_ptr<GatewayLotes> gateway;
+    std::string ipCentral;
+    int portaCentral = 0;
+    uint32_t janelaGatewayMs = GATEWAY_JANELA_PADRAO_MS;
+    uint32_t idGateway = 0;
+
+public:
+    /**
+     * @brief Habilita o diário de escrita antecipada (antes de iniciar()).
+     * @param prefixo Prefixo dos segmentos; com mais de um trabalhador recebe o sufixo `.<i>`.
+     */
+    void habilitarDiario(const std::string& prefixo, const ConfiguracaoDiario& configuracao) {
+        prefixoDiario = prefixo;
+        configuracaoDiario = configuracao;
+    }
+
+    /**
+     * @brief Habilita a recepção agregada (UDP_GRO) em todos os laços (antes de iniciar()).
+     * @details Vale só no backend epoll; com `uring`, os trabalhadores passam ao epoll.
+     */
+    void habilitarGro() {
+        gro = true;
+    }
+
+    /**
+     * @brief Recebe também o grupo multicast @p grupo, pela interface @p interfaceIp (antes de iniciar()).
+     * @details O grupo é atendido pelo primeiro trabalhador; o unicast continua distribuído.
+     */
+    void habilitarMulticast(const std::string& grupo, const std::string& interfaceIp) {
+        grupoMulticast = grupo;
+        interfaceMulticast = interfaceIp;
+    }
+
+    /**
+     * @brief Habilita o modo gateway (antes de iniciar()): as amostras recebidas são repassadas a
+     * @p ip:@p porta em lotes comprimidos, uma janela de @p janelaMs por vez.
+     * @details Usa o anel de difusão, criado aqui se `-u` não o habilitou.
+     */
+    void habilitarGateway(const std::string& ip, int porta, uint32_t janelaMs, uint32_t id) {
+        ipCentral = ip;
+        portaCentral = porta;
+        janelaGatewayMs = janelaMs;
+        idGateway = id;
+        if (difusao == nullptr) {
+            difusao = std::make_unique<AnelDifusao>();
+        }
+    }
+
+    /**
+     * @brief Habilita o anel de amostras em memória compartilhada `/dev/shm/<nome>` (antes de iniciar()).
+     */
+    void habilitarAnelCompartilhado(const std::string& nome) {
+        nomeAnelCompartilhado = nome;
+    }
+
+    /**
+     * @brief Habilita a difusão do fluxo decodificado (antes de iniciar()).
+     * @param caminhoSocket Socket Unix de repasse aos assinantes externos ("" = só no processo).
+     * @return O anel, para assinantes no próprio processo.
+     */
+    AnelDifusao& habilitarDifusao(const std::string& caminhoSocket) {
+        if (difusao == nullptr) {
+            difusao = std::make_unique<AnelDifusao>();
+        }
+        caminhoDifusao = caminhoSocket;
+        return *difusao;
+    }
+
+    /**
+     * @brief Define as regras de alerta de todos os trabalhadores (antes de iniciar()).
+     * @param assinante Chamado a cada transição, no thread do trabalhador que a detectou.
+     */
+    void definirAlertas(std::vector<RegraAlerta> regras, MotorAlertas::Assinante assinante) {
+        regrasAlerta = std::move(regras);
+        assinanteAlertas = std::move(assinante);
+    }
+
+    /**
+     * @brief Abre os sockets e arquivos e inicia os trabalhadores.
+     *
+     * @param ip Endereço de escuta.
+     * @param porta Porta UDP.
+     * @param n Número de trabalhadores.
+     * @param arquivo Arquivo de amostras; com mais de um trabalhador recebe o sufixo `.<i>`.
+     * @param nomeBackend "uring" ou "epoll".
+     * @param porSensor Habilita o direcionamento BPF por id_sensor.
+     * @return true se todos os trabalhadores foram iniciados.
+     */
+    bool iniciar(const std::string& ip, int porta, unsigned n, const std::string& arquivo,
+                 const std::string& nomeBackend, bool porSensor) {
+        if (difusao != nullptr) {
+            if (!difusao->valido()) {
+                LOG_ERRO("Erro ao reservar o anel de difusao", campoErrno());
+                return false;
+            }
+            if (!caminhoDifusao.empty()) {
+                servidorDifusao = std::make_unique<ServidorDifusao>(*difusao);
+                int r = servidorDifusao->iniciar(caminhoDifusao);
+                if (r < 0) {
+                    errno = -r;
+                    LOG_ERRO("Erro ao criar o socket de difusao", campoErrno(), campo("socket", caminhoDifusao));
+                    return false;
+                }
+            }
+        }
+        if (!nomeAnelCompartilhado.empty()) {
+            anelCompartilhado = std::make_unique<AnelCompartilhado>();
+            int r = anelCompartilhado->criar(nomeAnelCompartilhado);
+            if (r < 0) {
+                errno = -r;
+                LOG_ERRO("Erro ao criar o anel compartilhado", campoErrno(), campo("nome", nomeAnelCompartilhado));
+                return false;
+            }
+        }
+        // O gateway assina o anel antes do primeiro laço publicar.
+        if (!ipCentral.empty()) {
+            gateway = std::make_unique<GatewayLotes>(*difusao);
+            int r = gateway->iniciar(ipCentral, portaCentral, janelaGatewayMs, idGateway);
+            if (r < 0) {
+                errno = -r;
+                LOG_ERRO("Erro ao conectar ao coletor central", campoErrno(), campo("ip", ipCentral),
+                         campo("porta", portaCentral));
+                gateway.reset();
+                return false;
+            }
+        }
+        long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+        // Todos os sockets do grupo são criados antes do primeiro laço iniciar, para que o
+        // programa BPF já encontre o grupo completo.
+        std::vector<int> socks;
+        for (unsigned i = 0; i < n; i++) {
+            int sock = criarSocketReusePort(ip.c_str(), porta);
+            if (sock < 0) {
+                for (int s : socks) close(s);
+                return false;
+            }
+            socks.push_back(sock);
+        }
+        if (!grupoMulticast.empty()) {
+            for (int sock : socks) {
+                restringirMulticast(sock);
+            }
+            int r = entrarGrupoMulticast(socks[0], grupoMulticast.c_str(), interfaceMulticast.c_str());
+            if (r < 0) {
+                errno = -r;
+                LOG_ERRO("Erro ao entrar no grupo multicast", campoErrno(), campo("grupo", grupoMulticast),
+                         campo("interface", interfaceMulticast));
+                for (int s : socks) close(s);
+                return false;
+            }
+        }
+        if (porSensor && n > 1) {
+            int r = anexarDirecionamentoPorSensor(socks[0], n);
+            if (r < 0) {
+                errno = -r;
+                LOG_AVISO("Direcionamento BPF por sensor indisponivel; usando o hash do kernel", campoErrno());
+            }
+        }
+        for (unsigned i = 0; i < n; i++) {
+            std::unique_ptr<ArmazemAmostras> armazem = std::make_unique<ArmazemAmostras>();
+            std::string caminho = n > 1 ? arquivo + "." + std::to_string(i) : arquivo;
+            if (!armazem->abrir(caminho)) {
+                LOG_ERRO("Erro ao abrir o arquivo de amostras", campoErrno(), campo("arquivo", caminho));
+                for (unsigned j = i; j < n; j++) close(socks[j]);
+                return false;
+            }
+            std::unique_ptr<DiarioAmostras> diario;
+            if (!prefixoDiario.empty()) {
+                diario = std::make_unique<DiarioAmostras>();
+                std::string prefixo = n > 1 ? prefixoDiario + "." + std::to_string(i) : prefixoDiario;
+                int r = diario->abrir(prefixo, configuracaoDiario);
+                if (r < 0) {
+                    errno = -r;
+                    LOG_ERRO("Erro ao abrir o diario", campoErrno(), campo("prefixo", prefixo));
+                    for (unsigned j = i; j < n; j++) close(socks[j]);
+                    return false;
+                }
+                LOG_INFO("Diario aberto", campo("prefixo", prefixo), campo("segmento", diario->segmentoAtual()),
+                         campo("lsn", diario->lsnDuravel()), campo("recuperados", diario->registrosRecuperados()),
+                         campo("bytes_descartados", diario->bytesDescartados()));
+            }
+            int nucleo = nucleos > 0 ? static_cast<int>(i % static_cast<unsigned>(nucleos)) : -1;
+            trabalhadores.push_back(std::make_unique<TrabalhadorNucleo>(i, nucleo, socks[i], std::move(armazem),
+                                                                         std::move(diario), nomeBackend, regrasAlerta,
+                                                                         assinanteAlertas, difusao.get(),
+                                                                         anelCompartilhado.get(), gro));
+        }
+        return true;
+    }
+
+    /** @brief Solicita o término de todos os laços. */
+    void parar() {
+        for (auto& t : trabalhadores) {
+            t->parar();
+        }
+    }
+
+    /** @brief Aguarda o término e libera os trabalhadores. */
+    void encerrar() {
+        trabalhadores.clear();
+        gateway.reset(); // depois dos trabalhadores: a última janela leva tudo o que eles publicaram
+        servidorDifusao.reset();
+        anelCompartilhado.reset();
+    }
+
+    /** @brief Número de trabalhadores. */
+    size_t tamanho() const { return trabalhadores.size(); }
+
+    /** @brief Laço do trabalhador @p i. */
+    const BackendRecepcao& laco(size_t i) const { return trabalhadores[i]->laco(); }
+
+    /**
+     * @brief Agrega os contadores e as tabelas de sensores de todos os trabalhadores.
+     */
+    ResumoColetor consultar() const {
+        ResumoColetor r;
+        for (const auto& t : trabalhadores) {
+            const EstatisticasRecepcao& e = t->laco().estatisticas();
+            r.datagramas += e.datagramas.load(std::memory_order_relaxed);
+            r.amostras += e.amostras.load(std::memory_order_relaxed);
+            r.invalidos += e.invalidos.load(std::memory_order_relaxed);
+            r.naoArmazenadas += t->armazemAmostras().amostrasDescartadas();
+            r.duplicados += e.duplicados.load(std::memory_order_relaxed);
+            r.agregados += e.agregados.load(std::memory_order_relaxed);
+            r.lotesRecebidos += e.lotesGateway.load(std::memory_order_relaxed);
+            r.confirmacoes += t->laco().rastreadorConfirmacoes().confirmacoesEnviadas();
+            r.recuperados += t->laco().recuperadorFec().datagramasRecuperados();
+            t->laco().tabelaSensores().paraCada([&](const ResumoSensor& s) {
+                r.sensores++;
+                r.foraDeOrdem += s.foraDeOrdem.load(std::memory_order_relaxed);
+                if (s.trocasRelogio.load(std::memory_order_relaxed) > 0) {
+                    r.placasSincronizadas++;
+                    r.piorIncertezaNs = std::max(r.piorIncertezaNs, s.incertezaNs.load(std::memory_order_relaxed));
+                }
+            });
+            t->laco().tabelaOrigens().paraCada([&](const ResumoOrigem&) { r.origens++; });
+            if (const DiarioAmostras* d = t->diarioAmostras()) {
+                r.sincronizacoes += d->sincronizacoes();
+                r.naoDuraveis += d->lsnAnexado() - d->lsnDuravel();
+            }
+        }
+        if (servidorDifusao != nullptr) {
+            r.assinantes = servidorDifusao->assinantes();
+        }
+        if (gateway != nullptr) {
+            r.lotesEnviados = gateway->lotesEnviados();
+            r.encaminhadas = gateway->amostrasEnviadas();
+            r.bytesOriginais = gateway->bytesRecebidos();
+            r.bytesLotes = gateway->bytesEnviados();
+        }
+        return r;
+    }
+};
+
+#endif // COLETOR_MULTINUCLEO_HPP
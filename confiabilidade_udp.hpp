@@ -0,0 +1,395 @@
+/**
+ * @file confiabilidade_udp.hpp
+ * @brief Entrega confiável opcional sobre UDP: confirmação seletiva e retransmissão.
+ *
+ * @details O caminho normal continua sem ida e volta: o remetente envia os datagramas como
+ * sempre, apenas com a flag LDR_FLAG_CONFIAVEL, e guarda uma cópia de cada um em uma janela de
+ * retransmissão (JanelaRetransmissao). O coletor marca as sequências recebidas de cada sensor em
+ * um mapa de bits (RastreadorConfirmacoes) e, a cada disparo do temporizador do laço, devolve a
+ * cada remetente com novidades um único datagrama de confirmação: a base (todas as sequências
+ * anteriores foram recebidas) e o mapa das 1024 sequências seguintes.
+ *
+ * O remetente libera os datagramas confirmados e retransmite somente os que faltam: de imediato
+ * quando uma sequência posterior já foi confirmada (lacuna), ou quando o datagrama fica sem
+ * confirmação por mais que o tempo de retransmissão. Retransmissões que chegam em duplicata ao
+ * coletor são reconhecidas pelo mapa e descartadas antes da entrega. O remetente não se adianta
+ * mais que o mapa (CONFIABILIDADE_SEQUENCIAS) ao datagrama não confirmado mais antigo de cada
+ * sensor; com o spool, as amostras seguintes esperam nele.
+ */
+
+#ifndef CONFIABILIDADE_UDP_HPP
+#define CONFIABILIDADE_UDP_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "protocolo_ldr.hpp"
+
+/** @def CONFIABILIDADE_JANELA
+ * @brief Datagramas guardados pelo remetente à espera de confirmação.
+ */
+#define CONFIABILIDADE_JANELA 64
+
+/** @def CONFIABILIDADE_SEQUENCIAS
+ * @brief Sequências cobertas pelo mapa de confirmação após a base.
+ */
+#define CONFIABILIDADE_SEQUENCIAS (LDR_ACK_PALAVRAS * 64)
+
+/** @def CONFIABILIDADE_TAMANHO_DATAGRAMA
+ * @brief Maior datagrama binário guardado na janela de retransmissão.
+ */
+#define CONFIABILIDADE_TAMANHO_DATAGRAMA (sizeof(CabecalhoLDR) + LDR_MAX_AMOSTRAS_DATAGRAMA * sizeof(AmostraWireLDR))
+
+/**
+ * @class RastreadorConfirmacoes
+ * @brief Lado do coletor: sequências recebidas por sensor e envio periódico das confirmações.
+ *
+ * @details Acessado apenas pelo thread do laço de recepção. A tabela só aloca ao conhecer um
+ * sensor novo. O rastreamento começa na sequência do primeiro datagrama recebido do sensor
+ * (inicio, informado nas confirmações); se datagramas anteriores, perdidos, chegarem depois por
+ * retransmissão, o início recua para incluí-los.
+ */
+class RastreadorConfirmacoes {
+private:
+    /** @brief Estado de um sensor em modo confiável. */
+    struct Sensor {
+        uint32_t id;                         /**< Sensor. */
+        uint32_t inicio;                     /**< Menor sequência rastreada. */
+        uint32_t base;                       /**< Primeira sequência ainda não recebida. */
+        uint64_t mapa[LDR_ACK_PALAVRAS];     /**< Bit i: sequência base + i recebida. */
+        sockaddr_in origem;                  /**< Endereço para onde as confirmações são enviadas. */
+        bool pendente;                       /**< Recebeu datagramas desde a última confirmação. */
+    };
+
+    /**< Sensores, na ordem em que apareceram, e índice por identificador. */
+    std::vector<Sensor> sensores;
+    std::unordered_map<uint32_t, uint32_t> indices;
+
+    /**< Contadores (lidos por outros threads). */
+    std::atomic<uint64_t> enviadas{0};
+    std::atomic<uint64_t> abandonadas{0};
+
+    /** @brief Avança a base de @p s em @p k sequências, deslocando o mapa. */
+    static void deslocar(Sensor& s, uint32_t k) {
+        s.base += k;
+        if (k >= CONFIABILIDADE_SEQUENCIAS) {
+            memset(s.mapa, 0, sizeof(s.mapa));
+            return;
+        }
+        uint32_t q = k / 64;
+        uint32_t r = k % 64;
+        for (uint32_t w = 0; w < LDR_ACK_PALAVRAS; w++) {
+            uint64_t baixo = w + q < LDR_ACK_PALAVRAS ? s.mapa[w + q] : 0;
+            uint64_t alto = w + q + 1 < LDR_ACK_PALAVRAS ? s.mapa[w + q + 1] : 0;
+            s.mapa[w] = r == 0 ? baixo : (baixo >> r) | (alto << (64 - r));
+        }
+    }
+
+    /** @brief Recua a base de @p s em @p k sequências (k < CONFIABILIDADE_SEQUENCIAS), deslocando o mapa. */
+    static void recuar(Sensor& s, uint32_t k) {
+        s.base -= k;
+        uint32_t q = k / 64;
+        uint32_t r = k % 64;
+        for (uint32_t w = LDR_ACK_PALAVRAS; w-- > 0;) {
+            uint64_t alto = w >= q ? s.mapa[w - q] : 0;
+            uint64_t baixo = w >= q + 1 ? s.mapa[w - q - 1] : 0;
+            s.mapa[w] = r == 0 ? alto : (alto << r) | (baixo >> (64 - r));
+        }
+    }
+
+    /** @brief Posição do bit mais alto do mapa mais um (0 se vazio). */
+    static uint32_t extensao(const Sensor& s) {
+        for (uint32_t w = LDR_ACK_PALAVRAS; w-- > 0;) {
+            if (s.mapa[w] != 0) {
+                return 64 * w + 64 - static_cast<uint32_t>(__builtin_clzll(s.mapa[w]));
+            }
+        }
+        return 0;
+    }
+
+    /** @brief Número de sequências recebidas em sequência a partir da base. */
+    static uint32_t prefixoRecebido(const Sensor& s) {
+        uint32_t total = 0;
+        for (uint32_t w = 0; w < LDR_ACK_PALAVRAS; w++) {
+            if (s.mapa[w] != ~0ull) {
+                return total + static_cast<uint32_t>(__builtin_ctzll(~s.mapa[w]));
+            }
+            total += 64;
+        }
+        return total;
+    }
+
+public:
+    /**
+     * @brief Registra um datagrama confiável recebido.
+     * @param origem Endereço do remetente (nulo se desconhecido: as confirmações vão ao último conhecido).
+     * @return false se todas as sequências do datagrama já haviam sido recebidas (duplicata).
+     */
+    bool registrar(uint32_t id, uint32_t seq, uint32_t n, const sockaddr_in* origem) {
+        auto it = indices.find(id);
+        if (it == indices.end()) {
+            Sensor novo{};
+            novo.id = id;
+            novo.inicio = seq;
+            novo.base = seq;
+            it = indices.emplace(id, static_cast<uint32_t>(sensores.size())).first;
+            sensores.push_back(novo);
+        }
+        Sensor& s = sensores[it->second];
+        if (static_cast<int32_t>(seq - s.base) < -static_cast<int32_t>(CONFIABILIDADE_SEQUENCIAS)) {
+            // Muito antes da base: o remetente recomeçou a numeração; recomeça também o mapa.
+            s.inicio = seq;
+            s.base = seq;
+            memset(s.mapa, 0, sizeof(s.mapa));
+        } else if (static_cast<int32_t>(seq - s.inicio) < 0) {
+            // Anterior ao início do rastreamento: nunca foi recebida. O início recua até ela; se o
+            // mapa não comporta o recuo, as sequências intermediárias ficam dadas como recebidas.
+            uint32_t recuo = s.base - seq;
+            s.inicio = seq;
+            if (recuo + extensao(s) > CONFIABILIDADE_SEQUENCIAS) {
+                s.pendente = true;
+                return true;
+            }
+            recuar(s, recuo);
+        }
+        if (origem != nullptr) {
+            memcpy(&s.origem, origem, sizeof(s.origem));
+        }
+        s.pendente = true;
+        bool novo = false;
+        for (uint32_t k = 0; k < n; k++) {
+            int32_t d = static_cast<int32_t>(seq + k - s.base);
+            if (d < 0) {
+                continue; // anterior à base: já recebida
+            }
+            if (d >= static_cast<int32_t>(CONFIABILIDADE_SEQUENCIAS)) {
+                // Fora do mapa: as lacunas mais antigas são abandonadas para dar lugar à nova sequência.
+                uint32_t avanco = static_cast<uint32_t>(d) - CONFIABILIDADE_SEQUENCIAS + 1;
+                uint64_t faltantes = avanco > CONFIABILIDADE_SEQUENCIAS ? avanco - CONFIABILIDADE_SEQUENCIAS : 0;
+                for (uint32_t i = 0; i < avanco && i < CONFIABILIDADE_SEQUENCIAS; i++) {
+                    faltantes += !(s.mapa[i / 64] >> (i % 64) & 1);
+                }
+                abandonadas.store(abandonadas.load(std::memory_order_relaxed) + faltantes,
+                                  std::memory_order_relaxed);
+                deslocar(s, avanco);
+                d = CONFIABILIDADE_SEQUENCIAS - 1;
+            }
+            uint64_t bit = 1ull << (d % 64);
+            if (!(s.mapa[d / 64] & bit)) {
+                s.mapa[d / 64] |= bit;
+                novo = true;
+            }
+        }
+        uint32_t prefixo = prefixoRecebido(s);
+        if (prefixo > 0) {
+            deslocar(s, prefixo);
+        }
+        return novo;
+    }
+
+    /**
+     * @brief Envia uma confirmação a cada sensor com datagramas recebidos desde a última chamada.
+     * @details Chamado no disparo do temporizador do laço; o envio não bloqueia (uma confirmação
+     * perdida é substituída pela seguinte, que a cobre).
+     */
+    void enviar(int sock) {
+        char datagrama[sizeof(CabecalhoAckLDR) + LDR_ACK_PALAVRAS * sizeof(uint64_t)];
+        for (Sensor& s : sensores) {
+            if (!s.pendente) {
+                continue;
+            }
+            s.pendente = false;
+            size_t palavras = LDR_ACK_PALAVRAS;
+            while (palavras > 0 && s.mapa[palavras - 1] == 0) {
+                palavras--;
+            }
+            size_t tamanho = codificarAck(datagrama, sizeof(datagrama), s.id, s.inicio, s.base, s.mapa, palavras);
+            if (s.origem.sin_family == AF_INET &&
+                sendto(sock, datagrama, tamanho, MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&s.origem),
+                       sizeof(s.origem)) >= 0) {
+                enviadas.store(enviadas.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** @brief Confirmações enviadas. */
+    uint64_t confirmacoesEnviadas() const { return enviadas.load(std::memory_order_relaxed); }
+
+    /** @brief Sequências abandonadas sem recepção (remetente adiantado mais que o mapa). */
+    uint64_t sequenciasAbandonadas() const { return abandonadas.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @class JanelaRetransmissao
+ * @brief Lado do remetente: cópias dos datagramas confiáveis ainda não confirmados.
+ *
+ * @details Janela fixa de CONFIABILIDADE_JANELA entradas, sem alocação. O remetente consulta
+ * podeEnviar() antes de cada datagrama novo; se guardar mesmo com a janela cheia, o datagrama
+ * mais antigo é abandonado (contado) para dar lugar ao novo.
+ */
+class JanelaRetransmissao {
+private:
+    /** @brief Um datagrama à espera de confirmação. */
+    struct Entrada {
+        bool ocupada;         /**< Entrada em uso. */
+        uint32_t id_sensor;   /**< Sensor do datagrama. */
+        uint32_t seq;         /**< Primeira sequência. */
+        uint32_t n;           /**< Número de amostras. */
+        uint64_t enviadoNs;   /**< Último envio (CLOCK_MONOTONIC). */
+        uint32_t tamanho;     /**< Bytes em dados. */
+        char dados[CONFIABILIDADE_TAMANHO_DATAGRAMA];
+    };
+
+    Entrada entradas[CONFIABILIDADE_JANELA] = {};
+
+    /**< Tempo sem confirmação após o qual o datagrama é retransmitido. */
+    uint64_t rtoNs;
+
+    /**< Contadores. */
+    uint64_t ocupadas = 0;
+    uint64_t confirmados = 0;
+    uint64_t retransmitidos = 0;
+    uint64_t abandonados = 0;
+
+public:
+    /**
+     * @brief Construtor.
+     * @param tempoRetransmissaoNs Tempo sem confirmação antes de retransmitir (deve superar o
+     * período das confirmações do coletor mais a ida e volta).
+     */
+    explicit JanelaRetransmissao(uint64_t tempoRetransmissaoNs = 1000000000ull) : rtoNs(tempoRetransmissaoNs) {}
+
+    /**
+     * @brief Indica se um datagrama novo do sensor @p id_sensor, terminado na sequência
+     * @p seqFinal, cabe na janela e no mapa de confirmação do coletor.
+     */
+    bool podeEnviar(uint32_t id_sensor, uint32_t seqFinal) const {
+        if (ocupadas >= CONFIABILIDADE_JANELA) {
+            return false;
+        }
+        for (const Entrada& e : entradas) {
+            if (e.ocupada && e.id_sensor == id_sensor &&
+                static_cast<int32_t>(seqFinal - e.seq) >= static_cast<int32_t>(CONFIABILIDADE_SEQUENCIAS)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Guarda uma cópia de um datagrama confiável recém-enviado.
+     */
+    void guardar(const char* datagrama, size_t tamanho, uint32_t id_sensor, uint32_t seq, uint32_t n,
+                 uint64_t agoraNs) {
+        if (tamanho > CONFIABILIDADE_TAMANHO_DATAGRAMA) {
+            return;
+        }
+        Entrada* destino = nullptr;
+        for (Entrada& e : entradas) {
+            if (!e.ocupada) {
+                destino = &e;
+                break;
+            }
+            if (destino == nullptr || e.enviadoNs < destino->enviadoNs) {
+                destino = &e;
+            }
+        }
+        if (destino->ocupada) {
+            abandonados++;
+            ocupadas--;
+        }
+        destino->ocupada = true;
+        destino->id_sensor = id_sensor;
+        destino->seq = seq;
+        destino->n = n;
+        destino->enviadoNs = agoraNs;
+        destino->tamanho = static_cast<uint32_t>(tamanho);
+        memcpy(destino->dados, datagrama, tamanho);
+        ocupadas++;
+    }
+
+    /**
+     * @brief Processa uma confirmação recebida do coletor.
+     * @details Libera os datagramas confirmados e antecipa a retransmissão dos que ficaram antes
+     * da maior sequência confirmada (lacunas), desde que não tenham sido enviados há pouco.
+     * @return false se o datagrama não é uma confirmação.
+     */
+    bool processarAck(const char* dados, size_t tamanho, uint64_t agoraNs) {
+        uint32_t id, inicio, base;
+        uint64_t mapa[LDR_ACK_PALAVRAS];
+        if (!decodificarAck(dados, tamanho, id, inicio, base, mapa)) {
+            return false;
+        }
+        // Maior sequência confirmada: base - 1, ou o bit mais alto do mapa.
+        uint32_t maior = base - 1;
+        for (int w = LDR_ACK_PALAVRAS - 1; w >= 0; w--) {
+            if (mapa[w] != 0) {
+                maior = base + static_cast<uint32_t>(64 * w + 63 - __builtin_clzll(mapa[w]));
+                break;
+            }
+        }
+        for (Entrada& e : entradas) {
+            if (!e.ocupada || e.id_sensor != id) {
+                continue;
+            }
+            // Antes da base (e a partir do início) ou com o bit marcado: recebida.
+            bool confirmado = true;
+            for (uint32_t k = 0; k < e.n && confirmado; k++) {
+                int32_t d = static_cast<int32_t>(e.seq + k - base);
+                confirmado = d < 0 ? static_cast<int32_t>(e.seq + k - inicio) >= 0
+                                   : d < static_cast<int32_t>(CONFIABILIDADE_SEQUENCIAS) &&
+                                         (mapa[d / 64] >> (d % 64) & 1);
+            }
+            if (confirmado) {
+                e.ocupada = false;
+                ocupadas--;
+                confirmados++;
+            } else if (static_cast<int32_t>(e.seq + e.n - 1 - maior) < 0 && agoraNs - e.enviadoNs >= rtoNs / 4) {
+                e.enviadoNs = agoraNs - rtoNs; // lacuna: retransmitir já
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Retransmite os datagramas vencidos.
+     * @param enviar Função `bool(const char* dados, size_t tamanho)`; false interrompe a rodada.
+     * @return Datagramas retransmitidos.
+     */
+    template <typename Funcao>
+    uint32_t retransmitir(uint64_t agoraNs, Funcao&& enviar) {
+        uint32_t total = 0;
+        for (Entrada& e : entradas) {
+            if (!e.ocupada || agoraNs - e.enviadoNs < rtoNs) {
+                continue;
+            }
+            if (!enviar(e.dados, e.tamanho)) {
+                break;
+            }
+            e.enviadoNs = agoraNs;
+            retransmitidos++;
+            total++;
+        }
+        return total;
+    }
+
+    /** @brief Datagramas à espera de confirmação. */
+    uint64_t pendentes() const { return ocupadas; }
+
+    /** @brief Datagramas confirmados. */
+    uint64_t datagramasConfirmados() const { return confirmados; }
+
+    /** @brief Retransmissões feitas. */
+    uint64_t datagramasRetransmitidos() const { return retransmitidos; }
+
+    /** @brief Datagramas abandonados por falta de espaço na janela. */
+    uint64_t datagramasAbandonados() const { return abandonados; }
+};
+
+#endif // CONFIABILIDADE_UDP_HPP
@@ -0,0 +1,222 @@
+/**
+ * @file copia_zero.hpp
+ * @brief Envio UDP sem cópia (MSG_ZEROCOPY), com os buffers devolvidos só após a conclusão.
+ *
+ * @details Em envios grandes (lotes segmentados com UDP_SEGMENT, repasse de um gateway), copiar
+ * a carga para o kernel a cada sendmsg() passa a pesar. Com SO_ZEROCOPY habilitado no socket e
+ * MSG_ZEROCOPY no envio, o kernel fixa as páginas do buffer do usuário e as usa direto; em troca,
+ * o buffer não pode ser alterado nem reaproveitado até a notificação de conclusão, lida da fila
+ * de erros do socket (MSG_ERRQUEUE).
+ *
+ * O kernel numera os envios com MSG_ZEROCOPY bem-sucedidos do socket (0, 1, 2...) e cada
+ * notificação informa um intervalo de números concluídos. O EnvioCopiaZero guarda, para cada
+ * buffer em voo, o número do seu envio; na conclusão, o buffer volta ao pool. Se a notificação
+ * vem marcada com SO_EE_CODE_ZEROCOPY_COPIED, o kernel acabou copiando (ex.: no loopback, ou em
+ * placas sem scatter-gather): o envio está correto, só não economizou a cópia.
+ *
+ * Só compensa a partir de dezenas de KiB por envio: abaixo disso, fixar as páginas e ler a
+ * notificação custam mais que a cópia.
+ */
+
+#ifndef COPIA_ZERO_HPP
+#define COPIA_ZERO_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "gso_udp.hpp"
+#include "pool_buffers.hpp"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+/** @def COPIA_ZERO_BUFFERS
+ * @brief Buffers do pool do envio sem cópia (limita os envios em voo).
+ */
+#define COPIA_ZERO_BUFFERS 32
+
+/**
+ * @class EnvioCopiaZero
+ * @brief Pool de buffers de envio com MSG_ZEROCOPY e o ciclo de vida de cada um.
+ *
+ * @details Um buffer passa por: livre (obter()) → preenchido pelo chamador → em voo (enviar())
+ * → livre de novo (processarConclusoes()). Um buffer obtido e não enviado volta com liberar().
+ * Usado por um único thread.
+ */
+class EnvioCopiaZero {
+private:
+    /**< Socket com SO_ZEROCOPY. */
+    int sock = -1;
+
+    /**< Buffers de GSO_MAX_CARGA bytes. */
+    PoolBuffers buffers;
+
+    /**< Número do envio de cada buffer em voo, e se está em voo. */
+    uint32_t numeroEnvio[COPIA_ZERO_BUFFERS] = {};
+    bool emVoo[COPIA_ZERO_BUFFERS] = {};
+
+    /**< Número que o kernel dará ao próximo envio com MSG_ZEROCOPY. */
+    uint32_t proximoNumero = 0;
+
+    /**< Contadores: envios sem cópia, concluídos, concluídos com cópia e enviados com cópia (ENOBUFS). */
+    uint64_t envios = 0;
+    uint64_t concluidos = 0;
+    uint64_t copiados = 0;
+    uint64_t comCopia = 0;
+
+    /** @brief Devolve ao pool os buffers dos envios de @p primeiro a @p ultimo. */
+    uint32_t concluir(uint32_t primeiro, uint32_t ultimo) {
+        uint32_t devolvidos = 0;
+        for (uint32_t i = 0; i < buffers.blocos(); i++) {
+            if (emVoo[i] && numeroEnvio[i] - primeiro <= ultimo - primeiro) {
+                emVoo[i] = false;
+                buffers.devolver(i);
+                devolvidos++;
+            }
+        }
+        return devolvidos;
+    }
+
+public:
+    EnvioCopiaZero() = default;
+    EnvioCopiaZero(const EnvioCopiaZero&) = delete;
+    EnvioCopiaZero& operator=(const EnvioCopiaZero&) = delete;
+
+    /**
+     * @brief Habilita SO_ZEROCOPY em @p socketUdp e reserva os buffers.
+     * @return 0 ou -errno (ENOPROTOOPT/EOPNOTSUPP: kernel sem envio UDP sem cópia).
+     */
+    int iniciar(int socketUdp) {
+        int um = 1;
+        if (setsockopt(socketUdp, SOL_SOCKET, SO_ZEROCOPY, &um, sizeof(um)) < 0) {
+            return -errno;
+        }
+        sock = socketUdp;
+        return buffers.iniciar(COPIA_ZERO_BUFFERS, GSO_MAX_CARGA);
+    }
+
+    /**
+     * @brief Obtém um buffer livre; com o pool vazio, processa antes as conclusões pendentes.
+     * @return Índice do buffer, ou PoolBuffers::NENHUM se todos continuam em voo.
+     */
+    uint32_t obter() {
+        uint32_t indice = buffers.obter();
+        if (indice == PoolBuffers::NENHUM && processarConclusoes() > 0) {
+            indice = buffers.obter();
+        }
+        return indice;
+    }
+
+    /** @brief Endereço do buffer @p indice (GSO_MAX_CARGA bytes). */
+    char* dados(uint32_t indice) const { return buffers.bloco(indice); }
+
+    /** @brief Devolve um buffer obtido e não enviado. */
+    void liberar(uint32_t indice) { buffers.devolver(indice); }
+
+    /**
+     * @brief Envia o buffer @p indice sem cópia; em caso de sucesso, ele fica em voo até a conclusão.
+     *
+     * @details Sem memória para fixar as páginas (ENOBUFS, limite optmem do socket), o mesmo
+     * buffer sai com cópia e volta na hora ao pool. Em qualquer outra falha, também volta ao pool.
+     *
+     * @param segmento Tamanho dos datagramas (UDP_SEGMENT), ou 0 para um só datagrama.
+     * @param destino Destino, ou nulo com o socket conectado.
+     * @return Bytes enviados ou -errno.
+     */
+    ssize_t enviar(uint32_t indice, size_t tamanho, uint16_t segmento, const sockaddr_in* destino) {
+        ssize_t r = enviarSegmentado(sock, dados(indice), tamanho, segmento, destino, MSG_ZEROCOPY);
+        if (r >= 0) {
+            numeroEnvio[indice] = proximoNumero++;
+            emVoo[indice] = true;
+            envios++;
+            return r;
+        }
+        if (r == -ENOBUFS) {
+            r = enviarSegmentado(sock, dados(indice), tamanho, segmento, destino);
+            comCopia += r >= 0;
+        }
+        buffers.devolver(indice);
+        return r;
+    }
+
+    /**
+     * @brief Lê as notificações de conclusão da fila de erros (não bloqueia).
+     * @return Buffers devolvidos ao pool.
+     */
+    uint32_t processarConclusoes() {
+        uint32_t devolvidos = 0;
+        while (true) {
+            alignas(cmsghdr) char controle[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in))];
+            msghdr msg{};
+            msg.msg_control = controle;
+            msg.msg_controllen = sizeof(controle);
+            if (recvmsg(sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+                return devolvidos;
+            }
+            for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+                if (!((c->cmsg_level == SOL_IP && c->cmsg_type == IP_RECVERR) ||
+                      (c->cmsg_level == SOL_IPV6 && c->cmsg_type == IPV6_RECVERR))) {
+                    continue;
+                }
+                sock_extended_err erro;
+                memcpy(&erro, CMSG_DATA(c), sizeof(erro));
+                if (erro.ee_origin != SO_EE_ORIGIN_ZEROCOPY || erro.ee_errno != 0) {
+                    continue;
+                }
+                // ee_info..ee_data: intervalo de envios concluídos (inclusive)
+                uint32_t n = erro.ee_data - erro.ee_info + 1;
+                concluidos += n;
+                if (erro.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                    copiados += n;
+                }
+                devolvidos += concluir(erro.ee_info, erro.ee_data);
+            }
+        }
+    }
+
+    /**
+     * @brief Espera até @p timeoutMs por notificações e as processa.
+     * @return Buffers devolvidos ao pool.
+     */
+    uint32_t aguardarConclusoes(int timeoutMs) {
+        pollfd p{sock, 0, 0}; // a fila de erros não vazia aparece como POLLERR
+        poll(&p, 1, timeoutMs);
+        return processarConclusoes();
+    }
+
+    /** @brief true depois de um iniciar() bem-sucedido. */
+    bool valido() const { return sock >= 0; }
+
+    /** @brief Buffers em voo (enviados e ainda não concluídos). */
+    uint32_t emVooAtual() const {
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < buffers.blocos(); i++) {
+            n += emVoo[i];
+        }
+        return n;
+    }
+
+    /** @brief Envios feitos com MSG_ZEROCOPY. */
+    uint64_t enviosSemCopia() const { return envios; }
+
+    /** @brief Envios concluídos pelo kernel. */
+    uint64_t enviosConcluidos() const { return concluidos; }
+
+    /** @brief Envios concluídos em que o kernel acabou copiando a carga. */
+    uint64_t enviosCopiadosPeloKernel() const { return copiados; }
+
+    /** @brief Envios feitos com cópia por falta de memória para fixar as páginas (ENOBUFS). */
+    uint64_t enviosComCopia() const { return comCopia; }
+};
+
+#endif // COPIA_ZERO_HPP
@@ -0,0 +1,310 @@
+/**
+ * @file corrotinas.hpp
+ * @brief Executor mínimo de corrotinas C++20 em um único thread: temporizadores e descritores prontos.
+ *
+ * @details Um cliente com vários sensores e vários destinos teria dezenas de tarefas periódicas
+ * concorrentes; um thread por sensor não cabe em uma placa pequena. Aqui cada tarefa é uma
+ * corrotina escrita como um laço linear:
+ *
+ * @code
+ * Tarefa lerSensor(ExecutorCorrotinas& ex, SensorLDR& ldr, Lote& lote, uint64_t periodoNs) {
+ *     uint64_t prazo = monotonico();
+ *     while (true) {
+ *         prazo += periodoNs;
+ *         co_await ex.dormirAte(prazo);
+ *         lote.push_back(ldr.lerLuminosidadePercentual());
+ *     }
+ * }
+ * @endcode
+ *
+ * e todas rodam no thread que chama executar(), sem travas: uma corrotina só é retomada pelo
+ * laço do executor, nunca em paralelo com outra. Os prazos ficam em um heap, e um único timerfd
+ * (CLOCK_MONOTONIC, absoluto) é armado com o mais próximo. As esperas por descritor usam epoll
+ * com EPOLLONESHOT, com a corrotina como dado do evento.
+ *
+ * Requer C++20 (`-std=c++20`); o restante do projeto continua em C++17.
+ */
+
+#ifndef CORROTINAS_HPP
+#define CORROTINAS_HPP
+
+#if __cplusplus < 202002L
+#error "corrotinas.hpp requer C++20 (-std=c++20)"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <coroutine>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <functional>
+#include <vector>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+/**
+ * @class Tarefa
+ * @brief Corrotina entregue ao executor (começa suspensa; o executor a destrói ao terminar).
+ */
+class Tarefa {
+public:
+    struct promise_type {
+        Tarefa get_return_object() { return Tarefa(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit Tarefa(std::coroutine_handle<promise_type> h) : corrotina(h) {}
+    Tarefa(Tarefa&& outra) noexcept : corrotina(outra.corrotina) { outra.corrotina = nullptr; }
+    Tarefa(const Tarefa&) = delete;
+    Tarefa& operator=(const Tarefa&) = delete;
+
+    ~Tarefa() {
+        if (corrotina) {
+            corrotina.destroy();
+        }
+    }
+
+    /** @brief Entrega a corrotina (o chamador passa a ser o dono). */
+    std::coroutine_handle<> liberar() {
+        std::coroutine_handle<> h = corrotina;
+        corrotina = nullptr;
+        return h;
+    }
+
+private:
+    std::coroutine_handle<promise_type> corrotina;
+};
+
+/**
+ * @class ExecutorCorrotinas
+ * @brief Laço de eventos de um thread que retoma as corrotinas nos prazos e nos descritores prontos.
+ */
+class ExecutorCorrotinas {
+private:
+    /**< Prazo de uma corrotina adormecida. */
+    struct Prazo {
+        uint64_t instanteNs;
+        uint64_t ordem;                   /**< Desempate: prazos iguais na ordem de chegada. */
+        std::coroutine_handle<> corrotina;
+        bool operator>(const Prazo& o) const {
+            return instanteNs != o.instanteNs ? instanteNs > o.instanteNs : ordem > o.ordem;
+        }
+    };
+
+    /**< epoll e o timerfd do prazo mais próximo. */
+    int epfd = -1;
+    int tfd = -1;
+
+    /**< Heap de prazos (mínimo no topo), corrotinas prontas (e as da volta em curso) e prazo
+     * armado no timerfd. Os vetores mantêm a capacidade: nada é alocado em regime. */
+    std::vector<Prazo> prazos;
+    std::vector<std::coroutine_handle<>> prontas;
+    std::vector<std::coroutine_handle<>> emCurso;
+    uint64_t armado = 0;
+    uint64_t chegadas = 0;
+
+    /**< Corrotinas vivas (entregues e ainda não terminadas). */
+    size_t vivas = 0;
+
+    /**< Término pedido por parar(). */
+    bool parando = false;
+
+    /**< Retomadas desde o início (para medição). */
+    uint64_t retomadas = 0;
+
+    static uint64_t agora() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    void armarTemporizador() {
+        uint64_t proximo = prazos.empty() ? 0 : prazos.front().instanteNs;
+        if (proximo == armado) {
+            return;
+        }
+        itimerspec especificacao{};
+        especificacao.it_value.tv_sec = static_cast<time_t>(proximo / 1000000000ull);
+        especificacao.it_value.tv_nsec = static_cast<long>(proximo % 1000000000ull);
+        if (proximo != 0 && especificacao.it_value.tv_sec == 0 && especificacao.it_value.tv_nsec == 0) {
+            especificacao.it_value.tv_nsec = 1; // zero desarmaria o timerfd
+        }
+        timerfd_settime(tfd, TFD_TIMER_ABSTIME, &especificacao, nullptr);
+        armado = proximo;
+    }
+
+    void retomar(std::coroutine_handle<> h) {
+        retomadas++;
+        h.resume();
+        if (h.done()) {
+            h.destroy();
+            vivas--;
+        }
+    }
+
+public:
+    /**
+     * @brief Awaitable de dormirAte().
+     */
+    struct Dormir {
+        ExecutorCorrotinas& executor;
+        uint64_t prazoNs;
+        bool await_ready() const { return prazoNs <= agora(); }
+        void await_suspend(std::coroutine_handle<> h) { executor.agendar(prazoNs, h); }
+        void await_resume() const {}
+    };
+
+    /**
+     * @brief Awaitable de ceder(): volta ao fim da fila, depois das prontas e dos descritores.
+     */
+    struct Ceder {
+        ExecutorCorrotinas& executor;
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> h) { executor.agendar(0, h); }
+        void await_resume() const {}
+    };
+
+    /**
+     * @brief Awaitable de aguardar(): retoma com os eventos do epoll (EPOLLIN, EPOLLERR...).
+     */
+    struct AguardarDescritor {
+        ExecutorCorrotinas& executor;
+        int fd;
+        uint32_t eventos;
+        uint32_t ocorridos = 0;
+        bool await_ready() const { return false; }
+        bool await_suspend(std::coroutine_handle<> h) { return executor.vigiar(fd, eventos, this, h); }
+        uint32_t await_resume() const { return ocorridos; }
+        std::coroutine_handle<> corrotina = nullptr;
+    };
+
+    ExecutorCorrotinas() {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr; // o timerfd é o único evento sem awaitable
+        epoll_ctl(epfd, EPOLL_CTL_ADD, tfd, &ev);
+    }
+
+    ExecutorCorrotinas(const ExecutorCorrotinas&) = delete;
+    ExecutorCorrotinas& operator=(const ExecutorCorrotinas&) = delete;
+
+    ~ExecutorCorrotinas() {
+        for (auto& p : prazos) {
+            p.corrotina.destroy();
+        }
+        for (auto h : prontas) {
+            h.destroy();
+        }
+        close(tfd);
+        close(epfd);
+    }
+
+    /** @brief true se o epoll e o timerfd foram criados. */
+    bool valido() const { return epfd >= 0 && tfd >= 0; }
+
+    /** @brief Entrega uma tarefa ao executor; ela começa na próxima volta do laço. */
+    void iniciar(Tarefa tarefa) {
+        prontas.push_back(tarefa.liberar());
+        vivas++;
+    }
+
+    /** @brief Suspende a corrotina até @p prazoNs (CLOCK_MONOTONIC). */
+    Dormir dormirAte(uint64_t prazoNs) { return Dormir{*this, prazoNs}; }
+
+    /** @brief Deixa as outras corrotinas executarem (ex.: no meio de uma rajada de envios). */
+    Ceder ceder() { return Ceder{*this}; }
+
+    /** @brief Suspende a corrotina até @p fd ter algum dos @p eventos (padrão: leitura). */
+    AguardarDescritor aguardar(int fd, uint32_t eventos = EPOLLIN) { return AguardarDescritor{*this, fd, eventos}; }
+
+    /** @brief Coloca @p h no heap de prazos (usado por Dormir). */
+    void agendar(uint64_t prazoNs, std::coroutine_handle<> h) {
+        prazos.push_back(Prazo{prazoNs, chegadas++, h});
+        std::push_heap(prazos.begin(), prazos.end(), std::greater<Prazo>());
+    }
+
+    /**
+     * @brief Registra @p fd no epoll em modo único (usado por AguardarDescritor).
+     * @return false se não foi possível vigiar (a corrotina segue com ocorridos = EPOLLERR).
+     */
+    bool vigiar(int fd, uint32_t eventos, AguardarDescritor* espera, std::coroutine_handle<> h) {
+        espera->corrotina = h;
+        epoll_event ev{};
+        ev.events = eventos | EPOLLONESHOT;
+        ev.data.ptr = espera;
+        if (epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) < 0 &&
+            (errno != ENOENT || epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)) {
+            espera->ocorridos = EPOLLERR;
+            return false;
+        }
+        return true;
+    }
+
+    /** @brief Pede o término do laço (as corrotinas suspensas são destruídas com o executor). */
+    void parar() { parando = true; }
+
+    /** @brief Corrotinas ainda não terminadas. */
+    size_t tarefasVivas() const { return vivas; }
+
+    /** @brief Retomadas de corrotinas desde o início. */
+    uint64_t retomadasTotais() const { return retomadas; }
+
+    /**
+     * @brief Executa o laço até todas as tarefas terminarem ou parar() ser chamado.
+     * @return 0 ou -errno do epoll.
+     */
+    int executar() {
+        epoll_event eventos[64];
+        while (!parando && vivas > 0) {
+            // Retoma as prontas; as que ficarem prontas durante a volta esperam a seguinte.
+            emCurso.swap(prontas);
+            for (auto h : emCurso) {
+                retomar(h);
+            }
+            emCurso.clear();
+            uint64_t t = agora();
+            while (!prazos.empty() && prazos.front().instanteNs <= t) {
+                std::pop_heap(prazos.begin(), prazos.end(), std::greater<Prazo>());
+                prontas.push_back(prazos.back().corrotina);
+                prazos.pop_back();
+            }
+            if (parando || vivas == 0) {
+                break;
+            }
+            // Com corrotinas prontas, só consulta os descritores (sem bloquear), para que uma
+            // tarefa que cede a vez não deixe as que esperam um descritor sem executar.
+            bool haProntas = !prontas.empty();
+            if (!haProntas) {
+                armarTemporizador();
+            }
+            int n = epoll_wait(epfd, eventos, 64, haProntas ? 0 : -1);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -errno;
+            }
+            for (int i = 0; i < n; i++) {
+                if (eventos[i].data.ptr == nullptr) {
+                    uint64_t expiracoes;
+                    (void)!read(tfd, &expiracoes, sizeof(expiracoes));
+                    armado = 0;
+                    continue;
+                }
+                auto* espera = static_cast<AguardarDescritor*>(eventos[i].data.ptr);
+                espera->ocorridos = eventos[i].events;
+                prontas.push_back(espera->corrotina);
+            }
+        }
+        return 0;
+    }
+};
+
+#endif // CORROTINAS_HPP
@@ -0,0 +1,72 @@
+/**
+ * @file crc32c.hpp
+ * @brief CRC32C (Castagnoli), com a instrução crc32 do SSE4.2 quando disponível.
+ *
+ * @details Usado para validar os registros persistidos (diário do coletor e spool do cliente).
+ * A instrução é escolhida em tempo de execução, sem exigir `-msse4.2` na compilação; nas demais
+ * arquiteturas vale a versão por tabela.
+ */
+
+#ifndef CRC32C_HPP
+#define CRC32C_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief CRC32C (Castagnoli) por tabela, usado quando a instrução crc32 do SSE4.2 não existe.
+ */
+inline uint32_t crc32cTabela(uint32_t estado, const unsigned char* p, size_t n) {
+    static const std::array<uint32_t, 256> tabela = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    while (n-- > 0) {
+        estado = tabela[(estado ^ *p++) & 0xFF] ^ (estado >> 8);
+    }
+    return estado;
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief CRC32C com a instrução crc32 (8 bytes por instrução).
+ */
+__attribute__((target("sse4.2"))) inline uint32_t crc32cSse42(uint32_t estado, const unsigned char* p, size_t n) {
+    uint64_t c = estado;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        c = __builtin_ia32_crc32di(c, v);
+    }
+    estado = static_cast<uint32_t>(c);
+    while (n-- > 0) {
+        estado = __builtin_ia32_crc32qi(estado, *p++);
+    }
+    return estado;
+}
+#endif
+
+/**
+ * @brief CRC32C de @p n bytes, continuando o CRC @p crc (0 para começar).
+ */
+inline uint32_t crc32c(const void* dados, size_t n, uint32_t crc = 0) {
+    const unsigned char* p = static_cast<const unsigned char*>(dados);
+#if defined(__x86_64__)
+    static const bool sse42 = __builtin_cpu_supports("sse4.2");
+    if (sse42) {
+        return ~crc32cSse42(~crc, p, n);
+    }
+#endif
+    return ~crc32cTabela(~crc, p, n);
+}
+
+#endif // CRC32C_HPP
@@ -0,0 +1,524 @@
+/**
+ * @file diario_amostras.hpp
+ * @brief Diário de escrita antecipada (write-ahead log) dos lotes de amostras, com commit em grupo.
+ *
+ * @details A única persistência do servidor Python é o `salvar_log()` acionado por botão, e o
+ * arquivo CSV do coletor é escrito sem fsync: uma queda perde tudo o que estava em cache. Aqui
+ * cada lote decodificado é anexado a um diário segmentado como um registro com número de
+ * sequência (LSN) e CRC32C. O laço de recepção apenas copia o registro para um buffer em memória;
+ * um thread próprio do diário grava o buffer e chama fdatasync() a cada `intervaloMs` ou assim
+ * que `limiteBytes` se acumulam (commit em grupo), de modo que a durabilidade custa um fsync por
+ * grupo de lotes, e não um por amostra.
+ *
+ * O diário é dividido em segmentos `<prefixo>.<número de 8 dígitos>.wal`; ao passar de
+ * `tamanhoSegmento` bytes o segmento é fechado e outro é aberto. Na abertura, apenas o último
+ * segmento é percorrido: o diário é truncado no primeiro registro incompleto, com CRC inválido ou
+ * fora de sequência (a cauda de uma gravação interrompida) e a escrita continua dali.
+ *
+ * Layout de um segmento (ordem de bytes e layout do host): CabecalhoSegmentoDiario (16 bytes)
+ * seguido dos registros, cada um com CabecalhoRegistroDiario (16 bytes) e `tamanho` bytes de
+ * estruturas AmostraLDR. O CRC cobre `tamanho`, `lsn` e o conteúdo.
+ */
+
+#ifndef DIARIO_AMOSTRAS_HPP
+#define DIARIO_AMOSTRAS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "crc32c.hpp"
+#include "log_assincrono.hpp"
+#include "protocolo_ldr.hpp"
+
+/** @def DIARIO_MAGIA
+ * @brief Identificação de um segmento do diário ("LDRW").
+ */
+#define DIARIO_MAGIA 0x5752444Cu
+
+/** @def DIARIO_VERSAO
+ * @brief Versão do layout dos segmentos.
+ */
+#define DIARIO_VERSAO 1
+
+/** @def DIARIO_TAMANHO_MAXIMO_CONTEUDO
+ * @brief Maior conteúdo aceito em um registro: um datagrama com o máximo de amostras.
+ */
+#define DIARIO_TAMANHO_MAXIMO_CONTEUDO (LDR_MAX_AMOSTRAS_DATAGRAMA * sizeof(AmostraLDR))
+
+/**
+ * @brief Cabeçalho de um segmento do diário.
+ */
+struct CabecalhoSegmentoDiario {
+    uint32_t magia;        /**< DIARIO_MAGIA. */
+    uint32_t versao;       /**< DIARIO_VERSAO. */
+    uint64_t primeiroLsn;  /**< LSN do primeiro registro do segmento. */
+};
+
+/**
+ * @brief Cabeçalho de um registro do diário.
+ */
+struct CabecalhoRegistroDiario {
+    uint32_t tamanho;  /**< Bytes de conteúdo (n * sizeof(AmostraLDR)). */
+    uint32_t crc;      /**< CRC32C de `tamanho`, `lsn` e do conteúdo. */
+    uint64_t lsn;      /**< Número de sequência do registro (contínuo entre segmentos). */
+};
+static_assert(sizeof(CabecalhoSegmentoDiario) == 16, "cabecalho do segmento deve ter 16 bytes");
+static_assert(sizeof(CabecalhoRegistroDiario) == 16, "cabecalho do registro deve ter 16 bytes");
+
+/**
+ * @brief CRC de um registro do diário.
+ */
+inline uint32_t crcRegistroDiario(const CabecalhoRegistroDiario& c, const void* conteudo) {
+    uint32_t crc = crc32c(&c.tamanho, sizeof(c.tamanho));
+    crc = crc32c(&c.lsn, sizeof(c.lsn), crc);
+    return crc32c(conteudo, c.tamanho, crc);
+}
+
+/**
+ * @brief Parâmetros do diário.
+ */
+struct ConfiguracaoDiario {
+    uint32_t intervaloMs = 10;               /**< Commit em grupo a cada intervaloMs (0 = a cada lote). */
+    size_t limiteBytes = 256 * 1024;         /**< ... ou assim que limiteBytes estiverem pendentes. */
+    uint64_t tamanhoSegmento = 64ull << 20;  /**< Tamanho a partir do qual o segmento é trocado. */
+    uint32_t segmentosRetidos = 0;           /**< Segmentos mantidos em disco (0 = todos). */
+};
+
+/**
+ * @class DiarioAmostras
+ * @brief Diário segmentado com um produtor (o laço de recepção) e um thread de commit.
+ *
+ * @details O produtor anexa registros ao buffer ativo; o thread de commit troca os dois buffers,
+ * grava o cheio e o sincroniza. Se os dois buffers estiverem ocupados, o produtor espera o commit
+ * em andamento (contenção contada em esperasEspaco()): as amostras não são descartadas.
+ */
+class DiarioAmostras {
+private:
+    /**< Prefixo dos segmentos e parâmetros. */
+    std::string prefixo;
+    ConfiguracaoDiario config;
+
+    /**< Segmento em escrita (usados só pelo thread de commit depois de abrir()). */
+    int fd = -1;
+    std::atomic<uint64_t> segmento{0};
+    uint64_t bytesSegmento = 0;
+
+    /**< LSN do próximo registro (só o produtor o altera) e o último anexado, para consulta. */
+    uint64_t proximoLsn = 1;
+    std::atomic<uint64_t> anexado{0};
+
+    /**< Buffers de registros, protegidos pela trava. */
+    std::mutex trava;
+    std::condition_variable sinalCommit;
+    std::condition_variable sinalEspaco;
+    std::unique_ptr<char[]> buffers[2];
+    size_t capacidade = 0;
+    size_t ocupado = 0;
+    int ativo = 0;
+    uint64_t ultimoLsn = 0;
+    bool encerrando = false;
+
+    /**< Thread de commit. */
+    std::thread thread;
+
+    /**< Contadores. */
+    std::atomic<uint64_t> duravel{0};
+    std::atomic<uint64_t> sincronizacoesFeitas{0};
+    std::atomic<uint64_t> bytesGravadosTotal{0};
+    std::atomic<uint64_t> erros{0};
+    std::atomic<uint64_t> esperas{0};
+
+    /**< Resultado da recuperação feita em abrir(). */
+    uint64_t recuperados = 0;
+    uint64_t descartados = 0;
+
+    static std::string nomeSegmento(const std::string& prefixo, uint64_t numero) {
+        char sufixo[32];
+        snprintf(sufixo, sizeof(sufixo), ".%08llu.wal", static_cast<unsigned long long>(numero));
+        return prefixo + sufixo;
+    }
+
+    static std::string diretorio(const std::string& prefixo) {
+        size_t barra = prefixo.rfind('/');
+        return barra == std::string::npos ? "." : barra == 0 ? "/" : prefixo.substr(0, barra);
+    }
+
+    /** @brief Números dos segmentos existentes, em ordem crescente. */
+    static std::vector<uint64_t> listarSegmentos(const std::string& prefixo) {
+        std::vector<uint64_t> numeros;
+        size_t barra = prefixo.rfind('/');
+        std::string base = barra == std::string::npos ? prefixo : prefixo.substr(barra + 1);
+        DIR* d = opendir(diretorio(prefixo).c_str());
+        if (d == nullptr) {
+            return numeros;
+        }
+        while (dirent* e = readdir(d)) {
+            const char* nome = e->d_name;
+            size_t n = strlen(nome);
+            // <base>.<8 dígitos>.wal
+            if (n != base.size() + 13 || strncmp(nome, base.c_str(), base.size()) != 0 ||
+                nome[base.size()] != '.' || strcmp(nome + n - 4, ".wal") != 0) {
+                continue;
+            }
+            uint64_t numero = 0;
+            bool valido = true;
+            for (size_t i = base.size() + 1; i < n - 4; i++) {
+                valido = valido && nome[i] >= '0' && nome[i] <= '9';
+                numero = numero * 10 + static_cast<uint64_t>(nome[i] - '0');
+            }
+            if (valido) {
+                numeros.push_back(numero);
+            }
+        }
+        closedir(d);
+        std::sort(numeros.begin(), numeros.end());
+        return numeros;
+    }
+
+    /**
+     * @brief Percorre os registros válidos de um segmento.
+     * @param proximo Recebe o LSN seguinte ao último registro válido.
+     * @param validos Recebe o número de bytes válidos desde o início do arquivo (0 = cabeçalho inválido).
+     * @param tamanhoArquivo Recebe o tamanho do arquivo.
+     * @param f Chamada com `(uint64_t lsn, const AmostraLDR* amostras, size_t n)` para cada registro.
+     * @return 0 ou -errno.
+     */
+    template <typename Funcao>
+    static int percorrerSegmento(const std::string& caminho, uint64_t& proximo, size_t& validos,
+                                 size_t& tamanhoArquivo, Funcao&& f) {
+        validos = 0;
+        tamanhoArquivo = 0;
+        int fdSegmento = open(caminho.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fdSegmento < 0) {
+            return -errno;
+        }
+        struct stat st;
+        if (fstat(fdSegmento, &st) < 0) {
+            int erro = errno;
+            close(fdSegmento);
+            return -erro;
+        }
+        tamanhoArquivo = static_cast<size_t>(st.st_size);
+        if (tamanhoArquivo < sizeof(CabecalhoSegmentoDiario)) {
+            close(fdSegmento);
+            return 0;
+        }
+        void* p = mmap(nullptr, tamanhoArquivo, PROT_READ, MAP_PRIVATE, fdSegmento, 0);
+        int erro = errno;
+        close(fdSegmento);
+        if (p == MAP_FAILED) {
+            return -erro;
+        }
+        madvise(p, tamanhoArquivo, MADV_SEQUENTIAL);
+        const char* dados = static_cast<const char*>(p);
+        CabecalhoSegmentoDiario cs;
+        memcpy(&cs, dados, sizeof(cs));
+        if (cs.magia == DIARIO_MAGIA && cs.versao == DIARIO_VERSAO) {
+            size_t pos = sizeof(cs);
+            proximo = cs.primeiroLsn;
+            while (pos + sizeof(CabecalhoRegistroDiario) <= tamanhoArquivo) {
+                CabecalhoRegistroDiario c;
+                memcpy(&c, dados + pos, sizeof(c));
+                const char* conteudo = dados + pos + sizeof(c);
+                if (c.tamanho == 0 || c.tamanho > DIARIO_TAMANHO_MAXIMO_CONTEUDO || c.tamanho % sizeof(AmostraLDR) != 0 ||
+                    c.tamanho > tamanhoArquivo - pos - sizeof(c) || c.lsn != proximo ||
+                    crcRegistroDiario(c, conteudo) != c.crc) {
+                    break;
+                }
+                // Os registros começam em múltiplos de 8 bytes: as amostras são lidas no mapeamento.
+                f(c.lsn, reinterpret_cast<const AmostraLDR*>(conteudo), c.tamanho / sizeof(AmostraLDR));
+                pos += sizeof(c) + c.tamanho;
+                proximo++;
+            }
+            validos = pos;
+        }
+        munmap(p, tamanhoArquivo);
+        return 0;
+    }
+
+    /** @brief Cria o segmento @p numero, com o cabeçalho já sincronizado. @return Descritor ou -errno. */
+    int criarSegmento(uint64_t numero, uint64_t primeiroLsn) {
+        std::string caminho = nomeSegmento(prefixo, numero);
+        int novo = open(caminho.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (novo < 0) {
+            return -errno;
+        }
+        CabecalhoSegmentoDiario cs{DIARIO_MAGIA, DIARIO_VERSAO, primeiroLsn};
+        if (write(novo, &cs, sizeof(cs)) != static_cast<ssize_t>(sizeof(cs)) || fdatasync(novo) < 0) {
+            int erro = errno != 0 ? errno : EIO;
+            close(novo);
+            return -erro;
+        }
+        sincronizarDiretorio();
+        bytesSegmento = sizeof(cs);
+        return novo;
+    }
+
+    /** @brief Torna durável a criação (ou remoção) de um segmento. */
+    void sincronizarDiretorio() {
+        int d = open(diretorio(prefixo).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (d >= 0) {
+            fsync(d);
+            close(d);
+        }
+    }
+
+    /** @brief Fecha o segmento atual e abre o seguinte, removendo o que sai da retenção. */
+    void trocarSegmento(uint64_t primeiroLsn) {
+        uint64_t numero = segmento.load(std::memory_order_relaxed) + 1;
+        int novo = criarSegmento(numero, primeiroLsn);
+        if (novo < 0) {
+            errno = -novo;
+            erros.fetch_add(1, std::memory_order_relaxed);
+            LOG_ERRO("Erro ao criar segmento do diario", campoErrno(), campo("segmento", nomeSegmento(prefixo, numero)));
+            return; // continua no segmento atual
+        }
+        close(fd);
+        fd = novo;
+        segmento.store(numero, std::memory_order_relaxed);
+        if (config.segmentosRetidos > 0 && numero > config.segmentosRetidos) {
+            unlink(nomeSegmento(prefixo, numero - config.segmentosRetidos).c_str());
+        }
+    }
+
+    /** @brief Grava e sincroniza @p n bytes de registros cujo último LSN é @p lsn. */
+    void gravar(const char* dados, size_t n, uint64_t lsn) {
+        for (size_t feito = 0; feito < n;) {
+            ssize_t r = write(fd, dados + feito, n - feito);
+            if (r < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                erros.fetch_add(1, std::memory_order_relaxed);
+                LOG_ERRO("Erro ao gravar o diario", campoErrno(), campo("lsn", lsn));
+                return;
+            }
+            feito += static_cast<size_t>(r);
+        }
+        if (fdatasync(fd) < 0) {
+            erros.fetch_add(1, std::memory_order_relaxed);
+            LOG_ERRO("Erro no fdatasync do diario", campoErrno(), campo("lsn", lsn));
+            return;
+        }
+        duravel.store(lsn, std::memory_order_release);
+        sincronizacoesFeitas.fetch_add(1, std::memory_order_relaxed);
+        bytesGravadosTotal.fetch_add(n, std::memory_order_relaxed);
+        bytesSegmento += n;
+        if (bytesSegmento >= config.tamanhoSegmento) {
+            trocarSegmento(lsn + 1);
+        }
+    }
+
+    void executar() {
+        auto intervalo = config.intervaloMs > 0 ? std::chrono::milliseconds(config.intervaloMs)
+                                                 : std::chrono::milliseconds(1000);
+        std::unique_lock<std::mutex> lk(trava);
+        while (true) {
+            sinalCommit.wait_for(lk, intervalo, [&] { return encerrando || ocupado >= config.limiteBytes; });
+            if (ocupado == 0) {
+                if (encerrando) {
+                    break;
+                }
+                continue;
+            }
+            int cheio = ativo;
+            size_t n = ocupado;
+            uint64_t lsn = ultimoLsn;
+            ativo ^= 1;
+            ocupado = 0;
+            lk.unlock();
+            sinalEspaco.notify_one();
+            gravar(buffers[cheio].get(), n, lsn);
+            lk.lock();
+        }
+    }
+
+public:
+    DiarioAmostras() = default;
+    DiarioAmostras(const DiarioAmostras&) = delete;
+    DiarioAmostras& operator=(const DiarioAmostras&) = delete;
+
+    ~DiarioAmostras() { fechar(); }
+
+    /**
+     * @brief Abre o diário, recuperando a cauda do último segmento, e inicia o thread de commit.
+     * @param prefixoSegmentos Prefixo dos segmentos (ex.: "diario/ldr").
+     * @param configuracao Parâmetros do commit em grupo e da segmentação.
+     * @return 0 ou -errno.
+     */
+    int abrir(const std::string& prefixoSegmentos, const ConfiguracaoDiario& configuracao = ConfiguracaoDiario()) {
+        prefixo = prefixoSegmentos;
+        config = configuracao;
+        if (config.intervaloMs == 0) {
+            config.limiteBytes = 1; // commit assim que houver um registro pendente
+        }
+        std::vector<uint64_t> numeros = listarSegmentos(prefixo);
+        auto contar = [&](uint64_t, const AmostraLDR*, size_t) { recuperados++; };
+        if (numeros.empty()) {
+            segmento.store(1, std::memory_order_relaxed);
+            fd = criarSegmento(1, 1);
+        } else {
+            uint64_t ultimo = numeros.back();
+            size_t validos, tamanhoArquivo;
+            int r = percorrerSegmento(nomeSegmento(prefixo, ultimo), proximoLsn, validos, tamanhoArquivo, contar);
+            if (r < 0) {
+                return r;
+            }
+            descartados = tamanhoArquivo - validos;
+            segmento.store(ultimo, std::memory_order_relaxed);
+            if (validos > 0) {
+                fd = open(nomeSegmento(prefixo, ultimo).c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+                if (fd >= 0 && descartados > 0 && (ftruncate(fd, static_cast<off_t>(validos)) < 0 || fdatasync(fd) < 0)) {
+                    int erro = errno;
+                    close(fd);
+                    return -erro;
+                }
+                fd = fd >= 0 ? fd : -errno;
+                bytesSegmento = validos;
+            } else {
+                // Cabeçalho incompleto (queda ao criar o segmento): o LSN continua do anterior.
+                proximoLsn = 1;
+                if (numeros.size() > 1) {
+                    size_t v, t;
+                    percorrerSegmento(nomeSegmento(prefixo, numeros[numeros.size() - 2]), proximoLsn, v, t,
+                                      [](uint64_t, const AmostraLDR*, size_t) {});
+                }
+                fd = criarSegmento(ultimo, proximoLsn);
+            }
+        }
+        if (fd < 0) {
+            int erro = fd;
+            fd = -1;
+            return erro;
+        }
+        duravel.store(proximoLsn - 1, std::memory_order_relaxed);
+        anexado.store(proximoLsn - 1, std::memory_order_relaxed);
+        ultimoLsn = proximoLsn - 1;
+        capacidade = std::max<size_t>(2 * config.limiteBytes, 64 * 1024);
+        buffers[0].reset(new char[capacidade]);
+        buffers[1].reset(new char[capacidade]);
+        encerrando = false;
+        thread = std::thread(&DiarioAmostras::executar, this);
+        return 0;
+    }
+
+    /**
+     * @brief Anexa um lote de amostras como um registro (só o laço de recepção chama).
+     * @details Não aloca nem faz chamada de sistema, exceto quando os dois buffers estão ocupados.
+     */
+    void anexar(const AmostraLDR* amostras, size_t n) {
+        if (n == 0) {
+            return;
+        }
+        CabecalhoRegistroDiario c;
+        c.tamanho = static_cast<uint32_t>(n * sizeof(AmostraLDR));
+        c.lsn = proximoLsn++;
+        anexado.store(c.lsn, std::memory_order_relaxed);
+        c.crc = crcRegistroDiario(c, amostras);
+        size_t total = sizeof(c) + c.tamanho;
+        bool commitar;
+        {
+            std::unique_lock<std::mutex> lk(trava);
+            if (ocupado + total > capacidade) {
+                esperas.fetch_add(1, std::memory_order_relaxed);
+                sinalCommit.notify_one();
+                sinalEspaco.wait(lk, [&] { return ocupado + total <= capacidade; });
+            }
+            char* destino = buffers[ativo].get() + ocupado;
+            memcpy(destino, &c, sizeof(c));
+            memcpy(destino + sizeof(c), amostras, c.tamanho);
+            ocupado += total;
+            ultimoLsn = c.lsn;
+            commitar = ocupado >= config.limiteBytes;
+        }
+        if (commitar) {
+            sinalCommit.notify_one();
+        }
+    }
+
+    /**
+     * @brief Grava os registros pendentes, encerra o thread de commit e fecha o segmento.
+     */
+    void fechar() {
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lk(trava);
+                encerrando = true;
+            }
+            sinalCommit.notify_one();
+            thread.join();
+        }
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    /**
+     * @brief Percorre todos os registros válidos dos segmentos de @p prefixoSegmentos, em ordem.
+     * @param f Chamada com `(uint64_t lsn, const AmostraLDR* amostras, size_t n)`.
+     * @return Número de registros percorridos, ou -errno.
+     */
+    template <typename Funcao>
+    static int64_t reproduzir(const std::string& prefixoSegmentos, Funcao&& f) {
+        int64_t registros = 0;
+        for (uint64_t numero : listarSegmentos(prefixoSegmentos)) {
+            uint64_t proximo = 0;
+            size_t validos, tamanhoArquivo;
+            int r = percorrerSegmento(nomeSegmento(prefixoSegmentos, numero), proximo, validos, tamanhoArquivo,
+                                      [&](uint64_t lsn, const AmostraLDR* a, size_t n) {
+                                          registros++;
+                                          f(lsn, a, n);
+                                      });
+            if (r < 0) {
+                return r;
+            }
+        }
+        return registros;
+    }
+
+    /** @brief LSN do último registro anexado. */
+    uint64_t lsnAnexado() const { return anexado.load(std::memory_order_relaxed); }
+
+    /** @brief LSN do último registro já sincronizado em disco. */
+    uint64_t lsnDuravel() const { return duravel.load(std::memory_order_acquire); }
+
+    /** @brief Número do segmento em escrita. */
+    uint64_t segmentoAtual() const { return segmento.load(std::memory_order_relaxed); }
+
+    /** @brief Número de commits (fdatasync) feitos. */
+    uint64_t sincronizacoes() const { return sincronizacoesFeitas.load(std::memory_order_relaxed); }
+
+    /** @brief Bytes de registros gravados. */
+    uint64_t bytesGravados() const { return bytesGravadosTotal.load(std::memory_order_relaxed); }
+
+    /** @brief Falhas de gravação ou sincronização. */
+    uint64_t errosGravacao() const { return erros.load(std::memory_order_relaxed); }
+
+    /** @brief Vezes em que o laço de recepção esperou por espaço nos buffers. */
+    uint64_t esperasEspaco() const { return esperas.load(std::memory_order_relaxed); }
+
+    /** @brief Registros válidos encontrados no último segmento ao abrir. */
+    uint64_t registrosRecuperados() const { return recuperados; }
+
+    /** @brief Bytes da cauda inválida truncados ao abrir. */
+    uint64_t bytesDescartados() const { return descartados; }
+};
+
+#endif // DIARIO_AMOSTRAS_HPP
@@ -0,0 +1,284 @@
+/**
+ * @file difusao_amostras.hpp
+ * @brief Difusão (publish/subscribe) do fluxo decodificado do coletor para vários consumidores.
+ *
+ * @details Hoje apenas a `App` Tkinter consome os dados, e um segundo consumidor precisaria de
+ * outro bind na porta 8080. Aqui os trabalhadores do coletor publicam cada lote decodificado,
+ * já codificado no formato binário de protocolo_ldr.hpp, em um anel de difusão (AnelDifusao):
+ * o registro é escrito uma única vez e cada assinante lê com o seu próprio cursor, sem fila nem
+ * cópia por assinante. Um assinante lento não atrasa os produtores nem os demais assinantes:
+ * quando o anel dá a volta sobre ele, os registros perdidos são contados e a leitura continua
+ * do registro mais antigo ainda disponível.
+ *
+ * Para consumidores em outros processos (interface, arquivamento, exportadores), o
+ * ServidorDifusao atende um socket Unix SOCK_SEQPACKET: cada conexão recebe os mesmos
+ * datagramas binários, um por mensagem.
+ */
+
+#ifndef DIFUSAO_AMOSTRAS_HPP
+#define DIFUSAO_AMOSTRAS_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "log_assincrono.hpp"
+#include "protocolo_ldr.hpp"
+
+/** @def DIFUSAO_REGISTROS
+ * @brief Número de registros do anel de difusão (potência de 2).
+ */
+#define DIFUSAO_REGISTROS 4096
+
+/** @def DIFUSAO_TAMANHO_REGISTRO
+ * @brief Tamanho máximo de um registro: um datagrama binário com o máximo de amostras.
+ */
+#define DIFUSAO_TAMANHO_REGISTRO (sizeof(CabecalhoLDR) + LDR_MAX_AMOSTRAS_DATAGRAMA * sizeof(AmostraWireLDR))
+
+/**
+ * @brief Posição de leitura de um assinante.
+ */
+struct CursorDifusao {
+    uint64_t proximo = 0;  /**< Próximo registro a ler. */
+    uint64_t perdidos = 0; /**< Registros sobrescritos antes de serem lidos. */
+};
+
+/**
+ * @class AnelDifusao
+ * @brief Anel de registros com vários produtores e leitores independentes (seqlock por registro).
+ *
+ * @details A posição de escrita é reservada com um fetch_add; o registro é marcado como "em
+ * escrita" (sequência ímpar) e publicado com a sequência 2 * posição + 2. O leitor copia o
+ * registro e confere se a sequência não mudou durante a cópia.
+ */
+class AnelDifusao {
+private:
+    /** @brief Um registro do anel. */
+    struct alignas(64) Registro {
+        std::atomic<uint64_t> seq{0};  /**< 2 * posição + 1 em escrita, 2 * posição + 2 publicado. */
+        uint32_t tamanho = 0;          /**< Bytes válidos em dados. */
+        char dados[DIFUSAO_TAMANHO_REGISTRO];
+    };
+
+    /**< Registros (mmap, fora do heap). */
+    Registro* registros;
+
+    /**< Próxima posição de escrita. */
+    alignas(64) std::atomic<uint64_t> cabeca{0};
+
+public:
+    AnelDifusao() {
+        void* p = mmap(nullptr, sizeof(Registro) * DIFUSAO_REGISTROS, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        registros = p != MAP_FAILED ? new (p) Registro[DIFUSAO_REGISTROS] : nullptr;
+    }
+
+    ~AnelDifusao() {
+        if (registros != nullptr) {
+            munmap(registros, sizeof(Registro) * DIFUSAO_REGISTROS);
+        }
+    }
+
+    AnelDifusao(const AnelDifusao&) = delete;
+    AnelDifusao& operator=(const AnelDifusao&) = delete;
+
+    /** @brief false se a memória do anel não pôde ser reservada. */
+    bool valido() const { return registros != nullptr; }
+
+    /**
+     * @brief Publica um registro escrito diretamente no anel.
+     * @param escrever Função `size_t(char* destino, size_t capacidade)` que preenche o registro e
+     * devolve o seu tamanho (0 cancela a publicação, que fica como registro vazio).
+     */
+    template <typename Funcao>
+    void publicar(Funcao&& escrever) {
+        uint64_t pos = cabeca.fetch_add(1, std::memory_order_relaxed);
+        Registro& r = registros[pos & (DIFUSAO_REGISTROS - 1)];
+        r.seq.store(2 * pos + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        r.tamanho = static_cast<uint32_t>(escrever(r.dados, sizeof(r.dados)));
+        r.seq.store(2 * pos + 2, std::memory_order_release);
+    }
+
+    /** @brief Cria um cursor que lê a partir do próximo registro publicado. */
+    CursorDifusao assinar() const {
+        CursorDifusao c;
+        c.proximo = cabeca.load(std::memory_order_acquire);
+        return c;
+    }
+
+    /**
+     * @brief Lê o próximo registro do cursor.
+     * @param destino Buffer com DIFUSAO_TAMANHO_REGISTRO bytes.
+     * @return Tamanho do registro; 0 se ainda não há registro novo (registros vazios são pulados).
+     */
+    size_t ler(CursorDifusao& c, char* destino) const {
+        while (true) {
+            uint64_t pos = c.proximo;
+            const Registro& r = registros[pos & (DIFUSAO_REGISTROS - 1)];
+            uint64_t seq = r.seq.load(std::memory_order_acquire);
+            if (seq < 2 * pos + 2) {
+                return 0; // ainda não publicado (ou em escrita)
+            }
+            if (seq == 2 * pos + 2) {
+                uint32_t tamanho = r.tamanho;
+                memcpy(destino, r.dados, tamanho <= sizeof(r.dados) ? tamanho : 0);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (r.seq.load(std::memory_order_relaxed) == seq) {
+                    c.proximo++;
+                    if (tamanho > 0) {
+                        return tamanho;
+                    }
+                    continue;
+                }
+            }
+            // O anel deu a volta sobre o cursor: recomeça do registro mais antigo disponível.
+            uint64_t h = cabeca.load(std::memory_order_acquire);
+            uint64_t antigo = h > DIFUSAO_REGISTROS ? h - DIFUSAO_REGISTROS + 1 : 0;
+            if (antigo <= pos) {
+                antigo = pos + 1;
+            }
+            c.perdidos += antigo - pos;
+            c.proximo = antigo;
+        }
+    }
+
+    /** @brief Número de registros já publicados. */
+    uint64_t publicados() const { return cabeca.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @class ServidorDifusao
+ * @brief Repassa o anel de difusão aos clientes de um socket Unix SOCK_SEQPACKET.
+ *
+ * @details Um thread próprio lê cada registro uma vez e o envia a todos os clientes com
+ * MSG_DONTWAIT: um cliente que não esvazia o seu socket perde registros (contados), sem atrasar
+ * os demais. Quando não há registros novos, o thread dorme 1 ms.
+ */
+class ServidorDifusao {
+private:
+    /** @brief Um cliente conectado. */
+    struct Cliente {
+        int fd;                 /**< Conexão. */
+        uint64_t descartados;   /**< Registros não entregues (socket cheio). */
+    };
+
+    /**< Anel de origem. */
+    const AnelDifusao& anel;
+
+    /**< Socket de escuta e o seu caminho. */
+    int escuta = -1;
+    std::string caminho;
+
+    /**< Thread de repasse. */
+    std::thread thread;
+    std::atomic<bool> ativo{false};
+
+    /**< Registros perdidos pelo próprio repasse (anel deu a volta). */
+    std::atomic<uint64_t> perdidos{0};
+
+    /**< Clientes conectados. */
+    std::atomic<uint32_t> conectados{0};
+
+    void executar() {
+        std::vector<Cliente> clientes;
+        CursorDifusao cursor = anel.assinar();
+        char registro[DIFUSAO_TAMANHO_REGISTRO];
+        while (ativo.load(std::memory_order_relaxed)) {
+            int fd;
+            while ((fd = accept4(escuta, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                clientes.push_back(Cliente{fd, 0});
+                LOG_INFO("Assinante conectado", campo("socket", caminho), campo("assinantes", clientes.size()));
+            }
+            size_t tamanho;
+            bool leu = false;
+            while ((tamanho = anel.ler(cursor, registro)) > 0) {
+                leu = true;
+                for (size_t i = 0; i < clientes.size();) {
+                    if (send(clientes[i].fd, registro, tamanho, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0) {
+                        i++;
+                    } else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                        clientes[i++].descartados++;
+                    } else {
+                        LOG_INFO("Assinante desconectado", campo("socket", caminho),
+                                 campo("descartados", clientes[i].descartados));
+                        close(clientes[i].fd);
+                        clientes[i] = clientes.back();
+                        clientes.pop_back();
+                    }
+                }
+            }
+            perdidos.store(cursor.perdidos, std::memory_order_relaxed);
+            conectados.store(static_cast<uint32_t>(clientes.size()), std::memory_order_relaxed);
+            if (!leu) {
+                usleep(1000);
+            }
+        }
+        for (const Cliente& c : clientes) {
+            close(c.fd);
+        }
+    }
+
+public:
+    explicit ServidorDifusao(const AnelDifusao& origem) : anel(origem) {}
+
+    ~ServidorDifusao() { encerrar(); }
+
+    /**
+     * @brief Cria o socket em @p caminhoSocket (substituindo um socket antigo) e inicia o repasse.
+     * @return 0 ou -errno.
+     */
+    int iniciar(const std::string& caminhoSocket) {
+        sockaddr_un endereco{};
+        if (caminhoSocket.size() >= sizeof(endereco.sun_path)) {
+            return -ENAMETOOLONG;
+        }
+        endereco.sun_family = AF_UNIX;
+        memcpy(endereco.sun_path, caminhoSocket.c_str(), caminhoSocket.size() + 1);
+        escuta = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (escuta < 0) {
+            return -errno;
+        }
+        unlink(caminhoSocket.c_str());
+        if (bind(escuta, reinterpret_cast<sockaddr*>(&endereco), sizeof(endereco)) < 0 || listen(escuta, 16) < 0) {
+            int erro = errno;
+            close(escuta);
+            escuta = -1;
+            return -erro;
+        }
+        caminho = caminhoSocket;
+        ativo.store(true);
+        thread = std::thread(&ServidorDifusao::executar, this);
+        return 0;
+    }
+
+    /** @brief Interrompe o repasse, desconecta os clientes e remove o socket. */
+    void encerrar() {
+        ativo.store(false);
+        if (thread.joinable()) {
+            thread.join();
+        }
+        if (escuta >= 0) {
+            close(escuta);
+            unlink(caminho.c_str());
+            escuta = -1;
+        }
+    }
+
+    /** @brief Clientes conectados. */
+    uint32_t assinantes() const { return conectados.load(std::memory_order_relaxed); }
+
+    /** @brief Registros que o repasse não leu a tempo. */
+    uint64_t registrosPerdidos() const { return perdidos.load(std::memory_order_relaxed); }
+};
+
+#endif // DIFUSAO_AMOSTRAS_HPP
@@ -0,0 +1,280 @@
+/**
+ * @file eventos_iio.hpp
+ * @brief Eventos de limiar do IIO: o cliente dorme até a leitura do ADC sair de uma janela.
+ *
+ * @details Com o sinal parado, ler o ADC a cada período só confirma que nada mudou. Os ADCs
+ * com comparador expõem, no sysfs, eventos de limiar por canal
+ * (`events/in_voltage<N>_thresh_{rising,falling}_{value,en}`). O cliente arma uma janela em
+ * torno da leitura atual e fica bloqueado no descritor de eventos do dispositivo (obtido com
+ * IIO_GET_EVENT_FD_IOCTL) em um epoll. O kernel só o acorda quando a leitura cruza um dos
+ * limiares, e o cliente então passa à taxa de rajada.
+ *
+ * O descritor entrega registros `iio_event_data` (código do evento e instante). A fonte
+ * simulada troca o descritor por um pipe com os mesmos registros, e um comparador em software
+ * faz o papel do ADC: o mesmo caminho de espera é exercitado sem o hardware.
+ */
+
+#ifndef EVENTOS_IIO_HPP
+#define EVENTOS_IIO_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/iio/events.h>
+#include <linux/iio/types.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+
+/**
+ * @brief Um cruzamento de limiar.
+ */
+struct EventoLimiar {
+    bool subida = false;     /**< true: a leitura subiu acima do limiar superior (mais claro). */
+    int64_t instanteNs = 0;  /**< Instante informado pelo driver (CLOCK_MONOTONIC, se aceito). */
+};
+
+/**
+ * @class EventosLimiarIIO
+ * @brief Janela de limiares de um canal do ADC e espera bloqueante pelos seus eventos.
+ */
+class EventosLimiarIIO {
+private:
+    /**< Descritor de eventos (ou ponta de leitura do pipe simulado) e epoll que o vigia. */
+    int fdEventos = -1;
+    int epfd = -1;
+
+    /**< Ponta de escrita do pipe da fonte simulada (-1 com o hardware). */
+    int fdSimulacao = -1;
+
+    /**< Diretório do dispositivo no sysfs e canal do ADC. */
+    std::string dirDispositivo;
+    unsigned canal = 0;
+
+    /**< Janela armada, em valores crus do ADC (-1: desarmada). */
+    int limiarDescida = -1;
+    int limiarSubida = -1;
+
+    /**< Eventos recebidos desde a abertura. */
+    uint64_t recebidos = 0;
+
+    int escreverAtributo(const std::string& nome, int valor) const {
+        std::string caminho = dirDispositivo + "/events/in_voltage" + std::to_string(canal) + "_thresh_" + nome;
+        int fd = open(caminho.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return -errno;
+        }
+        std::string texto = std::to_string(valor) + "\n";
+        int r = write(fd, texto.data(), texto.size()) < 0 ? -errno : 0;
+        close(fd);
+        return r;
+    }
+
+    int vigiar() {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (epfd < 0) {
+            return -errno;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fdEventos;
+        return epoll_ctl(epfd, EPOLL_CTL_ADD, fdEventos, &ev) < 0 ? -errno : 0;
+    }
+
+public:
+    EventosLimiarIIO() = default;
+    EventosLimiarIIO(const EventosLimiarIIO&) = delete;
+    EventosLimiarIIO& operator=(const EventosLimiarIIO&) = delete;
+
+    ~EventosLimiarIIO() {
+        fechar();
+    }
+
+    /**
+     * @brief Abre os eventos do canal @p canalAdc do dispositivo em @p dispositivo.
+     *
+     * @details Pede ao driver os instantes em CLOCK_MONOTONIC (se o atributo não existir, o
+     * instante segue o relógio padrão do dispositivo e só é informativo).
+     *
+     * @param dispositivo Diretório no sysfs (ex.: `/sys/bus/iio/devices/iio:device0`).
+     * @return 0 ou -errno (ENOTTY/ENODEV: o driver não tem eventos).
+     */
+    int abrir(const std::string& dispositivo, unsigned canalAdc) {
+        fechar();
+        dirDispositivo = dispositivo;
+        canal = canalAdc;
+        std::string nome = dispositivo.substr(dispositivo.find_last_of('/') + 1);
+        int fdDispositivo = open(("/dev/" + nome).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fdDispositivo < 0) {
+            return -errno;
+        }
+        int fd = -1;
+        int r = ioctl(fdDispositivo, IIO_GET_EVENT_FD_IOCTL, &fd) < 0 ? -errno : 0;
+        close(fdDispositivo);
+        if (r < 0) {
+            return r;
+        }
+        fdEventos = fd;
+        // O descritor vem bloqueante; a espera é feita no epoll, e a leitura só esvazia a fila.
+        fcntl(fdEventos, F_SETFL, fcntl(fdEventos, F_GETFL) | O_NONBLOCK);
+        int relogio = open((dispositivo + "/current_timestamp_clock").c_str(), O_WRONLY | O_CLOEXEC);
+        if (relogio >= 0) {
+            (void)!write(relogio, "monotonic\n", 10);
+            close(relogio);
+        }
+        return vigiar();
+    }
+
+    /**
+     * @brief Abre uma fonte simulada: os eventos vêm de simularLeitura().
+     * @return 0 ou -errno.
+     */
+    int abrirSimulada(unsigned canalAdc = 0) {
+        fechar();
+        canal = canalAdc;
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) < 0) {
+            return -errno;
+        }
+        fdEventos = fds[0];
+        fdSimulacao = fds[1];
+        return vigiar();
+    }
+
+    /** @brief Fecha os descritores. */
+    void fechar() {
+        for (int* fd : {&epfd, &fdEventos, &fdSimulacao}) {
+            if (*fd >= 0) {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+        limiarDescida = limiarSubida = -1;
+    }
+
+    /** @brief true se aberto. */
+    bool ativo() const { return epfd >= 0; }
+
+    /**
+     * @brief Arma a janela [@p descida, @p subida] (valores crus do ADC).
+     *
+     * @details Desliga os eventos antes de trocar os limiares, para o driver não comparar com
+     * uma janela pela metade, e os liga de novo em seguida.
+     *
+     * @return 0 ou -errno.
+     */
+    int armar(int descida, int subida) {
+        if (fdSimulacao < 0) {
+            int r = 0;
+            for (const char* en : {"rising_en", "falling_en"}) {
+                if (r == 0) {
+                    r = escreverAtributo(en, 0);
+                }
+            }
+            if (r == 0) {
+                r = escreverAtributo("rising_value", subida);
+            }
+            if (r == 0) {
+                r = escreverAtributo("falling_value", descida);
+            }
+            for (const char* en : {"rising_en", "falling_en"}) {
+                if (r == 0) {
+                    r = escreverAtributo(en, 1);
+                }
+            }
+            if (r < 0) {
+                return r;
+            }
+        }
+        limiarDescida = descida;
+        limiarSubida = subida;
+        return 0;
+    }
+
+    /**
+     * @brief Bloqueia até um evento ou até @p prazoNs (CLOCK_MONOTONIC).
+     * @return 1 com @p evento preenchido, 0 no prazo ou -errno.
+     */
+    int aguardar(uint64_t prazoNs, EventoLimiar& evento) {
+        while (true) {
+            iio_event_data dados;
+            ssize_t n = read(fdEventos, &dados, sizeof(dados));
+            if (n == static_cast<ssize_t>(sizeof(dados))) {
+                uint64_t direcao = IIO_EVENT_CODE_EXTRACT_DIR(dados.id);
+                if (direcao != IIO_EV_DIR_RISING && direcao != IIO_EV_DIR_FALLING) {
+                    continue;
+                }
+                evento.subida = direcao == IIO_EV_DIR_RISING;
+                evento.instanteNs = dados.timestamp;
+                recebidos++;
+                return 1;
+            }
+            if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                return -errno;
+            }
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            uint64_t agora = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+            if (agora >= prazoNs) {
+                return 0;
+            }
+            // Arredonda para cima: acordar antes do prazo só gastaria outra chamada.
+            int espera = static_cast<int>((prazoNs - agora + 999999) / 1000000);
+            epoll_event ev;
+            if (epoll_wait(epfd, &ev, 1, espera) < 0 && errno != EINTR) {
+                return -errno;
+            }
+        }
+    }
+
+    /**
+     * @brief Descarta os eventos acumulados (ex.: durante a rajada, com a janela antiga).
+     * @return Eventos descartados.
+     */
+    uint64_t descartarPendentes() {
+        uint64_t n = 0;
+        iio_event_data dados;
+        while (read(fdEventos, &dados, sizeof(dados)) == static_cast<ssize_t>(sizeof(dados))) {
+            n++;
+        }
+        return n;
+    }
+
+    /**
+     * @brief Comparador da fonte simulada: gera um evento se @p bruto está fora da janela armada.
+     * @return true se gerou um evento.
+     */
+    bool simularLeitura(int bruto, int64_t instanteNs) {
+        if (fdSimulacao < 0 || limiarSubida < 0) {
+            return false;
+        }
+        uint64_t direcao;
+        if (bruto > limiarSubida) {
+            direcao = IIO_EV_DIR_RISING;
+        } else if (bruto < limiarDescida) {
+            direcao = IIO_EV_DIR_FALLING;
+        } else {
+            return false;
+        }
+        iio_event_data dados;
+        dados.id = (static_cast<uint64_t>(IIO_EV_TYPE_THRESH) << 56) | (direcao << 48) |
+                   (static_cast<uint64_t>(IIO_VOLTAGE) << 32) | canal;
+        dados.timestamp = instanteNs;
+        // Como um comparador com borda, um cruzamento só dispara uma vez por janela armada.
+        limiarDescida = limiarSubida = -1;
+        return write(fdSimulacao, &dados, sizeof(dados)) == static_cast<ssize_t>(sizeof(dados));
+    }
+
+    /** @brief Limiar inferior armado (-1: desarmada). */
+    int limiarDescidaAtual() const { return limiarDescida; }
+
+    /** @brief Limiar superior armado (-1: desarmada). */
+    int limiarSubidaAtual() const { return limiarSubida; }
+
+    /** @brief Eventos recebidos desde a abertura. */
+    uint64_t eventosRecebidos() const { return recebidos; }
+};
+
+#endif // EVENTOS_IIO_HPP
@@ -0,0 +1,323 @@
+/**
+ * @file fec_udp.hpp
+ * @brief Correção antecipada de erros (FEC) para os datagramas binários: paridade XOR intercalada.
+ *
+ * @details Em enlaces com perda (Wi-Fi industrial), a retransmissão custa pelo menos uma ida e
+ * volta, o que é demais para os alertas de violação. No modo FEC o remetente (CodificadorFec)
+ * agrupa cada `k` datagramas consecutivos de um sensor e envia, logo após o grupo, `m` pacotes de
+ * reparo: o reparo j é o XOR dos datagramas de índice j, j + m, j + 2m... do grupo. O coletor
+ * (RecuperadorFec) guarda uma cópia dos últimos datagramas FEC recebidos de cada sensor e, quando
+ * falta exatamente um dos datagramas cobertos por um reparo, o reconstrói sem esperar nada do
+ * remetente.
+ *
+ * A intercalação faz com que uma rajada de até `m` perdas consecutivas no grupo seja corrigida
+ * (cada perda cai em um reparo diferente). O custo é `m / k` em pacotes, mais o cabeçalho do
+ * reparo. Um datagrama reconstruído é entregue depois dos que chegaram no grupo, e fora de ordem.
+ */
+
+#ifndef FEC_UDP_HPP
+#define FEC_UDP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "protocolo_ldr.hpp"
+
+/** @def FEC_MAX_K
+ * @brief Maior número de datagramas de um grupo.
+ */
+#define FEC_MAX_K 32
+
+/** @def FEC_MAX_M
+ * @brief Maior número de pacotes de reparo de um grupo.
+ */
+#define FEC_MAX_M 8
+
+/** @def FEC_TAMANHO_DATAGRAMA
+ * @brief Maior datagrama binário protegido (cabeçalho e LDR_MAX_AMOSTRAS_DATAGRAMA amostras).
+ */
+#define FEC_TAMANHO_DATAGRAMA (sizeof(CabecalhoLDR) + LDR_MAX_AMOSTRAS_DATAGRAMA * sizeof(AmostraWireLDR))
+
+/** @def FEC_TAMANHO_REPARO
+ * @brief Maior pacote de reparo.
+ */
+#define FEC_TAMANHO_REPARO (sizeof(CabecalhoFecLDR) + FEC_MAX_K * sizeof(uint32_t) + FEC_TAMANHO_DATAGRAMA)
+
+/** @def FEC_GUARDADOS
+ * @brief Datagramas recentes guardados por sensor pelo coletor (cobre dois grupos de FEC_MAX_K).
+ */
+#define FEC_GUARDADOS (2 * FEC_MAX_K)
+
+/**
+ * @brief Indica se @p dados é um pacote de reparo.
+ */
+inline bool ehReparoFec(const char* dados, size_t tamanho) {
+    uint16_t magia;
+    if (tamanho < sizeof(CabecalhoFecLDR)) {
+        return false;
+    }
+    memcpy(&magia, dados, sizeof(magia));
+    return ntohs(magia) == LDR_MAGIA_FEC;
+}
+
+/**
+ * @class CodificadorFec
+ * @brief Lado do remetente: acumula a paridade dos datagramas e emite os pacotes de reparo.
+ *
+ * @details Cada grupo pertence a um único sensor: um datagrama de outro sensor fecha o grupo
+ * em andamento. Sem alocação; a paridade é acumulada à medida que os datagramas são enviados.
+ */
+class CodificadorFec {
+private:
+    /**< Parâmetros do grupo. */
+    uint32_t k;
+    uint32_t m;
+
+    /**< Grupo em andamento: número, sensor, datagramas acumulados e as suas sequências. */
+    uint32_t grupo = 0;
+    uint32_t idSensor = 0;
+    uint32_t contidos = 0;
+    uint32_t seqs[FEC_MAX_K];
+
+    /**< Paridade de cada reparo: XOR dos tamanhos, maior tamanho e bytes. */
+    uint16_t tamanhos[FEC_MAX_M];
+    uint16_t maiores[FEC_MAX_M];
+    char paridade[FEC_MAX_M][FEC_TAMANHO_DATAGRAMA];
+
+    /**< Contadores. */
+    uint64_t reparos = 0;
+    uint64_t bytesReparo = 0;
+
+public:
+    /**
+     * @brief Construtor.
+     * @param datagramas Datagramas por grupo (k, 1 a FEC_MAX_K).
+     * @param reparosPorGrupo Pacotes de reparo por grupo (m, 1 a FEC_MAX_M e no máximo k).
+     */
+    CodificadorFec(uint32_t datagramas, uint32_t reparosPorGrupo)
+        : k(std::clamp<uint32_t>(datagramas, 1, FEC_MAX_K)),
+          m(std::clamp<uint32_t>(reparosPorGrupo, 1, std::min<uint32_t>(FEC_MAX_M, k))) {
+        memset(tamanhos, 0, sizeof(tamanhos));
+        memset(maiores, 0, sizeof(maiores));
+        memset(paridade, 0, sizeof(paridade));
+    }
+
+    /**
+     * @brief Acrescenta ao grupo um datagrama binário recém-enviado (com LDR_FLAG_FEC).
+     * @param enviar Função `void(const char* dados, size_t tamanho)` chamada com cada pacote de
+     * reparo quando o grupo se completa.
+     */
+    template <typename Funcao>
+    void adicionar(const char* datagrama, size_t tamanho, Funcao&& enviar) {
+        CabecalhoLDR cab;
+        if (tamanho < sizeof(cab) || tamanho > FEC_TAMANHO_DATAGRAMA) {
+            return;
+        }
+        memcpy(&cab, datagrama, sizeof(cab));
+        uint32_t id = ntohl(cab.id_sensor);
+        if (contidos > 0 && id != idSensor) {
+            descarregar(enviar);
+        }
+        idSensor = id;
+        uint32_t j = contidos % m;
+        for (size_t i = 0; i < tamanho; i++) {
+            paridade[j][i] ^= datagrama[i];
+        }
+        tamanhos[j] ^= static_cast<uint16_t>(tamanho);
+        maiores[j] = std::max<uint16_t>(maiores[j], static_cast<uint16_t>(tamanho));
+        seqs[contidos++] = ntohl(cab.seq);
+        if (contidos == k) {
+            descarregar(enviar);
+        }
+    }
+
+    /**
+     * @brief Emite os reparos do grupo em andamento, mesmo incompleto, e inicia o próximo.
+     */
+    template <typename Funcao>
+    void descarregar(Funcao&& enviar) {
+        if (contidos == 0) {
+            return;
+        }
+        char pacote[FEC_TAMANHO_REPARO];
+        uint32_t emitir = std::min(m, contidos);
+        for (uint32_t j = 0; j < emitir; j++) {
+            CabecalhoFecLDR cab{};
+            cab.magia = htons(LDR_MAGIA_FEC);
+            cab.versao = LDR_VERSAO;
+            cab.indice = static_cast<uint8_t>(j);
+            cab.id_sensor = htonl(idSensor);
+            cab.grupo = htonl(grupo);
+            cab.k = static_cast<uint8_t>(contidos);
+            cab.m = static_cast<uint8_t>(m);
+            cab.tamanho = htons(tamanhos[j]);
+            memcpy(pacote, &cab, sizeof(cab));
+            char* p = pacote + sizeof(cab);
+            for (uint32_t i = 0; i < contidos; i++, p += sizeof(uint32_t)) {
+                uint32_t seq = htonl(seqs[i]);
+                memcpy(p, &seq, sizeof(seq));
+            }
+            memcpy(p, paridade[j], maiores[j]);
+            size_t total = static_cast<size_t>(p - pacote) + maiores[j];
+            enviar(static_cast<const char*>(pacote), total);
+            reparos++;
+            bytesReparo += total;
+            memset(paridade[j], 0, maiores[j]);
+            tamanhos[j] = 0;
+            maiores[j] = 0;
+        }
+        contidos = 0;
+        grupo++;
+    }
+
+    /** @brief Pacotes de reparo emitidos. */
+    uint64_t reparosEnviados() const { return reparos; }
+
+    /** @brief Bytes de reparo emitidos. */
+    uint64_t bytesReparoEnviados() const { return bytesReparo; }
+};
+
+/**
+ * @class RecuperadorFec
+ * @brief Lado do coletor: guarda os datagramas FEC recentes e reconstrói os perdidos.
+ *
+ * @details Acessado apenas pelo thread do laço de recepção. A memória de um sensor
+ * (FEC_GUARDADOS cópias) só é alocada quando ele envia o primeiro datagrama FEC.
+ */
+class RecuperadorFec {
+private:
+    /** @brief Cópia de um datagrama recebido. */
+    struct Guardado {
+        uint32_t seq;                          /**< Sequência do datagrama. */
+        uint16_t tamanho;                      /**< Bytes em dados (0: posição livre). */
+        char dados[FEC_TAMANHO_DATAGRAMA];
+    };
+
+    /** @brief Datagramas recentes de um sensor, em anel. */
+    struct Sensor {
+        uint32_t proximo = 0;                  /**< Próxima posição a sobrescrever. */
+        Guardado guardados[FEC_GUARDADOS] = {};
+    };
+
+    /**< Sensores e índice por identificador. */
+    std::vector<std::unique_ptr<Sensor>> sensores;
+    std::unordered_map<uint32_t, uint32_t> indices;
+
+    /**< Datagrama reconstruído (entregue antes do próximo reparo). */
+    char reconstruido[FEC_TAMANHO_DATAGRAMA];
+
+    /**< Contadores (lidos por outros threads). */
+    std::atomic<uint64_t> recuperados{0};
+    std::atomic<uint64_t> irrecuperaveis{0};
+
+    static void somar(std::atomic<uint64_t>& c, uint64_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    Sensor* procurar(uint32_t id) {
+        auto it = indices.find(id);
+        return it != indices.end() ? sensores[it->second].get() : nullptr;
+    }
+
+    static const Guardado* localizar(const Sensor& s, uint32_t seq) {
+        for (const Guardado& g : s.guardados) {
+            if (g.tamanho != 0 && g.seq == seq) {
+                return &g;
+            }
+        }
+        return nullptr;
+    }
+
+public:
+    /**
+     * @brief Guarda a cópia de um datagrama binário recebido com LDR_FLAG_FEC.
+     */
+    void guardar(const char* datagrama, size_t tamanho, uint32_t id_sensor, uint32_t seq) {
+        if (tamanho == 0 || tamanho > FEC_TAMANHO_DATAGRAMA) {
+            return;
+        }
+        Sensor* s = procurar(id_sensor);
+        if (s == nullptr) {
+            indices.emplace(id_sensor, static_cast<uint32_t>(sensores.size()));
+            sensores.push_back(std::make_unique<Sensor>());
+            s = sensores.back().get();
+        }
+        Guardado& g = s->guardados[s->proximo++ % FEC_GUARDADOS];
+        g.seq = seq;
+        g.tamanho = static_cast<uint16_t>(tamanho);
+        memcpy(g.dados, datagrama, tamanho);
+    }
+
+    /**
+     * @brief Trata um pacote de reparo: se falta exatamente um dos datagramas cobertos, reconstrói-o.
+     * @param entregar Função `void(const char* dados, size_t tamanho)` chamada com o datagrama
+     * reconstruído (que deve ser processado como se tivesse sido recebido).
+     * @return true se um datagrama foi reconstruído.
+     */
+    template <typename Funcao>
+    bool reparar(const char* pacote, size_t tamanho, Funcao&& entregar) {
+        CabecalhoFecLDR cab;
+        memcpy(&cab, pacote, sizeof(cab));
+        size_t inicioParidade = sizeof(cab) + cab.k * sizeof(uint32_t);
+        if (cab.versao != LDR_VERSAO || cab.k == 0 || cab.k > FEC_MAX_K || cab.m == 0 || cab.indice >= cab.m ||
+            tamanho < inicioParidade || tamanho - inicioParidade > FEC_TAMANHO_DATAGRAMA) {
+            return false;
+        }
+        size_t largura = tamanho - inicioParidade;
+        Sensor* s = procurar(ntohl(cab.id_sensor));
+        uint32_t faltantes = 0;
+        uint32_t seqFaltante = 0;
+        uint16_t tamanhoFaltante = ntohs(cab.tamanho);
+        memcpy(reconstruido, pacote + inicioParidade, largura);
+        for (uint32_t i = cab.indice; i < cab.k; i += cab.m) {
+            uint32_t seq;
+            memcpy(&seq, pacote + sizeof(cab) + i * sizeof(uint32_t), sizeof(seq));
+            seq = ntohl(seq);
+            const Guardado* g = s != nullptr ? localizar(*s, seq) : nullptr;
+            if (g == nullptr) {
+                faltantes++;
+                seqFaltante = seq;
+                continue;
+            }
+            if (g->tamanho > largura) {
+                return false;
+            }
+            for (size_t b = 0; b < g->tamanho; b++) {
+                reconstruido[b] ^= g->dados[b];
+            }
+            tamanhoFaltante ^= g->tamanho;
+        }
+        if (faltantes != 1) {
+            if (faltantes > 1) {
+                somar(irrecuperaveis, faltantes);
+            }
+            return false;
+        }
+        CabecalhoLDR dados;
+        if (tamanhoFaltante < sizeof(dados) || tamanhoFaltante > largura) {
+            somar(irrecuperaveis, 1);
+            return false;
+        }
+        memcpy(&dados, reconstruido, sizeof(dados));
+        if (ntohl(dados.seq) != seqFaltante) {
+            somar(irrecuperaveis, 1);
+            return false;
+        }
+        somar(recuperados, 1);
+        entregar(static_cast<const char*>(reconstruido), static_cast<size_t>(tamanhoFaltante));
+        return true;
+    }
+
+    /** @brief Datagramas reconstruídos a partir dos reparos. */
+    uint64_t datagramasRecuperados() const { return recuperados.load(std::memory_order_relaxed); }
+
+    /** @brief Datagramas perdidos que um reparo não pôde reconstruir (mais de um faltante). */
+    uint64_t datagramasIrrecuperaveis() const { return irrecuperaveis.load(std::memory_order_relaxed); }
+};
+
+#endif // FEC_UDP_HPP
@@ -0,0 +1,79 @@
+/**
+ * @file fila_spsc.hpp
+ * @brief Fila circular sem trava de um produtor e um consumidor (SPSC), de capacidade fixa.
+ *
+ * @details Usada entre o thread de amostragem e o de transmissão do cliente: o produtor nunca
+ * bloqueia nem aloca (com a fila cheia, colocar() falha e o chamador conta o descarte). Cada
+ * lado só escreve o seu índice; o outro é lido com acquire e guardado em cache, de modo que a
+ * linha de cache do índice alheio só é revisitada quando a fila parece cheia (ou vazia).
+ */
+
+#ifndef FILA_SPSC_HPP
+#define FILA_SPSC_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class FilaSpsc
+ * @brief Fila de @p CAPACIDADE elementos (potência de 2) de um produtor para um consumidor.
+ */
+template <typename T, size_t CAPACIDADE>
+class FilaSpsc {
+private:
+    static_assert((CAPACIDADE & (CAPACIDADE - 1)) == 0, "CAPACIDADE deve ser potencia de 2");
+
+    /**< Elementos. */
+    T elementos[CAPACIDADE];
+
+    /**< Posição de escrita (produtor) e cópia local da de leitura. */
+    alignas(64) std::atomic<uint64_t> cabeca{0};
+    uint64_t caudaConhecida = 0;
+
+    /**< Posição de leitura (consumidor) e cópia local da de escrita. */
+    alignas(64) std::atomic<uint64_t> cauda{0};
+    uint64_t cabecaConhecida = 0;
+
+public:
+    /**
+     * @brief Coloca @p valor na fila (só o produtor chama).
+     * @return false com a fila cheia.
+     */
+    bool colocar(const T& valor) {
+        uint64_t h = cabeca.load(std::memory_order_relaxed);
+        if (h - caudaConhecida == CAPACIDADE) {
+            caudaConhecida = cauda.load(std::memory_order_acquire);
+            if (h - caudaConhecida == CAPACIDADE) {
+                return false;
+            }
+        }
+        elementos[h & (CAPACIDADE - 1)] = valor;
+        cabeca.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Retira o elemento mais antigo para @p valor (só o consumidor chama).
+     * @return false com a fila vazia.
+     */
+    bool retirar(T& valor) {
+        uint64_t t = cauda.load(std::memory_order_relaxed);
+        if (t == cabecaConhecida) {
+            cabecaConhecida = cabeca.load(std::memory_order_acquire);
+            if (t == cabecaConhecida) {
+                return false;
+            }
+        }
+        valor = elementos[t & (CAPACIDADE - 1)];
+        cauda.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Elementos na fila (aproximado se lido por um terceiro thread). */
+    size_t tamanho() const {
+        return static_cast<size_t>(cabeca.load(std::memory_order_acquire) - cauda.load(std::memory_order_acquire));
+    }
+};
+
+#endif // FILA_SPSC_HPP
@@ -0,0 +1,540 @@
+/**
+ * @file gateway_lotes.hpp
+ * @brief Modo gateway do coletor: as amostras de muitas placas saem em lotes comprimidos por janela.
+ *
+ * @details Cada placa envia ao coletor central um datagrama por leitura (ou por poucas leituras):
+ * com centenas de placas, o central recebe milhares de pacotes por segundo, cada um com 24 bytes
+ * de cabeçalho para 8 de amostra. Um coletor local em modo gateway recebe as placas próximas
+ * (com todo o processamento habitual) e, como um assinante do anel de difusão, junta as
+ * amostras de todos os sensores por janela de tempo e as repassa ao central por um único fluxo
+ * UDP, em lotes comprimidos de até GATEWAY_TAMANHO_LOTE bytes.
+ *
+ * Layout do lote: CabecalhoLoteLDR seguido de blocos de amostras consecutivas (sequências
+ * seguidas) de um mesmo sensor:
+ * - varint `id_sensor`, varint `seq` da primeira amostra, varint `taxa_dhz`;
+ * - varint zigzag do instante da primeira amostra menos `t_base_ns` (ns);
+ * - 1 byte com o número de amostras (1 a LDR_MAX_AMOSTRAS_DATAGRAMA);
+ * - varint zigzag do primeiro valor;
+ * - para cada amostra seguinte, varint zigzag da diferença entre o seu intervalo para a anterior e
+ *   o intervalo anterior (µs), e varint zigzag da diferença de valor.
+ *
+ * Com a amostragem regular e a luminosidade variando pouco, cada amostra ocupa cerca de 2
+ * bytes. A sequência de cada sensor é preservada; os instantes, com a resolução de µs dos
+ * deslocamentos do datagrama binário. O coletor central decodifica os lotes no próprio laço de
+ * recepção e entrega cada bloco como se fosse um datagrama da placa.
+ */
+
+#ifndef GATEWAY_LOTES_HPP
+#define GATEWAY_LOTES_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "difusao_amostras.hpp"
+#include "log_assincrono.hpp"
+#include "protocolo_ldr.hpp"
+
+/** @def GATEWAY_TAMANHO_LOTE
+ * @brief Tamanho máximo de um lote (cabe em um quadro Ethernet sem fragmentação).
+ */
+#define GATEWAY_TAMANHO_LOTE 1400
+
+/** @def GATEWAY_JANELA_PADRAO_MS
+ * @brief Janela padrão de agregação (ms).
+ */
+#define GATEWAY_JANELA_PADRAO_MS 100
+
+/** @def GATEWAY_MAX_PENDENTES
+ * @brief Amostras retidas em uma janela; ao atingi-las, a janela é fechada antes do prazo.
+ */
+#define GATEWAY_MAX_PENDENTES 65536
+
+/** @def GATEWAY_LOTES_POR_ENVIO
+ * @brief Lotes enviados por chamada a sendmmsg().
+ */
+#define GATEWAY_LOTES_POR_ENVIO 32
+
+/** @brief Escreve @p v como varint (7 bits por byte, o menos significativo primeiro). */
+inline char* escreverVarint(char* p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = static_cast<char>(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<char>(v);
+    return p;
+}
+
+/**
+ * @brief Lê um varint de [@p p, @p fim).
+ * @return Posição seguinte, ou nulo se o varint está truncado ou passa de 64 bits.
+ */
+inline const char* lerVarint(const char* p, const char* fim, uint64_t& v) {
+    v = 0;
+    for (unsigned deslocamento = 0; p < fim && deslocamento < 64; deslocamento += 7) {
+        uint8_t b = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(b & 0x7F) << deslocamento;
+        if ((b & 0x80) == 0) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+/** @brief Mapeia um inteiro com sinal em um sem sinal pequeno para módulos pequenos (zigzag). */
+inline uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+/** @brief Inverso de zigzag(). */
+inline int64_t desfazerZigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+/**
+ * @class CodificadorLoteLDR
+ * @brief Monta um lote comprimido, amostra a amostra, em um buffer do chamador.
+ *
+ * @details As amostras devem chegar agrupadas por sensor e, dentro de um sensor, em ordem de
+ * sequência; um novo bloco começa a cada troca de sensor ou de taxa, lacuna de sequência,
+ * instante anterior ao início do bloco ou bloco cheio.
+ */
+class CodificadorLoteLDR {
+private:
+    /**< Maior bloco novo: três varints de 32 bits, um de 64, o contador e o primeiro valor. */
+    static constexpr size_t PIOR_BLOCO = 5 + 5 + 3 + 10 + 1 + 5;
+
+    /**< Maior amostra em um bloco aberto. */
+    static constexpr size_t PIOR_AMOSTRA = 10 + 5;
+
+    char* destino = nullptr;
+    size_t capacidade = 0;
+    char* p = nullptr;
+    uint32_t idGateway = 0;
+    uint32_t seqLote = 0;
+    uint16_t blocos = 0;
+    uint16_t amostras = 0;
+    uint64_t tBase = 0;
+
+    /**< Bloco aberto: posição do contador, primeira e última amostra, último intervalo (µs). */
+    uint8_t* contador = nullptr;
+    AmostraLDR inicio{};
+    AmostraLDR ultima{};
+    uint16_t taxa = 0;
+    uint64_t ultimoDtUs = 0;
+    int64_t intervaloUs = 0;
+
+public:
+    /** @brief Começa um lote vazio em @p buffer (pelo menos sizeof(CabecalhoLoteLDR) + PIOR_BLOCO bytes). */
+    void iniciar(char* buffer, size_t tamanho, uint32_t gateway, uint32_t seq) {
+        destino = buffer;
+        capacidade = tamanho;
+        p = buffer + sizeof(CabecalhoLoteLDR);
+        idGateway = gateway;
+        seqLote = seq;
+        blocos = 0;
+        amostras = 0;
+        contador = nullptr;
+    }
+
+    /**
+     * @brief Acrescenta uma amostra ao lote.
+     * @return false se o lote está cheio (a amostra não foi incluída).
+     */
+    bool anexar(const AmostraLDR& a, uint16_t taxaDhz) {
+        if (amostras == 0) {
+            tBase = a.t_ns;
+        }
+        bool continua = contador != nullptr && *contador < LDR_MAX_AMOSTRAS_DATAGRAMA &&
+                        a.id_sensor == inicio.id_sensor && a.seq == ultima.seq + 1 && taxaDhz == taxa &&
+                        a.t_ns >= inicio.t_ns;
+        if (continua) {
+            if (p + PIOR_AMOSTRA > destino + capacidade) {
+                return false;
+            }
+            uint64_t dtUs = (a.t_ns - inicio.t_ns) / 1000ull;
+            int64_t intervalo = static_cast<int64_t>(dtUs - ultimoDtUs);
+            p = escreverVarint(p, zigzag(intervalo - intervaloUs));
+            p = escreverVarint(p, zigzag(static_cast<int64_t>(a.valor) - ultima.valor));
+            ultimoDtUs = dtUs;
+            intervaloUs = intervalo;
+            (*contador)++;
+        } else {
+            if (p + PIOR_BLOCO > destino + capacidade || blocos == UINT16_MAX) {
+                return false;
+            }
+            p = escreverVarint(p, a.id_sensor);
+            p = escreverVarint(p, a.seq);
+            p = escreverVarint(p, taxaDhz);
+            p = escreverVarint(p, zigzag(static_cast<int64_t>(a.t_ns - tBase)));
+            contador = reinterpret_cast<uint8_t*>(p++);
+            *contador = 1;
+            p = escreverVarint(p, zigzag(a.valor));
+            inicio = a;
+            taxa = taxaDhz;
+            ultimoDtUs = 0;
+            intervaloUs = 0;
+            blocos++;
+        }
+        ultima = a;
+        amostras++;
+        return true;
+    }
+
+    /** @brief Amostras no lote. */
+    uint16_t totalAmostras() const { return amostras; }
+
+    /**
+     * @brief Escreve o cabeçalho e encerra o lote.
+     * @return Tamanho do lote (0 se vazio).
+     */
+    size_t finalizar() {
+        if (amostras == 0) {
+            return 0;
+        }
+        CabecalhoLoteLDR cab{};
+        cab.magia = htons(LDR_MAGIA_LOTE);
+        cab.versao = LDR_VERSAO;
+        cab.id_gateway = htonl(idGateway);
+        cab.seq = htonl(seqLote);
+        cab.n_blocos = htons(blocos);
+        cab.n_amostras = htons(amostras);
+        cab.t_base_ns = htobe64(tBase);
+        memcpy(destino, &cab, sizeof(cab));
+        return static_cast<size_t>(p - destino);
+    }
+};
+
+/**
+ * @brief true se o datagrama começa com o cabeçalho de um lote de gateway.
+ */
+inline bool ehLoteGateway(const char* dados, size_t tamanho) {
+    uint16_t magia;
+    if (tamanho < sizeof(CabecalhoLoteLDR)) {
+        return false;
+    }
+    memcpy(&magia, dados, sizeof(magia));
+    return ntohs(magia) == LDR_MAGIA_LOTE;
+}
+
+/**
+ * @brief Decodifica um lote comprimido, entregando cada bloco a @p entregar.
+ *
+ * @param entregar Função `void(const AmostraLDR* amostras, size_t n, uint16_t taxaDhz)`, chamada
+ * com até LDR_MAX_AMOSTRAS_DATAGRAMA amostras de um sensor.
+ * @param idGateway Recebe o identificador do gateway, se não for nulo.
+ * @return Amostras entregues, ou -1 se o lote é inválido (os blocos anteriores ao erro já foram entregues).
+ */
+template <typename Funcao>
+inline long decodificarLoteGateway(const char* dados, size_t tamanho, Funcao&& entregar,
+                                   uint32_t* idGateway = nullptr) {
+    CabecalhoLoteLDR cab;
+    if (!ehLoteGateway(dados, tamanho)) {
+        return -1;
+    }
+    memcpy(&cab, dados, sizeof(cab));
+    if (cab.versao != LDR_VERSAO) {
+        return -1;
+    }
+    if (idGateway != nullptr) {
+        *idGateway = ntohl(cab.id_gateway);
+    }
+    uint64_t tBase = be64toh(cab.t_base_ns);
+    const char* p = dados + sizeof(cab);
+    const char* fim = dados + tamanho;
+    long total = 0;
+    AmostraLDR bloco[LDR_MAX_AMOSTRAS_DATAGRAMA];
+    for (uint16_t b = 0, blocos = ntohs(cab.n_blocos); b < blocos; b++) {
+        uint64_t id, seq, taxa, t0, valor;
+        if ((p = lerVarint(p, fim, id)) == nullptr || (p = lerVarint(p, fim, seq)) == nullptr ||
+            (p = lerVarint(p, fim, taxa)) == nullptr || (p = lerVarint(p, fim, t0)) == nullptr || p == fim) {
+            return -1;
+        }
+        uint8_t n = static_cast<uint8_t>(*p++);
+        if (n == 0 || n > LDR_MAX_AMOSTRAS_DATAGRAMA || (p = lerVarint(p, fim, valor)) == nullptr) {
+            return -1;
+        }
+        bloco[0].t_ns = tBase + static_cast<uint64_t>(desfazerZigzag(t0));
+        bloco[0].id_sensor = static_cast<uint32_t>(id);
+        bloco[0].seq = static_cast<uint32_t>(seq);
+        bloco[0].valor = static_cast<int32_t>(desfazerZigzag(valor));
+        int64_t dtUs = 0, intervaloUs = 0;
+        for (uint8_t i = 1; i < n; i++) {
+            uint64_t dod, dv;
+            if ((p = lerVarint(p, fim, dod)) == nullptr || (p = lerVarint(p, fim, dv)) == nullptr) {
+                return -1;
+            }
+            intervaloUs += desfazerZigzag(dod);
+            dtUs += intervaloUs;
+            bloco[i].t_ns = bloco[0].t_ns + static_cast<uint64_t>(dtUs) * 1000ull;
+            bloco[i].id_sensor = bloco[0].id_sensor;
+            bloco[i].seq = bloco[0].seq + i;
+            bloco[i].valor = static_cast<int32_t>(bloco[i - 1].valor + desfazerZigzag(dv));
+        }
+        entregar(static_cast<const AmostraLDR*>(bloco), static_cast<size_t>(n), static_cast<uint16_t>(taxa));
+        total += n;
+    }
+    return p == fim && total == ntohs(cab.n_amostras) ? total : -1;
+}
+
+/**
+ * @class GatewayLotes
+ * @brief Assinante do anel de difusão que agrega as amostras por janela e as repassa em lotes.
+ *
+ * @details Um thread próprio lê o anel (como o ServidorDifusao) e acumula as amostras da janela
+ * corrente, que começa com a primeira amostra lida e dura `janelaMs`. No fechamento, as amostras
+ * são ordenadas por sensor (ordenação estável: cada sensor mantém a ordem de chegada),
+ * codificadas em lotes e enviadas por um socket UDP conectado ao coletor central, até
+ * GATEWAY_LOTES_POR_ENVIO lotes por sendmmsg(). O gateway não retransmite: um lote perdido
+ * aparece como lacuna na sequência dos lotes e das amostras de cada sensor.
+ */
+class GatewayLotes {
+private:
+    /** @brief Amostra retida na janela, com a taxa informada no seu datagrama. */
+    struct Pendente {
+        AmostraLDR amostra;
+        uint16_t taxaDhz;
+    };
+
+    /**< Anel de origem e a posição de leitura (tomada em iniciar(), antes do thread partir). */
+    const AnelDifusao& anel;
+    CursorDifusao cursor;
+
+    /**< Socket conectado ao coletor central e identificador deste gateway. */
+    int sock = -1;
+    uint32_t idGateway = 0;
+
+    /**< Duração da janela (ns). */
+    uint64_t janelaNs = GATEWAY_JANELA_PADRAO_MS * 1000000ull;
+
+    /**< Thread de agregação. */
+    std::thread thread;
+    std::atomic<bool> ativo{false};
+
+    /**< Amostras da janela corrente (capacidade reservada na partida) e lotes a enviar. */
+    std::vector<Pendente> pendentes;
+    std::vector<char> saida;
+    uint32_t proximoLote = 0;
+
+    /**< Contadores (escritos pelo thread do gateway). */
+    std::atomic<uint64_t> registros{0};
+    std::atomic<uint64_t> bytesEntrada{0};
+    std::atomic<uint64_t> amostrasEntrada{0};
+    std::atomic<uint64_t> janelas{0};
+    std::atomic<uint64_t> lotes{0};
+    std::atomic<uint64_t> bytesSaida{0};
+    std::atomic<uint64_t> amostrasSaida{0};
+    std::atomic<uint64_t> falhas{0};
+    std::atomic<uint64_t> perdidos{0};
+
+    static uint64_t agora() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    static void somar(std::atomic<uint64_t>& c, uint64_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /** @brief Envia os @p n primeiros lotes de saida, de @p tamanhos bytes. */
+    void enviar(const size_t* tamanhos, unsigned n, const uint16_t* amostras) {
+        mmsghdr msgs[GATEWAY_LOTES_POR_ENVIO] = {};
+        iovec iovs[GATEWAY_LOTES_POR_ENVIO];
+        for (unsigned i = 0; i < n; i++) {
+            iovs[i] = iovec{saida.data() + i * GATEWAY_TAMANHO_LOTE, tamanhos[i]};
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        unsigned enviados = 0;
+        while (enviados < n) {
+            int r = sendmmsg(sock, msgs + enviados, n - enviados, 0);
+            if (r < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // Lote descartado (ex.: ECONNREFUSED com o central fora do ar); segue com o próximo.
+                somar(falhas, 1);
+                enviados++;
+                continue;
+            }
+            for (int i = 0; i < r; i++) {
+                somar(lotes, 1);
+                somar(bytesSaida, tamanhos[enviados + i]);
+                somar(amostrasSaida, amostras[enviados + i]);
+            }
+            enviados += static_cast<unsigned>(r);
+        }
+    }
+
+    /** @brief Codifica e envia as amostras da janela corrente. */
+    void fecharJanela() {
+        if (pendentes.empty()) {
+            return;
+        }
+        std::stable_sort(pendentes.begin(), pendentes.end(), [](const Pendente& a, const Pendente& b) {
+            return a.amostra.id_sensor < b.amostra.id_sensor;
+        });
+        size_t tamanhos[GATEWAY_LOTES_POR_ENVIO];
+        uint16_t amostras[GATEWAY_LOTES_POR_ENVIO];
+        unsigned n = 0;
+        CodificadorLoteLDR codificador;
+        codificador.iniciar(saida.data(), GATEWAY_TAMANHO_LOTE, idGateway, proximoLote++);
+        for (const Pendente& e : pendentes) {
+            if (codificador.anexar(e.amostra, e.taxaDhz)) {
+                continue;
+            }
+            amostras[n] = codificador.totalAmostras();
+            tamanhos[n++] = codificador.finalizar();
+            if (n == GATEWAY_LOTES_POR_ENVIO) {
+                enviar(tamanhos, n, amostras);
+                n = 0;
+            }
+            codificador.iniciar(saida.data() + n * GATEWAY_TAMANHO_LOTE, GATEWAY_TAMANHO_LOTE, idGateway,
+                                proximoLote++);
+            codificador.anexar(e.amostra, e.taxaDhz);
+        }
+        amostras[n] = codificador.totalAmostras();
+        tamanhos[n++] = codificador.finalizar();
+        enviar(tamanhos, n, amostras);
+        pendentes.clear();
+        somar(janelas, 1);
+    }
+
+    void executar() {
+        char registro[DIFUSAO_TAMANHO_REGISTRO];
+        AmostraLDR amostras[LDR_MAX_AMOSTRAS_DATAGRAMA];
+        uint64_t inicioJanela = 0;
+        while (true) {
+            bool parando = !ativo.load(std::memory_order_relaxed);
+            size_t tamanho;
+            bool leu = false;
+            while ((tamanho = anel.ler(cursor, registro)) > 0) {
+                leu = true;
+                uint16_t magia;
+                memcpy(&magia, registro, sizeof(magia));
+                if (tamanho >= sizeof(CabecalhoAlertaLDR) && ntohs(magia) == LDR_MAGIA_ALERTA) {
+                    continue; // transição de alerta: fica no coletor local
+                }
+                MetadadosLDR meta;
+                size_t n = decodificarDatagrama(registro, tamanho, 0, amostras, LDR_MAX_AMOSTRAS_DATAGRAMA, &meta);
+                somar(registros, 1);
+                somar(bytesEntrada, tamanho);
+                somar(amostrasEntrada, n);
+                if (pendentes.empty()) {
+                    inicioJanela = agora();
+                }
+                if (pendentes.size() + n > GATEWAY_MAX_PENDENTES) {
+                    fecharJanela();
+                    inicioJanela = agora();
+                }
+                for (size_t i = 0; i < n; i++) {
+                    pendentes.push_back(Pendente{amostras[i], meta.taxaDhz});
+                }
+            }
+            perdidos.store(cursor.perdidos, std::memory_order_relaxed);
+            if (parando || (!pendentes.empty() && agora() - inicioJanela >= janelaNs)) {
+                fecharJanela();
+            }
+            if (parando) {
+                return;
+            }
+            if (!leu) {
+                usleep(1000);
+            }
+        }
+    }
+
+public:
+    explicit GatewayLotes(const AnelDifusao& origem) : anel(origem) {}
+
+    ~GatewayLotes() { encerrar(); }
+
+    GatewayLotes(const GatewayLotes&) = delete;
+    GatewayLotes& operator=(const GatewayLotes&) = delete;
+
+    /**
+     * @brief Conecta o socket ao coletor central e inicia a agregação.
+     * @param ip Endereço IPv4 do coletor central.
+     * @param porta Porta UDP do coletor central.
+     * @param janelaMs Duração de cada janela de agregação.
+     * @param gateway Identificador deste gateway (vai em cada lote).
+     * @return 0 ou -errno (EINVAL: endereço inválido).
+     */
+    int iniciar(const std::string& ip, int porta, uint32_t janelaMs, uint32_t gateway) {
+        sockaddr_in destino{};
+        destino.sin_family = AF_INET;
+        destino.sin_port = htons(static_cast<uint16_t>(porta));
+        if (inet_pton(AF_INET, ip.c_str(), &destino.sin_addr) <= 0) {
+            return -EINVAL;
+        }
+        sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (sock < 0 || connect(sock, reinterpret_cast<sockaddr*>(&destino), sizeof(destino)) < 0) {
+            int erro = errno;
+            if (sock >= 0) {
+                close(sock);
+                sock = -1;
+            }
+            return -erro;
+        }
+        janelaNs = static_cast<uint64_t>(janelaMs) * 1000000ull;
+        idGateway = gateway;
+        pendentes.reserve(GATEWAY_MAX_PENDENTES);
+        saida.resize(GATEWAY_LOTES_POR_ENVIO * GATEWAY_TAMANHO_LOTE);
+        cursor = anel.assinar();
+        ativo.store(true);
+        thread = std::thread(&GatewayLotes::executar, this);
+        return 0;
+    }
+
+    /** @brief Envia a janela corrente e encerra a agregação. */
+    void encerrar() {
+        ativo.store(false);
+        if (thread.joinable()) {
+            thread.join();
+        }
+        if (sock >= 0) {
+            close(sock);
+            sock = -1;
+        }
+    }
+
+    /** @brief Datagramas lidos do anel. */
+    uint64_t registrosLidos() const { return registros.load(std::memory_order_relaxed); }
+
+    /** @brief Bytes dos datagramas lidos do anel (o que o central receberia sem o gateway). */
+    uint64_t bytesRecebidos() const { return bytesEntrada.load(std::memory_order_relaxed); }
+
+    /** @brief Amostras lidas do anel. */
+    uint64_t amostrasRecebidas() const { return amostrasEntrada.load(std::memory_order_relaxed); }
+
+    /** @brief Janelas fechadas. */
+    uint64_t janelasFechadas() const { return janelas.load(std::memory_order_relaxed); }
+
+    /** @brief Lotes enviados ao coletor central. */
+    uint64_t lotesEnviados() const { return lotes.load(std::memory_order_relaxed); }
+
+    /** @brief Bytes dos lotes enviados. */
+    uint64_t bytesEnviados() const { return bytesSaida.load(std::memory_order_relaxed); }
+
+    /** @brief Amostras nos lotes enviados. */
+    uint64_t amostrasEnviadas() const { return amostrasSaida.load(std::memory_order_relaxed); }
+
+    /** @brief Lotes descartados por erro de envio. */
+    uint64_t falhasEnvio() const { return falhas.load(std::memory_order_relaxed); }
+
+    /** @brief Registros do anel sobrescritos antes de lidos pelo gateway. */
+    uint64_t registrosPerdidos() const { return perdidos.load(std::memory_order_relaxed); }
+};
+
+#endif // GATEWAY_LOTES_HPP
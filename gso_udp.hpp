@@ -0,0 +1,99 @@
+/**
+ * @file gso_udp.hpp
+ * @brief Segmentação (GSO) no envio e agregação (GRO) na recepção de datagramas UDP.
+ *
+ * @details Ao drenar um atraso grande do spool (ou repassar lotes grandes), o custo do envio é
+ * dominado pela travessia da pilha de rede por datagrama. Com UDP_SEGMENT, um único sendmsg()
+ * entrega ao kernel um buffer com vários datagramas de mesmo tamanho lado a lado (o último pode
+ * ser menor); a pilha é atravessada uma vez e o buffer só é dividido na saída (ou pela placa).
+ *
+ * Do lado do coletor, UDP_GRO faz o espelho: datagramas consecutivos do mesmo fluxo chegam
+ * juntos em uma só leitura, com o tamanho do segmento em uma mensagem de controle, e são
+ * separados pelo laço de recepção. O buffer de cada leitura passa então a GRO_TAMANHO_BUFFER.
+ *
+ * Kernels sem suporte (anteriores ao 4.18 no envio e ao 5.0 na recepção) recusam as opções; os
+ * chamadores voltam ao envio e à leitura de um datagrama por vez.
+ */
+
+#ifndef GSO_UDP_HPP
+#define GSO_UDP_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+/** @def GSO_MAX_SEGMENTOS
+ * @brief Maior número de datagramas em um envio segmentado (UDP_MAX_SEGMENTS do kernel).
+ */
+#define GSO_MAX_SEGMENTOS 64
+
+/** @def GSO_MAX_CARGA
+ * @brief Maior soma dos datagramas de um envio segmentado (limite de um datagrama IPv4).
+ */
+#define GSO_MAX_CARGA 65507
+
+/** @def GRO_TAMANHO_BUFFER
+ * @brief Buffer de cada leitura com UDP_GRO (comporta uma agregação completa).
+ */
+#define GRO_TAMANHO_BUFFER 65536
+
+/**
+ * @brief Envia @p tamanho bytes como datagramas de @p segmento bytes (o último pode ser menor;
+ * com @p segmento 0, como um só datagrama).
+ *
+ * @param destino Destino, ou nulo com o socket conectado.
+ * @param flags Flags do sendmsg() (ex.: MSG_ZEROCOPY).
+ * @return Bytes enviados ou -errno (EIO, EINVAL ou ENOPROTOOPT: sem suporte a GSO no caminho).
+ */
+inline ssize_t enviarSegmentado(int sock, const char* dados, size_t tamanho, uint16_t segmento,
+                                const sockaddr_in* destino, int flags = 0) {
+    iovec iov{const_cast<char*>(dados), tamanho};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (destino != nullptr) {
+        msg.msg_name = const_cast<sockaddr_in*>(destino);
+        msg.msg_namelen = sizeof(*destino);
+    }
+    alignas(cmsghdr) char controle[CMSG_SPACE(sizeof(uint16_t))] = {};
+    if (segmento != 0 && tamanho > segmento) {
+        msg.msg_control = controle;
+        msg.msg_controllen = sizeof(controle);
+        cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_UDP;
+        c->cmsg_type = UDP_SEGMENT;
+        c->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        memcpy(CMSG_DATA(c), &segmento, sizeof(segmento));
+    }
+    ssize_t n = sendmsg(sock, &msg, flags);
+    return n < 0 ? -errno : n;
+}
+
+/**
+ * @brief Habilita a recepção agregada (UDP_GRO) no socket.
+ * @return 0 ou -errno.
+ */
+inline int habilitarGro(int sock) {
+    int um = 1;
+    return setsockopt(sock, SOL_UDP, UDP_GRO, &um, sizeof(um)) < 0 ? -errno : 0;
+}
+
+/**
+ * @brief Tamanho do segmento de uma leitura agregada, lido das mensagens de controle de @p msg.
+ * @return 0 se a leitura é um único datagrama.
+ */
+inline uint16_t segmentoGro(const msghdr& msg) {
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(const_cast<msghdr*>(&msg), c)) {
+        if (c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO) {
+            int segmento;
+            memcpy(&segmento, CMSG_DATA(c), sizeof(segmento));
+            return static_cast<uint16_t>(segmento);
+        }
+    }
+    return 0;
+}
+
+#endif // GSO_UDP_HPP
@@ -0,0 +1,479 @@
+/**
+ * @file log_assincrono.hpp
+ * @brief Subsistema de log assíncrono, com níveis, campos estruturados e limitação de taxa.
+ *
+ * @details As mensagens são formatadas no próprio thread chamador em um registro de tamanho
+ * fixo e enfileiradas em uma fila circular sem travas (vários produtores, um consumidor).
+ * Um thread de fundo esvazia a fila e escreve os registros em lote na saída padrão
+ * (ou na saída de erro, para avisos e erros), de modo que o laço de amostragem nunca
+ * bloqueia em E/S de terminal. Cada ponto de chamada das macros LOG_* possui o seu
+ * próprio limitador de taxa: se o servidor ficar inacessível, o erro de envio é
+ * registrado algumas vezes por segundo e as ocorrências suprimidas são contadas.
+ *
+ * Exemplo:
+ * @code
+ * LOG_INFO("Datagrama enviado", campo("bytes", n), campo("destino", SERVER_IP));
+ * LOG_ERRO("Erro ao enviar datagrama", campoErrno());
+ * @endcode
+ */
+
+#ifndef LOG_ASSINCRONO_HPP
+#define LOG_ASSINCRONO_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+
+/** @def LOG_TAXA_PADRAO
+ * @brief Número máximo de mensagens por segundo emitidas por um mesmo ponto de chamada.
+ */
+#define LOG_TAXA_PADRAO 20
+
+/** @def LOG_CAPACIDADE_FILA
+ * @brief Número de registros da fila circular (deve ser potência de 2).
+ */
+#define LOG_CAPACIDADE_FILA 1024
+
+/** @def LOG_TAMANHO_TEXTO
+ * @brief Tamanho máximo do texto formatado de um registro (mensagem + campos).
+ */
+#define LOG_TAMANHO_TEXTO 232
+
+/**
+ * @enum NivelLog
+ * @brief Níveis de severidade das mensagens.
+ */
+enum class NivelLog : uint8_t {
+    DEPURACAO = 0, /**< Detalhes de depuração (desabilitado por padrão). */
+    INFO = 1,      /**< Funcionamento normal. */
+    AVISO = 2,     /**< Situação anormal recuperável. */
+    ERRO = 3       /**< Falha de uma operação. */
+};
+
+/**
+ * @brief Campo estruturado `chave=valor` anexado a uma mensagem.
+ */
+template <typename T>
+struct CampoLog {
+    const char* chave; /**< Nome do campo. */
+    T valor;           /**< Valor do campo. */
+};
+
+/**
+ * @brief Cria um campo estruturado.
+ * @param chave Nome do campo (literal).
+ * @param valor Valor do campo.
+ */
+template <typename T>
+inline CampoLog<T> campo(const char* chave, T valor) {
+    return CampoLog<T>{chave, valor};
+}
+
+/**
+ * @brief Código de erro do sistema, formatado com a descrição textual (como o `perror`).
+ */
+struct ErroSistema {
+    int codigo; /**< Valor de `errno`. */
+};
+
+/**
+ * @brief Cria o campo `erro=<descrição>` a partir do `errno` atual.
+ */
+inline CampoLog<ErroSistema> campoErrno() {
+    return CampoLog<ErroSistema>{"erro", ErroSistema{errno}};
+}
+
+namespace log_detalhe {
+
+/** @brief Lê um relógio POSIX em nanossegundos. */
+inline uint64_t agoraNs(clockid_t relogio) {
+    timespec ts;
+    clock_gettime(relogio, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+inline int formatarValor(char* p, size_t n, int v) { return snprintf(p, n, "%d", v); }
+inline int formatarValor(char* p, size_t n, unsigned v) { return snprintf(p, n, "%u", v); }
+inline int formatarValor(char* p, size_t n, long v) { return snprintf(p, n, "%ld", v); }
+inline int formatarValor(char* p, size_t n, unsigned long v) { return snprintf(p, n, "%lu", v); }
+inline int formatarValor(char* p, size_t n, long long v) { return snprintf(p, n, "%lld", v); }
+inline int formatarValor(char* p, size_t n, unsigned long long v) { return snprintf(p, n, "%llu", v); }
+inline int formatarValor(char* p, size_t n, double v) { return snprintf(p, n, "%.3f", v); }
+inline int formatarValor(char* p, size_t n, bool v) { return snprintf(p, n, "%s", v ? "sim" : "nao"); }
+inline int formatarValor(char* p, size_t n, const char* v) { return snprintf(p, n, "%s", v ? v : "(nulo)"); }
+inline int formatarValor(char* p, size_t n, const std::string& v) { return snprintf(p, n, "%s", v.c_str()); }
+
+/**
+ * @brief Descrição devolvida pela versão XSI de strerror_r (musl, uClibc, glibc sem _GNU_SOURCE):
+ * 0 em caso de sucesso, com o texto no buffer.
+ */
+inline const char* descricaoErro(int resultado, const char* buffer) {
+    return resultado == 0 ? buffer : "erro desconhecido";
+}
+
+/**
+ * @brief Descrição devolvida pela versão GNU de strerror_r: o ponteiro para o texto, que pode
+ * não ser o buffer.
+ */
+inline const char* descricaoErro(const char* resultado, const char*) {
+    return resultado;
+}
+
+inline int formatarValor(char* p, size_t n, ErroSistema e) {
+    char descricao[96];
+    // O retorno de strerror_r depende da libc (int na XSI, char* na GNU): a sobrecarga escolhe.
+    const char* texto = descricaoErro(strerror_r(e.codigo, descricao, sizeof(descricao)), descricao);
+    return snprintf(p, n, "\"%s\"", texto);
+}
+
+/**
+ * @brief Acumula texto em um buffer de tamanho fixo, truncando silenciosamente.
+ */
+struct Escritor {
+    char* p;   /**< Próxima posição livre. */
+    char* fim; /**< Fim do buffer (reserva 1 byte para o terminador). */
+
+    void avancar(int n) {
+        if (n <= 0) {
+            return;
+        }
+        size_t livre = static_cast<size_t>(fim - p);
+        p += (static_cast<size_t>(n) < livre) ? static_cast<size_t>(n) : livre;
+    }
+};
+
+inline void anexarCampos(Escritor&) {}
+
+template <typename T, typename... Resto>
+inline void anexarCampos(Escritor& e, const CampoLog<T>& c, const Resto&... resto) {
+    e.avancar(snprintf(e.p, static_cast<size_t>(e.fim - e.p) + 1, " %s=", c.chave));
+    e.avancar(formatarValor(e.p, static_cast<size_t>(e.fim - e.p) + 1, c.valor));
+    anexarCampos(e, resto...);
+}
+
+} // namespace log_detalhe
+
+/**
+ * @class LimitadorTaxa
+ * @brief Limita o número de mensagens por segundo de um ponto de chamada.
+ *
+ * @details Usa janelas fixas de 1 segundo. As mensagens rejeitadas são contadas e o total
+ * é informado na próxima mensagem aceita, para que nenhuma ocorrência passe despercebida.
+ */
+class LimitadorTaxa {
+private:
+    /**< Máximo de mensagens aceitas por janela. */
+    const uint32_t maximo;
+
+    /**< Início da janela atual (CLOCK_MONOTONIC, em segundos). */
+    std::atomic<uint64_t> janela{0};
+
+    /**< Mensagens aceitas na janela atual. */
+    std::atomic<uint32_t> aceitas{0};
+
+    /**< Mensagens rejeitadas desde a última aceita. */
+    std::atomic<uint32_t> suprimidas{0};
+
+public:
+    /**
+     * @brief Construtor.
+     * @param maximoPorSegundo Número máximo de mensagens aceitas por segundo.
+     */
+    explicit LimitadorTaxa(uint32_t maximoPorSegundo) : maximo(maximoPorSegundo) {}
+
+    /**
+     * @brief Decide se uma mensagem pode ser emitida agora.
+     * @param suprimidasAntes Recebe o número de mensagens suprimidas desde a última aceita.
+     * @return true se a mensagem deve ser emitida.
+     */
+    bool permitir(uint32_t& suprimidasAntes) {
+        uint64_t segundo = log_detalhe::agoraNs(CLOCK_MONOTONIC) / 1000000000ull;
+        uint64_t atual = janela.load(std::memory_order_relaxed);
+        if (segundo != atual && janela.compare_exchange_strong(atual, segundo, std::memory_order_relaxed)) {
+            aceitas.store(0, std::memory_order_relaxed);
+        }
+        if (aceitas.fetch_add(1, std::memory_order_relaxed) >= maximo) {
+            suprimidas.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suprimidasAntes = suprimidas.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+/**
+ * @class LogAssincrono
+ * @brief Fila de registros e thread escritor de fundo (instância única por processo).
+ *
+ * @details A fila é a fila circular limitada de Vyukov: cada célula tem um número de sequência
+ * que indica se está livre para o produtor ou pronta para o consumidor, de forma que
+ * produtores e consumidor nunca compartilham uma trava. Com a fila cheia o registro é
+ * descartado (e contado) em vez de bloquear o chamador.
+ */
+class LogAssincrono {
+private:
+    /**
+     * @brief Registro de tamanho fixo armazenado na fila.
+     */
+    struct Registro {
+        uint64_t instante_ns;           /**< Instante da chamada (CLOCK_REALTIME). */
+        NivelLog nivel;                 /**< Severidade. */
+        char texto[LOG_TAMANHO_TEXTO];  /**< Mensagem e campos já formatados. */
+    };
+
+    /**
+     * @brief Célula da fila circular.
+     */
+    struct Celula {
+        std::atomic<size_t> sequencia; /**< Estado da célula (protocolo de Vyukov). */
+        Registro registro;             /**< Conteúdo. */
+    };
+
+    /**< Máscara para o índice circular. */
+    static constexpr size_t MASCARA = LOG_CAPACIDADE_FILA - 1;
+    static_assert((LOG_CAPACIDADE_FILA & MASCARA) == 0, "LOG_CAPACIDADE_FILA deve ser potencia de 2");
+
+    /**< Células da fila. */
+    Celula celulas[LOG_CAPACIDADE_FILA];
+
+    /**< Próxima posição de escrita (produtores). */
+    alignas(64) std::atomic<size_t> posEscrita{0};
+
+    /**< Próxima posição de leitura (thread escritor). */
+    alignas(64) size_t posLeitura = 0;
+
+    /**< Registros descartados por fila cheia. */
+    std::atomic<uint64_t> descartados{0};
+
+    /**< Nível mínimo emitido. */
+    std::atomic<uint8_t> nivelMinimo{static_cast<uint8_t>(NivelLog::INFO)};
+
+    /**< Sinaliza o término do thread escritor. */
+    std::atomic<bool> encerrar{false};
+
+    /**< Thread escritor de fundo. */
+    std::thread escritor;
+
+    LogAssincrono() {
+        for (size_t i = 0; i < LOG_CAPACIDADE_FILA; i++) {
+            celulas[i].sequencia.store(i, std::memory_order_relaxed);
+        }
+        escritor = std::thread(&LogAssincrono::executarEscritor, this);
+    }
+
+    ~LogAssincrono() {
+        encerrar.store(true, std::memory_order_release);
+        if (escritor.joinable()) {
+            escritor.join();
+        }
+    }
+
+    /**
+     * @brief Reserva uma célula livre para escrita.
+     * @param pos Recebe a posição reservada.
+     * @return Ponteiro para a célula, ou nullptr se a fila estiver cheia.
+     */
+    Celula* reservar(size_t& pos) {
+        pos = posEscrita.load(std::memory_order_relaxed);
+        while (true) {
+            Celula& c = celulas[pos & MASCARA];
+            size_t seq = c.sequencia.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0) {
+                if (posEscrita.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &c;
+                }
+            } else if (dif < 0) {
+                return nullptr;
+            } else {
+                pos = posEscrita.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static const char* nomeNivel(NivelLog nivel) {
+        switch (nivel) {
+            case NivelLog::DEPURACAO: return "DEPUR";
+            case NivelLog::INFO:      return "INFO ";
+            case NivelLog::AVISO:     return "AVISO";
+            default:                  return "ERRO ";
+        }
+    }
+
+    /**
+     * @brief Formata a linha final de um registro (data e hora, nível e texto).
+     */
+    static int formatarLinha(char* destino, size_t n, const Registro& r) {
+        time_t segundos = static_cast<time_t>(r.instante_ns / 1000000000ull);
+        unsigned milis = static_cast<unsigned>((r.instante_ns / 1000000ull) % 1000);
+        struct tm local;
+        localtime_r(&segundos, &local);
+        char data[32];
+        strftime(data, sizeof(data), "%Y-%m-%d %H:%M:%S", &local);
+        return snprintf(destino, n, "%s.%03u %s %s\n", data, milis, nomeNivel(r.nivel), r.texto);
+    }
+
+    /**
+     * @brief Corpo do thread escritor: esvazia a fila e escreve em lote.
+     *
+     * @details As linhas são acumuladas em dois buffers locais (saída padrão e erro) e
+     * despejadas com um único fwrite/fflush por lote. Com a fila vazia, o thread dorme
+     * alguns milissegundos; os produtores nunca precisam acordá-lo.
+     */
+    void executarEscritor() {
+        // Bytes do aviso "log: N mensagens descartadas (fila cheia)" com N de até 20 dígitos.
+        static constexpr size_t RESERVA_DESCARTE = 64;
+        static char saida[16384];
+        static char erro[16384];
+        while (true) {
+            bool terminar = encerrar.load(std::memory_order_acquire);
+            size_t nSaida = 0;
+            size_t nErro = 0;
+            while (true) {
+                Celula& c = celulas[posLeitura & MASCARA];
+                if (c.sequencia.load(std::memory_order_acquire) != posLeitura + 1) {
+                    break;
+                }
+                bool ehErro = c.registro.nivel >= NivelLog::AVISO;
+                char* buf = ehErro ? erro : saida;
+                size_t& n = ehErro ? nErro : nSaida;
+                // Reserva espaço também para o aviso de descarte, acrescentado após o lote.
+                if (n + LOG_TAMANHO_TEXTO + 64 + RESERVA_DESCARTE > sizeof(saida)) {
+                    break;
+                }
+                int escrito = formatarLinha(buf + n, sizeof(saida) - n, c.registro);
+                if (escrito > 0) {
+                    n += std::min(static_cast<size_t>(escrito), sizeof(saida) - n - 1);
+                }
+                c.sequencia.store(posLeitura + LOG_CAPACIDADE_FILA, std::memory_order_release);
+                posLeitura++;
+            }
+            uint64_t perdidos = descartados.exchange(0, std::memory_order_relaxed);
+            if (perdidos > 0) {
+                int escrito = snprintf(erro + nErro, sizeof(erro) - nErro, "log: %llu mensagens descartadas (fila cheia)\n",
+                                       static_cast<unsigned long long>(perdidos));
+                if (escrito > 0) {
+                    nErro += std::min(static_cast<size_t>(escrito), sizeof(erro) - nErro - 1);
+                }
+            }
+            if (nSaida > 0) {
+                fwrite(saida, 1, nSaida, stdout);
+                fflush(stdout);
+            }
+            if (nErro > 0) {
+                fwrite(erro, 1, nErro, stderr);
+                fflush(stderr);
+            }
+            if (nSaida == 0 && nErro == 0) {
+                if (terminar) {
+                    return;
+                }
+                timespec pausa{0, 5 * 1000000};
+                nanosleep(&pausa, nullptr);
+            }
+        }
+    }
+
+public:
+    LogAssincrono(const LogAssincrono&) = delete;
+    LogAssincrono& operator=(const LogAssincrono&) = delete;
+
+    /**
+     * @brief Retorna a instância do processo (o thread escritor é criado no primeiro uso).
+     */
+    static LogAssincrono& instancia() {
+        static LogAssincrono log;
+        return log;
+    }
+
+    /**
+     * @brief Define o nível mínimo das mensagens emitidas.
+     */
+    void definirNivelMinimo(NivelLog nivel) {
+        nivelMinimo.store(static_cast<uint8_t>(nivel), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Indica se mensagens do nível informado são emitidas.
+     */
+    bool habilitado(NivelLog nivel) const {
+        return static_cast<uint8_t>(nivel) >= nivelMinimo.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Formata e enfileira uma mensagem (não bloqueia).
+     * @param nivel Severidade.
+     * @param suprimidas Ocorrências suprimidas pelo limitador desde a última emitida.
+     * @param mensagem Texto da mensagem.
+     * @param campos Campos estruturados `chave=valor`.
+     * @return false se a fila estava cheia (a mensagem foi descartada e contada).
+     */
+    template <typename... Campos>
+    bool registrar(NivelLog nivel, uint32_t suprimidas, const char* mensagem, const Campos&... campos) {
+        size_t pos;
+        Celula* c = reservar(pos);
+        if (c == nullptr) {
+            descartados.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Registro& r = c->registro;
+        r.instante_ns = log_detalhe::agoraNs(CLOCK_REALTIME);
+        r.nivel = nivel;
+        log_detalhe::Escritor e{r.texto, r.texto + sizeof(r.texto) - 1};
+        e.avancar(snprintf(e.p, sizeof(r.texto), "%s", mensagem));
+        log_detalhe::anexarCampos(e, campos...);
+        if (suprimidas > 0) {
+            e.avancar(snprintf(e.p, static_cast<size_t>(e.fim - e.p) + 1, " (+%u suprimidas)", suprimidas));
+        }
+        *e.p = '\0';
+        c->sequencia.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+/** @def LOG_REGISTRAR
+ * @brief Emite uma mensagem com limite próprio de mensagens por segundo neste ponto de chamada.
+ */
+#define LOG_REGISTRAR(nivel, maximoPorSegundo, mensagem, ...)                                      \
+    do {                                                                                           \
+        static LimitadorTaxa limitador_local_(maximoPorSegundo);                                   \
+        uint32_t suprimidas_local_ = 0;                                                            \
+        if (LogAssincrono::instancia().habilitado(nivel) && limitador_local_.permitir(suprimidas_local_)) \
+            LogAssincrono::instancia().registrar(nivel, suprimidas_local_, mensagem, ##__VA_ARGS__); \
+    } while (0)
+
+/** @def LOG_SEM_LIMITE
+ * @brief Emite uma mensagem sem limite de taxa (eventos que não podem ser suprimidos).
+ * @return false se a fila estava cheia e a mensagem foi descartada (true se o nível está desabilitado).
+ */
+#define LOG_SEM_LIMITE(nivel, mensagem, ...)                                                       \
+    (!LogAssincrono::instancia().habilitado(nivel) ||                                              \
+     LogAssincrono::instancia().registrar(nivel, 0, mensagem, ##__VA_ARGS__))
+
+/** @def LOG_DEPURACAO
+ * @brief Mensagem de depuração.
+ */
+#define LOG_DEPURACAO(mensagem, ...) LOG_REGISTRAR(NivelLog::DEPURACAO, LOG_TAXA_PADRAO, mensagem, ##__VA_ARGS__)
+
+/** @def LOG_INFO
+ * @brief Mensagem informativa.
+ */
+#define LOG_INFO(mensagem, ...) LOG_REGISTRAR(NivelLog::INFO, LOG_TAXA_PADRAO, mensagem, ##__VA_ARGS__)
+
+/** @def LOG_AVISO
+ * @brief Aviso (escrito na saída de erro).
+ */
+#define LOG_AVISO(mensagem, ...) LOG_REGISTRAR(NivelLog::AVISO, LOG_TAXA_PADRAO, mensagem, ##__VA_ARGS__)
+
+/** @def LOG_ERRO
+ * @brief Erro (escrito na saída de erro), limitado a poucas mensagens por segundo.
+ */
+#define LOG_ERRO(mensagem, ...) LOG_REGISTRAR(NivelLog::ERRO, 5, mensagem, ##__VA_ARGS__)
+
+#endif // LOG_ASSINCRONO_HPP
@@ -0,0 +1,457 @@
+/**
+ * @file motor_alertas.hpp
+ * @brief Motor de alertas avaliado em cada amostra, no momento da recepção.
+ *
+ * @details No servidor Python os alertas são os testes `valor < 10` e `valor > 90` de
+ * `processar_fila_dados()`, aplicados somente à amostra retirada da fila a cada 100 ms: eventos
+ * curtos passam despercebidos e, perto do limiar, o estado alterna a cada leitura. Aqui cada
+ * amostra de cada sensor passa por todas as regras aplicáveis ao sensor, com:
+ * - condição sobre o valor (`abaixo`, `acima`, `faixa`), sobre o módulo da taxa de variação por
+ *   segundo (`taxa`) ou sobre a média móvel de uma janela de amostras (`media_abaixo`,
+ *   `media_acima`);
+ * - histerese: o alerta só normaliza quando o valor volta além do limiar pela largura da banda;
+ * - duração mínima (debounce): a condição de disparo, ou de normalização, precisa se manter por
+ *   esse tempo, medido pelos instantes das amostras, antes da transição.
+ *
+ * As regras não são interpretadas amostra a amostra. Quando um sensor aparece, as regras que se
+ * aplicam a ele são compiladas em um trecho contíguo de RegraCompilada: toda condição vira um
+ * intervalo [inferior, superior] sobre uma fonte (valor, taxa ou média), com um intervalo para o
+ * estado normal e outro para o estado de alerta. A avaliação percorre as amostras novas da série
+ * (SeriesAmostras) em lote: as fontes derivadas são calculadas uma vez por lote, e cada regra
+ * conta, em um laço sem desvios que o compilador vetoriza, quantas amostras caem fora do
+ * intervalo. Só quando alguma amostra pode mudar o estado a regra é percorrida amostra a amostra.
+ *
+ * As transições são entregues aos assinantes de forma síncrona, no thread do laço de recepção,
+ * logo após a decodificação do datagrama. Cada laço possui o seu motor; os assinantes de um
+ * coletor com vários trabalhadores podem ser chamados por threads diferentes.
+ */
+
+#ifndef MOTOR_ALERTAS_HPP
+#define MOTOR_ALERTAS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "protocolo_ldr.hpp"
+#include "series_amostras.hpp"
+
+/** @def ALERTA_TODOS_SENSORES
+ * @brief Valor de RegraAlerta::id_sensor que aplica a regra a todos os sensores.
+ */
+#define ALERTA_TODOS_SENSORES UINT32_MAX
+
+/** @def ALERTA_JANELA_MAXIMA
+ * @brief Maior janela (em amostras) das regras de média móvel.
+ */
+#define ALERTA_JANELA_MAXIMA 1024
+
+/** @def ALERTA_LOTE
+ * @brief Número máximo de amostras avaliadas de uma vez.
+ */
+#define ALERTA_LOTE LDR_MAX_AMOSTRAS_DATAGRAMA
+
+/**
+ * @brief Condição avaliada por uma regra.
+ */
+enum class TipoRegra {
+    ABAIXO,       /**< Valor menor que o limiar (ex.: escuridão, possível violação). */
+    ACIMA,        /**< Valor maior que o limiar (ex.: luz intensa, invólucro aberto). */
+    TAXA,         /**< Módulo da variação por segundo maior que o limiar. */
+    FAIXA,        /**< Valor fora de [limiar, limiarSuperior]. */
+    MEDIA_ABAIXO, /**< Média das últimas `janela` amostras menor que o limiar. */
+    MEDIA_ACIMA   /**< Média das últimas `janela` amostras maior que o limiar. */
+};
+
+/**
+ * @brief Regra de alerta.
+ */
+struct RegraAlerta {
+    std::string nome;                          /**< Descrição do alerta. */
+    uint32_t id_sensor = ALERTA_TODOS_SENSORES; /**< Sensor, ou ALERTA_TODOS_SENSORES. */
+    TipoRegra tipo = TipoRegra::ACIMA;          /**< Condição. */
+    int32_t limiar = 0;                         /**< Limiar (por segundo, em TAXA; inferior, em FAIXA). */
+    int32_t limiarSuperior = 0;                 /**< Limite superior (FAIXA). */
+    uint32_t janela = 1;                        /**< Amostras da média móvel (MEDIA_*). */
+    int32_t histerese = 0;                      /**< Largura da banda de normalização. */
+    uint64_t duracaoMinimaNs = 0;               /**< Tempo mínimo da condição antes da transição. */
+};
+
+/**
+ * @brief Transição de estado de um alerta.
+ */
+struct EventoAlerta {
+    const RegraAlerta* regra; /**< Regra que mudou de estado. */
+    uint32_t id_sensor;       /**< Sensor. */
+    bool ativo;               /**< true = disparo, false = normalização. */
+    int32_t valor;            /**< Valor da amostra que completou a transição. */
+    uint64_t t_ns;            /**< Instante dessa amostra. */
+};
+
+/**
+ * @brief Converte uma regra do formato `sensor,tipo,limiar,histerese,duracao_ms[,extra]`.
+ *
+ * @details `sensor` é um id numérico ou `*` (todos); `tipo` é `abaixo`, `acima`, `taxa`, `faixa`
+ * (`extra` = limite superior), `media_abaixo` ou `media_acima` (`extra` = janela em amostras).
+ * Ex.: `*,abaixo,10,3,50` (escuridão em qualquer sensor, normaliza acima de 13, debounce de 50 ms).
+ * @return false se o texto não estiver no formato.
+ */
+inline bool lerRegraAlerta(const char* texto, RegraAlerta& regra) {
+    char sensor[16], tipo[16];
+    long limiar, histerese, duracaoMs, extra = 0;
+    int campos = sscanf(texto, "%15[^,],%15[^,],%ld,%ld,%ld,%ld", sensor, tipo, &limiar, &histerese, &duracaoMs, &extra);
+    if (campos < 5 || histerese < 0 || duracaoMs < 0) {
+        return false;
+    }
+    if (strcmp(sensor, "*") == 0) {
+        regra.id_sensor = ALERTA_TODOS_SENSORES;
+    } else {
+        char* fim;
+        regra.id_sensor = static_cast<uint32_t>(strtoul(sensor, &fim, 10));
+        if (*fim != '\0') {
+            return false;
+        }
+    }
+    bool comExtra = false;
+    if (strcmp(tipo, "abaixo") == 0) {
+        regra.tipo = TipoRegra::ABAIXO;
+    } else if (strcmp(tipo, "acima") == 0) {
+        regra.tipo = TipoRegra::ACIMA;
+    } else if (strcmp(tipo, "taxa") == 0) {
+        regra.tipo = TipoRegra::TAXA;
+    } else if (strcmp(tipo, "faixa") == 0) {
+        regra.tipo = TipoRegra::FAIXA;
+        comExtra = true;
+    } else if (strcmp(tipo, "media_abaixo") == 0 || strcmp(tipo, "media_acima") == 0) {
+        regra.tipo = strcmp(tipo, "media_abaixo") == 0 ? TipoRegra::MEDIA_ABAIXO : TipoRegra::MEDIA_ACIMA;
+        comExtra = true;
+    } else {
+        return false;
+    }
+    if (comExtra != (campos == 6)) {
+        return false;
+    }
+    regra.limiarSuperior = 0;
+    regra.janela = 1;
+    if (regra.tipo == TipoRegra::FAIXA) {
+        regra.limiarSuperior = static_cast<int32_t>(extra);
+    } else if (comExtra) {
+        if (extra < 1 || extra > ALERTA_JANELA_MAXIMA) {
+            return false;
+        }
+        regra.janela = static_cast<uint32_t>(extra);
+    }
+    regra.nome = texto;
+    regra.limiar = static_cast<int32_t>(limiar);
+    regra.histerese = static_cast<int32_t>(histerese);
+    regra.duracaoMinimaNs = static_cast<uint64_t>(duracaoMs) * 1000000ull;
+    return true;
+}
+
+/**
+ * @class MotorAlertas
+ * @brief Avalia as regras de alerta sobre as séries de amostras de um laço de recepção.
+ *
+ * @details As regras de cada sensor são compiladas quando a sua série é avaliada pela primeira
+ * vez; a avaliação seguinte não aloca memória. O motor é indexado pelos índices de série de um
+ * único SeriesAmostras.
+ */
+class MotorAlertas {
+public:
+    /** @brief Função chamada a cada transição. */
+    using Assinante = std::function<void(const EventoAlerta&)>;
+
+private:
+    /** @brief Grandeza comparada pela regra compilada. */
+    enum Fonte : uint8_t { FONTE_VALOR = 0, FONTE_TAXA = 1, FONTE_MEDIA = 2 };
+
+    /**
+     * @brief Regra compilada para um sensor: intervalo normal (índice 0) e em alerta (índice 1).
+     *
+     * @details Inativa, a regra dispara quando a fonte sai de [inferior[0], superior[0]]; ativa,
+     * normaliza quando a fonte volta a [inferior[1], superior[1]]. A condição de transição de
+     * uma amostra é, portanto, `fora(intervalo[ativo]) != ativo`.
+     */
+    struct RegraCompilada {
+        float inferior[2];         /**< Limite inferior por estado. */
+        float superior[2];         /**< Limite superior por estado. */
+        uint64_t duracaoMinimaNs;  /**< Debounce. */
+        uint64_t desde;            /**< Início da condição pendente. */
+        uint32_t regra;            /**< Índice em regras. */
+        uint16_t janela;           /**< Janela da média móvel (FONTE_MEDIA). */
+        uint8_t fonte;             /**< Fonte. */
+        uint8_t ativo;             /**< Alerta disparado. */
+        uint8_t pendente;          /**< Condição de transição observada, aguardando a duração mínima. */
+    };
+
+    /** @brief Regras compiladas de uma série e o estado das fontes derivadas. */
+    struct RegrasSerie {
+        uint32_t primeira = 0;     /**< Primeira regra compilada em compiladas. */
+        uint32_t n = 0;            /**< Número de regras. */
+        bool compilada = false;    /**< Regras já compiladas. */
+        bool temAnterior = false;  /**< Já houve uma amostra avaliada (para a taxa). */
+        int32_t valorAnterior = 0; /**< Última amostra avaliada. */
+        uint64_t tAnterior = 0;
+        float taxaAnterior = 0;    /**< Última taxa (repetida quando dt = 0). */
+    };
+
+    /**< Regras cadastradas, as gerais e as de cada sensor. */
+    std::vector<RegraAlerta> regras;
+    std::vector<uint32_t> regrasGerais;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> regrasPorSensor;
+
+    /**< Assinantes das transições. */
+    std::vector<Assinante> assinantes;
+
+    /**< Regras compiladas de todas as séries, contíguas por série, e o trecho de cada série. */
+    std::vector<RegraCompilada> compiladas;
+    std::vector<RegrasSerie> porSerie;
+
+    /**< Área de trabalho do lote: amostras novas e fontes derivadas. */
+    uint64_t tempos[ALERTA_LOTE];
+    int32_t valores[ALERTA_LOTE];
+    float fonteValor[ALERTA_LOTE];
+    float fonteTaxa[ALERTA_LOTE];
+    float fonteMedia[ALERTA_LOTE];
+    int32_t historico[ALERTA_JANELA_MAXIMA + ALERTA_LOTE];
+
+    /**< Transições emitidas. */
+    uint64_t emitidos = 0;
+
+    /**
+     * @brief Compila as regras aplicáveis a um sensor no fim de compiladas.
+     */
+    void compilar(RegrasSerie& rs, uint32_t id_sensor) {
+        const float inf = std::numeric_limits<float>::infinity();
+        rs.primeira = static_cast<uint32_t>(compiladas.size());
+        auto anexar = [&](uint32_t indice) {
+            const RegraAlerta& r = regras[indice];
+            float l = static_cast<float>(r.limiar);
+            float h = static_cast<float>(r.histerese);
+            RegraCompilada c{};
+            c.regra = indice;
+            c.duracaoMinimaNs = r.duracaoMinimaNs;
+            c.janela = static_cast<uint16_t>(r.janela);
+            switch (r.tipo) {
+                case TipoRegra::ABAIXO:
+                case TipoRegra::MEDIA_ABAIXO:
+                    c.inferior[0] = l;     c.superior[0] = inf;
+                    c.inferior[1] = l + h; c.superior[1] = inf;
+                    break;
+                case TipoRegra::FAIXA: {
+                    float u = static_cast<float>(r.limiarSuperior);
+                    c.inferior[0] = l;     c.superior[0] = u;
+                    c.inferior[1] = l + h; c.superior[1] = u - h;
+                    break;
+                }
+                default:
+                    c.inferior[0] = -inf;  c.superior[0] = l;
+                    c.inferior[1] = -inf;  c.superior[1] = l - h;
+                    break;
+            }
+            c.fonte = r.tipo == TipoRegra::TAXA ? FONTE_TAXA
+                    : (r.tipo == TipoRegra::MEDIA_ABAIXO || r.tipo == TipoRegra::MEDIA_ACIMA) ? FONTE_MEDIA
+                    : FONTE_VALOR;
+            compiladas.push_back(c);
+        };
+        for (uint32_t indice : regrasGerais) {
+            anexar(indice);
+        }
+        auto it = regrasPorSensor.find(id_sensor);
+        if (it != regrasPorSensor.end()) {
+            for (uint32_t indice : it->second) {
+                anexar(indice);
+            }
+        }
+        rs.n = static_cast<uint32_t>(compiladas.size()) - rs.primeira;
+        // Agrupa as regras da mesma fonte e janela: a média de cada janela é calculada uma vez.
+        std::sort(compiladas.begin() + rs.primeira, compiladas.end(), [](const RegraCompilada& a, const RegraCompilada& b) {
+            return a.fonte != b.fonte ? a.fonte < b.fonte : a.janela < b.janela;
+        });
+        rs.compilada = true;
+    }
+
+    /** @brief Taxa de variação (módulo, por segundo) de cada amostra do lote. */
+    void calcularTaxa(const RegrasSerie& rs, size_t n) {
+        bool temAnterior = rs.temAnterior;
+        int32_t v0 = rs.valorAnterior;
+        uint64_t t0 = rs.tAnterior;
+        float taxa = rs.taxaAnterior;
+        for (size_t i = 0; i < n; i++) {
+            if (temAnterior && tempos[i] > t0) {
+                taxa = static_cast<float>(std::abs(static_cast<double>(valores[i] - v0)) * 1e9 /
+                                          static_cast<double>(tempos[i] - t0));
+            }
+            fonteTaxa[i] = taxa;
+            temAnterior = true;
+            v0 = valores[i];
+            t0 = tempos[i];
+        }
+    }
+
+    /** @brief Média móvel das últimas @p janela amostras (as disponíveis, no início da série). */
+    void calcularMedia(const SeriesAmostras& series, uint32_t serie, uint64_t inicio, size_t n, uint32_t janela) {
+        uint64_t base = inicio + 1 >= janela ? inicio + 1 - janela : 0;
+        size_t m = 0;
+        series.trechos(serie, base, inicio + n, [&](const uint64_t*, const int32_t* v, size_t k) {
+            memcpy(historico + m, v, k * sizeof(int32_t));
+            m += k;
+        });
+        // Amostras que já saíram do anel não são devolvidas por trechos(): o histórico começa depois.
+        base = inicio + n - m;
+        int64_t soma = 0;
+        size_t esquerda = 0;
+        for (size_t j = 0; j < m; j++) {
+            soma += historico[j];
+            if (j - esquerda + 1 > janela) {
+                soma -= historico[esquerda++];
+            }
+            if (base + j >= inicio) {
+                fonteMedia[base + j - inicio] = static_cast<float>(static_cast<double>(soma) / static_cast<double>(j - esquerda + 1));
+            }
+        }
+    }
+
+    /**
+     * @brief Avalia uma regra compilada sobre a fonte @p x do lote.
+     */
+    void avaliarRegra(RegraCompilada& c, const float* x, size_t n, uint32_t id_sensor) {
+        // Caminho rápido: conta as amostras fora do intervalo do estado atual, sem desvios.
+        float inferior = c.inferior[c.ativo];
+        float superior = c.superior[c.ativo];
+        unsigned fora = 0;
+        for (size_t i = 0; i < n; i++) {
+            fora += static_cast<unsigned>((x[i] < inferior) | (x[i] > superior));
+        }
+        if ((c.ativo ? n - fora : fora) == 0) {
+            c.pendente = 0;
+            return;
+        }
+        // Alguma amostra pode mudar o estado: percorre o lote em ordem.
+        for (size_t i = 0; i < n; i++) {
+            bool foraDoIntervalo = x[i] < c.inferior[c.ativo] || x[i] > c.superior[c.ativo];
+            if (foraDoIntervalo == static_cast<bool>(c.ativo)) {
+                c.pendente = 0;
+                continue;
+            }
+            if (!c.pendente) {
+                c.pendente = 1;
+                c.desde = tempos[i];
+            }
+            // Uma amostra anterior ao início da condição (retransmitida ou reconstruída, fora de
+            // ordem) não conta como tempo decorrido.
+            if (tempos[i] < c.desde || tempos[i] - c.desde < c.duracaoMinimaNs) {
+                continue;
+            }
+            c.ativo = !c.ativo;
+            c.pendente = 0;
+            emitidos++;
+            EventoAlerta evento{&regras[c.regra], id_sensor, static_cast<bool>(c.ativo), valores[i], tempos[i]};
+            for (const Assinante& a : assinantes) {
+                a(evento);
+            }
+        }
+    }
+
+    /** @brief Avalia até ALERTA_LOTE amostras a partir da posição @p inicio da série. */
+    void avaliarLote(const SeriesAmostras& series, uint32_t serie, uint64_t inicio, size_t n) {
+        RegrasSerie& rs = porSerie[serie];
+        size_t k = 0;
+        series.trechos(serie, inicio, inicio + n, [&](const uint64_t* t, const int32_t* v, size_t m) {
+            for (size_t i = 0; i < m; i++, k++) {
+                tempos[k] = t[i];
+                valores[k] = v[i];
+                fonteValor[k] = static_cast<float>(v[i]);
+            }
+        });
+        bool taxaCalculada = false;
+        uint32_t janelaCalculada = 0;
+        uint32_t id = series.metadados(serie).id_sensor;
+        for (uint32_t r = 0; r < rs.n; r++) {
+            RegraCompilada& c = compiladas[rs.primeira + r];
+            const float* x = fonteValor;
+            if (c.fonte == FONTE_TAXA) {
+                if (!taxaCalculada) {
+                    calcularTaxa(rs, n);
+                    taxaCalculada = true;
+                }
+                x = fonteTaxa;
+            } else if (c.fonte == FONTE_MEDIA) {
+                if (janelaCalculada != c.janela) {
+                    calcularMedia(series, serie, inicio, n, c.janela);
+                    janelaCalculada = c.janela;
+                }
+                x = fonteMedia;
+            }
+            avaliarRegra(c, x, n, id);
+        }
+        if (taxaCalculada) {
+            rs.taxaAnterior = fonteTaxa[n - 1];
+        }
+        rs.temAnterior = true;
+        rs.valorAnterior = valores[n - 1];
+        rs.tAnterior = tempos[n - 1];
+    }
+
+public:
+    /**
+     * @brief Cadastra uma regra (as regras já compiladas e o estado dos alertas são descartados).
+     */
+    void adicionarRegra(const RegraAlerta& regra) {
+        uint32_t indice = static_cast<uint32_t>(regras.size());
+        regras.push_back(regra);
+        if (regra.id_sensor == ALERTA_TODOS_SENSORES) {
+            regrasGerais.push_back(indice);
+        } else {
+            regrasPorSensor[regra.id_sensor].push_back(indice);
+        }
+        compiladas.clear();
+        porSerie.clear();
+    }
+
+    /** @brief Cadastra um assinante das transições. */
+    void assinar(Assinante assinante) { assinantes.push_back(std::move(assinante)); }
+
+    /** @brief Número de regras. */
+    size_t numeroRegras() const { return regras.size(); }
+
+    /** @brief Número de regras compiladas (somadas entre os sensores já vistos). */
+    size_t numeroRegrasCompiladas() const { return compiladas.size(); }
+
+    /** @brief Transições emitidas desde a criação. */
+    uint64_t eventosEmitidos() const { return emitidos; }
+
+    /**
+     * @brief Avalia as amostras da série @p serie a partir da posição @p inicio (até a última).
+     * @details Deve ser chamada após cada anexação, com a posição da primeira amostra anexada.
+     */
+    void avaliar(const SeriesAmostras& series, uint32_t serie, uint64_t inicio) {
+        if (regras.empty()) {
+            return;
+        }
+        if (serie >= porSerie.size()) {
+            porSerie.resize(serie + 1);
+        }
+        if (!porSerie[serie].compilada) {
+            compilar(porSerie[serie], series.metadados(serie).id_sensor);
+        }
+        uint64_t fim = series.total(serie);
+        if (fim > series.amostrasPorSerie()) {
+            inicio = std::max<uint64_t>(inicio, fim - series.amostrasPorSerie());
+        }
+        while (inicio < fim) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(fim - inicio, ALERTA_LOTE));
+            avaliarLote(series, serie, inicio, n);
+            inicio += n;
+        }
+    }
+};
+
+#endif // MOTOR_ALERTAS_HPP
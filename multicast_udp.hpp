@@ -0,0 +1,93 @@
+/**
+ * @file multicast_udp.hpp
+ * @brief Publicação das amostras em um grupo multicast IPv4 e entrada do coletor no grupo.
+ *
+ * @details Com o cliente publicando em um grupo (ex.: 239.255.42.10) em vez de um endereço
+ * unicast, qualquer número de coletores (principal, reserva, análise) recebe o mesmo fluxo com
+ * uma única transmissão da placa. O alcance é limitado pelo TTL (1: só a rede local) e a
+ * interface de saída pode ser escolhida (127.0.0.1 para testes no loopback).
+ *
+ * No coletor, os sockets SO_REUSEPORT de todos os trabalhadores estão ligados à mesma porta; o
+ * kernel entrega uma cópia de cada datagrama multicast a todo socket da porta que o aceite, de
+ * modo que só o primeiro entra no grupo e os demais desligam IP_MULTICAST_ALL (sem o qual
+ * receberiam também os grupos em que outro socket do sistema entrou).
+ */
+
+#ifndef MULTICAST_UDP_HPP
+#define MULTICAST_UDP_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#ifndef IP_MULTICAST_ALL
+#define IP_MULTICAST_ALL 49
+#endif
+
+/** @def MULTICAST_GRUPO_PADRAO
+ * @brief Grupo sugerido para o fluxo das placas (escopo administrativo local, 239.255.0.0/16).
+ */
+#define MULTICAST_GRUPO_PADRAO "239.255.42.10"
+
+/** @def MULTICAST_TTL_PADRAO
+ * @brief TTL padrão dos datagramas publicados (1: não passa de um roteador).
+ */
+#define MULTICAST_TTL_PADRAO 1
+
+/**
+ * @brief true se @p endereco (ordem da rede) é um grupo multicast IPv4 (224.0.0.0/4).
+ */
+inline bool ehMulticast(in_addr endereco) {
+    return IN_MULTICAST(ntohl(endereco.s_addr));
+}
+
+/**
+ * @brief Configura o socket de envio para publicar em um grupo.
+ * @param ttl TTL dos datagramas.
+ * @param interfaceIp Endereço da interface de saída, ou nulo para a rota do grupo.
+ * @return 0 ou -errno (EINVAL: interface inválida).
+ */
+inline int configurarPublicacaoMulticast(int sock, int ttl, const char* interfaceIp) {
+    unsigned char t = static_cast<unsigned char>(ttl);
+    unsigned char laco = 1; // coletores na própria máquina também recebem
+    if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &t, sizeof(t)) < 0 ||
+        setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &laco, sizeof(laco)) < 0) {
+        return -errno;
+    }
+    if (interfaceIp != nullptr) {
+        in_addr interface{};
+        if (inet_pton(AF_INET, interfaceIp, &interface) <= 0) {
+            return -EINVAL;
+        }
+        if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) < 0) {
+            return -errno;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Faz o socket receber só os grupos em que ele próprio entrou.
+ * @return 0 ou -errno.
+ */
+inline int restringirMulticast(int sock) {
+    int zero = 0;
+    return setsockopt(sock, IPPROTO_IP, IP_MULTICAST_ALL, &zero, sizeof(zero)) < 0 ? -errno : 0;
+}
+
+/**
+ * @brief Entra no grupo @p grupo pela interface @p interfaceIp ("0.0.0.0": a da rota do grupo).
+ * @return 0 ou -errno (EINVAL: endereço inválido ou não multicast).
+ */
+inline int entrarGrupoMulticast(int sock, const char* grupo, const char* interfaceIp) {
+    ip_mreq pedido{};
+    if (inet_pton(AF_INET, grupo, &pedido.imr_multiaddr) <= 0 || !ehMulticast(pedido.imr_multiaddr) ||
+        inet_pton(AF_INET, interfaceIp, &pedido.imr_interface) <= 0) {
+        return -EINVAL;
+    }
+    return setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &pedido, sizeof(pedido)) < 0 ? -errno : 0;
+}
+
+#endif // MULTICAST_UDP_HPP
@@ -0,0 +1,443 @@
+/**
+ * @file protocolo_ldr.hpp
+ * @brief Formato dos datagramas do sensor LDR e decodificação para amostras.
+ *
+ * @details São aceitos dois formatos:
+ * - texto (legado): a luminosidade percentual em ASCII (ex.: "75"), sem terminador, como envia
+ *   o `clienteUDP_sensor_ldr.cpp` original; a amostra é carimbada com o instante de recepção;
+ * - binário (versão 1): um CabecalhoLDR seguido de `n_amostras` registros AmostraWireLDR.
+ *   Todos os campos estão na ordem de bytes da rede. O identificador do sensor ocupa os
+ *   bytes 4 a 7 do datagrama, posição fixa usada pelo direcionamento BPF do coletor.
+ *
+ * No modo confiável (flag LDR_FLAG_CONFIAVEL), o coletor devolve periodicamente ao remetente um
+ * datagrama de confirmação seletiva (CabecalhoAckLDR) por sensor; ver confiabilidade_udp.hpp.
+ *
+ * No modo FEC (flag LDR_FLAG_FEC), o remetente envia, após cada grupo de datagramas de um sensor,
+ * pacotes de reparo (CabecalhoFecLDR) com a paridade XOR do grupo; ver fec_udp.hpp.
+ *
+ * Um coletor em modo gateway repassa ao coletor central, em vez dos datagramas das placas, lotes
+ * comprimidos (CabecalhoLoteLDR) com as amostras de vários sensores; ver gateway_lotes.hpp.
+ *
+ * Para a sincronização dos relógios, a placa envia periodicamente um pedido (CabecalhoSincLDR) e
+ * o coletor responde com os seus instantes de chegada e de envio; ver sincronizacao_relogio.hpp.
+ *
+ * Os assinantes da difusão do coletor recebem, entre os datagramas binários, as transições de
+ * alerta (CabecalhoAlertaLDR); ver difusao_amostras.hpp.
+ */
+
+#ifndef PROTOCOLO_LDR_HPP
+#define PROTOCOLO_LDR_HPP
+
+#include <arpa/inet.h>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <endian.h>
+
+/** @def LDR_MAGIA
+ * @brief Valor do campo magia do cabeçalho binário ("LD").
+ */
+#define LDR_MAGIA 0x4C44
+
+/** @def LDR_VERSAO
+ * @brief Versão do formato binário.
+ */
+#define LDR_VERSAO 1
+
+/** @def LDR_OFFSET_ID_SENSOR
+ * @brief Posição do identificador do sensor no datagrama binário.
+ */
+#define LDR_OFFSET_ID_SENSOR 4
+
+/** @def LDR_FLAG_CONFIAVEL
+ * @brief Flag do cabeçalho: o remetente guarda o datagrama para retransmissão e espera confirmações.
+ */
+#define LDR_FLAG_CONFIAVEL 0x01
+
+/** @def LDR_FLAG_FEC
+ * @brief Flag do cabeçalho: o datagrama faz parte de um grupo protegido por pacotes de reparo.
+ */
+#define LDR_FLAG_FEC 0x02
+
+/** @def LDR_MAGIA_FEC
+ * @brief Valor do campo magia de um pacote de reparo ("LF").
+ */
+#define LDR_MAGIA_FEC 0x4C46
+
+/** @def LDR_MAGIA_ACK
+ * @brief Valor do campo magia de um datagrama de confirmação ("LA").
+ */
+#define LDR_MAGIA_ACK 0x4C41
+
+/** @def LDR_MAGIA_LOTE
+ * @brief Valor do campo magia de um lote comprimido de um gateway ("LG").
+ */
+#define LDR_MAGIA_LOTE 0x4C47
+
+/** @def LDR_MAGIA_SINC
+ * @brief Valor do campo magia de um pedido ou resposta de sincronização de relógio ("LS").
+ */
+#define LDR_MAGIA_SINC 0x4C53
+
+/** @def LDR_MAGIA_ALERTA
+ * @brief Valor do campo magia de uma transição de alerta publicada aos assinantes ("LE").
+ */
+#define LDR_MAGIA_ALERTA 0x4C45
+
+/** @def LDR_ALERTA_NOME
+ * @brief Bytes do nome da regra em uma transição de alerta (truncado, completado com zeros).
+ */
+#define LDR_ALERTA_NOME 40
+
+/** @def LDR_SINC_PEDIDO
+ * @brief Tipo de um datagrama de sincronização enviado pela placa.
+ */
+#define LDR_SINC_PEDIDO 0
+
+/** @def LDR_SINC_RESPOSTA
+ * @brief Tipo de um datagrama de sincronização devolvido pelo coletor.
+ */
+#define LDR_SINC_RESPOSTA 1
+
+/** @def LDR_ACK_PALAVRAS
+ * @brief Palavras de 64 bits do mapa de confirmação (cobre 1024 sequências após a base).
+ */
+#define LDR_ACK_PALAVRAS 16
+
+/** @def LDR_MAX_AMOSTRAS_DATAGRAMA
+ * @brief Número máximo de amostras em um datagrama binário.
+ */
+#define LDR_MAX_AMOSTRAS_DATAGRAMA 128
+
+/**
+ * @brief Amostra decodificada (tamanho fixo, sem alocação).
+ */
+struct AmostraLDR {
+    uint64_t t_ns;      /**< Instante da amostra (CLOCK_REALTIME, ns). */
+    uint32_t id_sensor; /**< Identificador do sensor (0 = sensor único, "LDR_KY-018"). */
+    uint32_t seq;       /**< Número de sequência da amostra no sensor (0 no formato texto). */
+    int32_t valor;      /**< Luminosidade percentual (0 a 100). */
+};
+
+/**
+ * @brief Cabeçalho do datagrama binário (ordem de bytes da rede).
+ */
+struct __attribute__((packed)) CabecalhoLDR {
+    uint16_t magia;      /**< LDR_MAGIA. */
+    uint8_t versao;      /**< LDR_VERSAO. */
+    uint8_t flags;       /**< LDR_FLAG_CONFIAVEL e/ou LDR_FLAG_FEC. */
+    uint32_t id_sensor;  /**< Identificador do sensor (offset LDR_OFFSET_ID_SENSOR). */
+    uint32_t seq;        /**< Sequência da primeira amostra; as seguintes são seq + i. */
+    uint16_t n_amostras; /**< Número de amostras que seguem o cabeçalho. */
+    uint16_t taxa_dhz;   /**< Taxa de amostragem do lote em décimos de Hz (0: não informada). */
+    uint64_t t0_ns;      /**< Instante da primeira amostra (CLOCK_REALTIME do cliente, ns). */
+};
+static_assert(sizeof(CabecalhoLDR) == 24, "CabecalhoLDR deve ter 24 bytes");
+static_assert(offsetof(CabecalhoLDR, id_sensor) == LDR_OFFSET_ID_SENSOR, "id_sensor fora da posicao do BPF");
+
+/**
+ * @brief Campos do cabeçalho binário que não fazem parte das amostras.
+ */
+struct MetadadosLDR {
+    uint8_t flags = 0;     /**< LDR_FLAG_CONFIAVEL e/ou LDR_FLAG_FEC. */
+    uint16_t taxaDhz = 0;  /**< Taxa de amostragem do lote em décimos de Hz (0: não informada). */
+    bool binario = false;  /**< Formato binário: os instantes vêm do relógio da placa. */
+};
+
+/**
+ * @brief Cabeçalho de uma confirmação seletiva (ordem de bytes da rede), seguido de `palavras`
+ * palavras de 64 bits: o bit k da palavra w confirma a sequência `base + 64 * w + k`.
+ */
+struct __attribute__((packed)) CabecalhoAckLDR {
+    uint16_t magia;      /**< LDR_MAGIA_ACK. */
+    uint8_t versao;      /**< LDR_VERSAO. */
+    uint8_t palavras;    /**< Palavras do mapa (até LDR_ACK_PALAVRAS). */
+    uint32_t id_sensor;  /**< Sensor confirmado. */
+    uint32_t base;       /**< Sequências de inicio até base - 1 foram recebidas (ou abandonadas). */
+    uint32_t inicio;     /**< Menor sequência rastreada pelo coletor; as anteriores não foram vistas. */
+};
+static_assert(sizeof(CabecalhoAckLDR) == 16, "CabecalhoAckLDR deve ter 16 bytes");
+
+/**
+ * @brief Cabeçalho de um pacote de reparo (ordem de bytes da rede).
+ *
+ * @details Seguem o cabeçalho as sequências (uint32) dos `k` datagramas do grupo, na ordem de
+ * envio, e a paridade: o XOR, completado com zeros até o maior deles, dos datagramas de índice
+ * `indice`, `indice + m`, `indice + 2m`... do grupo. O identificador do sensor ocupa a mesma
+ * posição do datagrama de dados, e o reparo segue para o mesmo núcleo do coletor.
+ */
+struct __attribute__((packed)) CabecalhoFecLDR {
+    uint16_t magia;      /**< LDR_MAGIA_FEC. */
+    uint8_t versao;      /**< LDR_VERSAO. */
+    uint8_t indice;      /**< Índice do reparo no grupo (0 a m - 1). */
+    uint32_t id_sensor;  /**< Sensor do grupo (offset LDR_OFFSET_ID_SENSOR). */
+    uint32_t grupo;      /**< Número do grupo no remetente. */
+    uint8_t k;           /**< Datagramas no grupo. */
+    uint8_t m;           /**< Pacotes de reparo do grupo. */
+    uint16_t tamanho;    /**< XOR dos tamanhos dos datagramas cobertos. */
+};
+static_assert(sizeof(CabecalhoFecLDR) == 16, "CabecalhoFecLDR deve ter 16 bytes");
+static_assert(offsetof(CabecalhoFecLDR, id_sensor) == LDR_OFFSET_ID_SENSOR, "id_sensor fora da posicao do BPF");
+
+/**
+ * @brief Cabeçalho de um lote comprimido de um gateway (ordem de bytes da rede).
+ *
+ * @details Seguem o cabeçalho `n_blocos` blocos de amostras consecutivas de um sensor,
+ * codificados em varints (layout em gateway_lotes.hpp). O identificador do gateway ocupa a
+ * posição do identificador do sensor, mas a magia é outra: o direcionamento BPF do coletor usa
+ * o hash do kernel para os lotes.
+ */
+struct __attribute__((packed)) CabecalhoLoteLDR {
+    uint16_t magia;      /**< LDR_MAGIA_LOTE. */
+    uint8_t versao;      /**< LDR_VERSAO. */
+    uint8_t flags;       /**< Reservado (0). */
+    uint32_t id_gateway; /**< Identificador do gateway. */
+    uint32_t seq;        /**< Número do lote no gateway (lacunas indicam lotes perdidos). */
+    uint16_t n_blocos;   /**< Blocos no lote. */
+    uint16_t n_amostras; /**< Soma das amostras dos blocos. */
+    uint64_t t_base_ns;  /**< Instante de referência dos blocos (o da primeira amostra do lote). */
+};
+static_assert(sizeof(CabecalhoLoteLDR) == 24, "CabecalhoLoteLDR deve ter 24 bytes");
+
+/**
+ * @brief Pedido da placa ou resposta do coletor na sincronização de relógio (ordem de bytes da rede).
+ *
+ * @details Os instantes são de CLOCK_REALTIME: t1 e t4 do relógio da placa, t2 e t3 do coletor.
+ * Cada pedido leva também o instante em que a resposta ao pedido anterior chegou, de modo que o
+ * coletor dispõe dos quatro instantes da troca sem datagrama adicional. A resposta repete o
+ * pedido com t2 e t3 preenchidos.
+ */
+struct __attribute__((packed)) CabecalhoSincLDR {
+    uint16_t magia;          /**< LDR_MAGIA_SINC. */
+    uint8_t versao;          /**< LDR_VERSAO. */
+    uint8_t tipo;            /**< LDR_SINC_PEDIDO ou LDR_SINC_RESPOSTA. */
+    uint32_t id_sensor;      /**< Placa (offset LDR_OFFSET_ID_SENSOR). */
+    uint32_t seq;            /**< Número do pedido. */
+    uint32_t seq_anterior;   /**< Pedido a que se refere t4_anterior_ns. */
+    uint64_t t1_ns;          /**< Envio do pedido (placa). */
+    uint64_t t4_anterior_ns; /**< Chegada da resposta a seq_anterior (placa; 0 se não chegou). */
+    uint64_t t2_ns;          /**< Chegada do pedido (coletor; só na resposta). */
+    uint64_t t3_ns;          /**< Envio da resposta (coletor; só na resposta). */
+};
+static_assert(sizeof(CabecalhoSincLDR) == 48, "CabecalhoSincLDR deve ter 48 bytes");
+static_assert(offsetof(CabecalhoSincLDR, id_sensor) == LDR_OFFSET_ID_SENSOR, "id_sensor fora da posicao do BPF");
+
+/**
+ * @brief Transição de alerta publicada na difusão do coletor (ordem de bytes da rede).
+ */
+struct __attribute__((packed)) CabecalhoAlertaLDR {
+    uint16_t magia;             /**< LDR_MAGIA_ALERTA. */
+    uint8_t versao;             /**< LDR_VERSAO. */
+    uint8_t ativo;              /**< 1 = disparo, 0 = normalização. */
+    uint32_t id_sensor;         /**< Sensor. */
+    int32_t valor;              /**< Valor da amostra que completou a transição. */
+    uint32_t reservado;         /**< Zero. */
+    uint64_t t_ns;              /**< Instante dessa amostra. */
+    char nome[LDR_ALERTA_NOME]; /**< Nome da regra. */
+};
+static_assert(sizeof(CabecalhoAlertaLDR) == 64, "CabecalhoAlertaLDR deve ter 64 bytes");
+
+/**
+ * @brief Amostra no datagrama binário (ordem de bytes da rede).
+ */
+struct __attribute__((packed)) AmostraWireLDR {
+    uint32_t dt_us; /**< Deslocamento em relação a t0_ns (µs). */
+    int32_t valor;  /**< Luminosidade percentual. */
+};
+
+/**
+ * @brief Decodifica um datagrama de texto ("0" a "100", com espaços em branco opcionais).
+ * @return true se o datagrama contém um inteiro válido.
+ */
+inline bool decodificarTexto(const char* dados, size_t tamanho, uint64_t t_recepcao_ns, AmostraLDR& saida) {
+    const char* p = dados;
+    const char* fim = dados + tamanho;
+    while (p < fim && (*p == ' ' || *p == '\t')) p++;
+    while (fim > p && (fim[-1] == ' ' || fim[-1] == '\t' || fim[-1] == '\n' || fim[-1] == '\r')) fim--;
+    int valor = 0;
+    std::from_chars_result r = std::from_chars(p, fim, valor);
+    if (p == fim || r.ec != std::errc() || r.ptr != fim) {
+        return false;
+    }
+    saida.t_ns = t_recepcao_ns;
+    saida.id_sensor = 0;
+    saida.seq = 0;
+    saida.valor = valor;
+    return true;
+}
+
+/**
+ * @brief Codifica uma amostra no formato texto (o inteiro em ASCII, sem terminador nem alocação).
+ * @return Tamanho do datagrama, ou 0 se não couber em @p capacidade.
+ */
+inline size_t codificarTexto(char* destino, size_t capacidade, int32_t valor) {
+    std::to_chars_result r = std::to_chars(destino, destino + capacidade, valor);
+    return r.ec == std::errc() ? static_cast<size_t>(r.ptr - destino) : 0;
+}
+
+/**
+ * @brief Decodifica um datagrama (binário ou texto) em amostras.
+ *
+ * @param dados Conteúdo do datagrama.
+ * @param tamanho Tamanho em bytes.
+ * @param t_recepcao_ns Instante de recepção (carimbo das amostras do formato texto).
+ * @param saida Vetor com espaço para @p maximo amostras.
+ * @param maximo Capacidade de @p saida.
+ * @param metadados Recebe as flags e a taxa do cabeçalho binário (zeradas no formato texto), se não for nulo.
+ * @return Número de amostras decodificadas (0 se o datagrama é inválido).
+ */
+inline size_t decodificarDatagrama(const char* dados, size_t tamanho, uint64_t t_recepcao_ns,
+                                   AmostraLDR* saida, size_t maximo, MetadadosLDR* metadados = nullptr) {
+    if (metadados != nullptr) {
+        *metadados = MetadadosLDR{};
+    }
+    CabecalhoLDR cab;
+    if (tamanho < sizeof(cab)) {
+        return decodificarTexto(dados, tamanho, t_recepcao_ns, saida[0]) ? 1 : 0;
+    }
+    memcpy(&cab, dados, sizeof(cab));
+    if (ntohs(cab.magia) != LDR_MAGIA) {
+        return decodificarTexto(dados, tamanho, t_recepcao_ns, saida[0]) ? 1 : 0;
+    }
+    size_t n = ntohs(cab.n_amostras);
+    if (cab.versao != LDR_VERSAO || n > maximo || tamanho != sizeof(cab) + n * sizeof(AmostraWireLDR)) {
+        return 0;
+    }
+    uint32_t id = ntohl(cab.id_sensor);
+    uint32_t seq = ntohl(cab.seq);
+    uint64_t t0 = be64toh(cab.t0_ns);
+    if (metadados != nullptr) {
+        metadados->flags = cab.flags;
+        metadados->taxaDhz = ntohs(cab.taxa_dhz);
+        metadados->binario = true;
+    }
+    const char* p = dados + sizeof(cab);
+    for (size_t i = 0; i < n; i++, p += sizeof(AmostraWireLDR)) {
+        AmostraWireLDR w;
+        memcpy(&w, p, sizeof(w));
+        saida[i].t_ns = t0 + static_cast<uint64_t>(ntohl(w.dt_us)) * 1000ull;
+        saida[i].id_sensor = id;
+        saida[i].seq = seq + static_cast<uint32_t>(i);
+        saida[i].valor = static_cast<int32_t>(ntohl(static_cast<uint32_t>(w.valor)));
+    }
+    return n;
+}
+
+/**
+ * @brief Codifica amostras consecutivas de um sensor em um datagrama binário.
+ *
+ * @details O cabeçalho usa o id, a sequência e o instante da primeira amostra; as demais são
+ * codificadas como deslocamentos em µs.
+ *
+ * @param destino Buffer de saída.
+ * @param capacidade Tamanho do buffer.
+ * @param amostras Amostras de um mesmo sensor, em ordem de sequência.
+ * @param n Número de amostras (1 a LDR_MAX_AMOSTRAS_DATAGRAMA).
+ * @param flags Flags do cabeçalho (ex.: LDR_FLAG_CONFIAVEL).
+ * @param taxaDhz Taxa de amostragem do lote em décimos de Hz (0: não informada).
+ * @return Tamanho do datagrama, ou 0 se não couber em @p capacidade.
+ */
+inline size_t codificarDatagrama(char* destino, size_t capacidade, const AmostraLDR* amostras, size_t n,
+                                 uint8_t flags = 0, uint16_t taxaDhz = 0) {
+    size_t tamanho = sizeof(CabecalhoLDR) + n * sizeof(AmostraWireLDR);
+    if (n == 0 || n > LDR_MAX_AMOSTRAS_DATAGRAMA || tamanho > capacidade) {
+        return 0;
+    }
+    CabecalhoLDR cab{};
+    cab.magia = htons(LDR_MAGIA);
+    cab.versao = LDR_VERSAO;
+    cab.flags = flags;
+    cab.id_sensor = htonl(amostras[0].id_sensor);
+    cab.seq = htonl(amostras[0].seq);
+    cab.n_amostras = htons(static_cast<uint16_t>(n));
+    cab.taxa_dhz = htons(taxaDhz);
+    cab.t0_ns = htobe64(amostras[0].t_ns);
+    memcpy(destino, &cab, sizeof(cab));
+    char* p = destino + sizeof(cab);
+    for (size_t i = 0; i < n; i++, p += sizeof(AmostraWireLDR)) {
+        AmostraWireLDR w;
+        w.dt_us = htonl(static_cast<uint32_t>((amostras[i].t_ns - amostras[0].t_ns) / 1000ull));
+        w.valor = static_cast<int32_t>(htonl(static_cast<uint32_t>(amostras[i].valor)));
+        memcpy(p, &w, sizeof(w));
+    }
+    return tamanho;
+}
+
+/**
+ * @brief Codifica uma confirmação seletiva.
+ * @param mapa @p palavras palavras do mapa (ordem do host).
+ * @return Tamanho do datagrama, ou 0 se não couber em @p capacidade.
+ */
+inline size_t codificarAck(char* destino, size_t capacidade, uint32_t id_sensor, uint32_t inicio, uint32_t base,
+                           const uint64_t* mapa, size_t palavras) {
+    size_t tamanho = sizeof(CabecalhoAckLDR) + palavras * sizeof(uint64_t);
+    if (palavras > LDR_ACK_PALAVRAS || tamanho > capacidade) {
+        return 0;
+    }
+    CabecalhoAckLDR cab{};
+    cab.magia = htons(LDR_MAGIA_ACK);
+    cab.versao = LDR_VERSAO;
+    cab.palavras = static_cast<uint8_t>(palavras);
+    cab.id_sensor = htonl(id_sensor);
+    cab.base = htonl(base);
+    cab.inicio = htonl(inicio);
+    memcpy(destino, &cab, sizeof(cab));
+    for (size_t w = 0; w < palavras; w++) {
+        uint64_t v = htobe64(mapa[w]);
+        memcpy(destino + sizeof(cab) + w * sizeof(v), &v, sizeof(v));
+    }
+    return tamanho;
+}
+
+/**
+ * @brief Decodifica uma confirmação seletiva.
+ * @param mapa Recebe até LDR_ACK_PALAVRAS palavras (as ausentes são zeradas).
+ * @return true se o datagrama é uma confirmação válida.
+ */
+inline bool decodificarAck(const char* dados, size_t tamanho, uint32_t& id_sensor, uint32_t& inicio,
+                           uint32_t& base, uint64_t* mapa) {
+    CabecalhoAckLDR cab;
+    if (tamanho < sizeof(cab)) {
+        return false;
+    }
+    memcpy(&cab, dados, sizeof(cab));
+    if (ntohs(cab.magia) != LDR_MAGIA_ACK || cab.versao != LDR_VERSAO || cab.palavras > LDR_ACK_PALAVRAS ||
+        tamanho != sizeof(cab) + cab.palavras * sizeof(uint64_t)) {
+        return false;
+    }
+    id_sensor = ntohl(cab.id_sensor);
+    base = ntohl(cab.base);
+    inicio = ntohl(cab.inicio);
+    for (size_t w = 0; w < LDR_ACK_PALAVRAS; w++) {
+        uint64_t v = 0;
+        if (w < cab.palavras) {
+            memcpy(&v, dados + sizeof(cab) + w * sizeof(v), sizeof(v));
+        }
+        mapa[w] = be64toh(v);
+    }
+    return true;
+}
+
+/**
+ * @brief Codifica uma transição de alerta.
+ * @return Tamanho do registro, ou 0 se não couber em @p capacidade.
+ */
+inline size_t codificarAlerta(char* destino, size_t capacidade, uint32_t id_sensor, bool ativo, int32_t valor,
+                              uint64_t t_ns, const char* nome) {
+    if (capacidade < sizeof(CabecalhoAlertaLDR)) {
+        return 0;
+    }
+    CabecalhoAlertaLDR cab{};
+    cab.magia = htons(LDR_MAGIA_ALERTA);
+    cab.versao = LDR_VERSAO;
+    cab.ativo = ativo ? 1 : 0;
+    cab.id_sensor = htonl(id_sensor);
+    cab.valor = static_cast<int32_t>(htonl(static_cast<uint32_t>(valor)));
+    cab.t_ns = htobe64(t_ns);
+    memcpy(cab.nome, nome, strnlen(nome, sizeof(cab.nome)));
+    memcpy(destino, &cab, sizeof(cab));
+    return sizeof(cab);
+}
+
+#endif // PROTOCOLO_LDR_HPP
@@ -0,0 +1,748 @@
+/**
+ * @file recepcao_udp.hpp
+ * @brief Laços de eventos de recepção UDP do coletor: interface comum e backend epoll + recvmmsg.
+ *
+ * @details Cada backend executa, em um único thread, a recepção dos datagramas de um socket,
+ * a anexação das amostras ao ArmazemAmostras e um temporizador periódico. Ao contrário do
+ * servidor Python (`iniciar_servidor_udp()`), nenhum thread fica bloqueado em um `recvfrom()`
+ * por datagrama: os datagramas são lidos em lote e o mesmo laço atende o disco e o temporizador.
+ */
+
+#ifndef RECEPCAO_UDP_HPP
+#define RECEPCAO_UDP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "anel_compartilhado.hpp"
+#include "armazem_amostras.hpp"
+#include "confiabilidade_udp.hpp"
+#include "diario_amostras.hpp"
+#include "difusao_amostras.hpp"
+#include "fec_udp.hpp"
+#include "gateway_lotes.hpp"
+#include "gso_udp.hpp"
+#include "motor_alertas.hpp"
+#include "pool_buffers.hpp"
+#include "protocolo_ldr.hpp"
+#include "series_amostras.hpp"
+#include "sincronizacao_relogio.hpp"
+
+/** @def RECEPCAO_TAMANHO_DATAGRAMA
+ * @brief Tamanho máximo de um datagrama recebido.
+ */
+#define RECEPCAO_TAMANHO_DATAGRAMA 2048
+
+/** @def RECEPCAO_LOTE
+ * @brief Número máximo de datagramas lidos por chamada a recvmmsg().
+ */
+#define RECEPCAO_LOTE 64
+
+/** @def RECEPCAO_LOTE_GRO
+ * @brief Número máximo de leituras por chamada a recvmmsg() com UDP_GRO (cada uma com GRO_TAMANHO_BUFFER).
+ */
+#define RECEPCAO_LOTE_GRO 16
+
+/**
+ * @brief Amostras decodificadas de um datagrama, guardadas em um bloco do pool de lotes.
+ */
+struct LoteAmostras {
+    uint32_t n;                                       /**< Número de amostras válidas. */
+    uint16_t taxaDhz;                                 /**< Taxa de amostragem informada (décimos de Hz, 0 se ausente). */
+    AmostraLDR amostras[LDR_MAX_AMOSTRAS_DATAGRAMA];  /**< Amostras, na ordem do datagrama. */
+};
+
+/**
+ * @brief Contadores da recepção (escritos pelo thread do laço, lidos por qualquer thread).
+ */
+struct EstatisticasRecepcao {
+    std::atomic<uint64_t> datagramas{0}; /**< Datagramas recebidos. */
+    std::atomic<uint64_t> amostras{0};   /**< Amostras válidas decodificadas. */
+    std::atomic<uint64_t> invalidos{0};  /**< Datagramas que não puderam ser decodificados. */
+    std::atomic<uint64_t> bytes{0};      /**< Bytes de carga útil recebidos. */
+    std::atomic<uint64_t> duplicados{0}; /**< Datagramas confiáveis já recebidos (retransmissões descartadas). */
+    std::atomic<uint64_t> reparos{0};    /**< Pacotes de reparo FEC recebidos. */
+    std::atomic<uint64_t> agregados{0};  /**< Leituras com mais de um datagrama (UDP_GRO). */
+    std::atomic<uint64_t> lotesGateway{0}; /**< Lotes comprimidos recebidos de gateways. */
+    std::atomic<uint64_t> sincronizacoes{0}; /**< Pedidos de sincronização de relógio recebidos. */
+
+    /** @brief Soma @p n a um contador (há um único escritor, não precisa de RMW atômico). */
+    static void somar(std::atomic<uint64_t>& c, uint64_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+/** @def RECEPCAO_MAX_SENSORES
+ * @brief Capacidade da tabela de sensores de cada laço de recepção (potência de 2).
+ */
+#define RECEPCAO_MAX_SENSORES 1024
+
+/**
+ * @brief Resumo de um sensor visto por um laço de recepção.
+ */
+struct ResumoSensor {
+    std::atomic<uint32_t> id{0};             /**< Identificador do sensor. */
+    std::atomic<bool> ocupado{false};        /**< Entrada em uso. */
+    std::atomic<uint64_t> amostras{0};       /**< Amostras recebidas. */
+    std::atomic<uint64_t> foraDeOrdem{0};    /**< Amostras com sequência menor ou igual à anterior. */
+    std::atomic<uint32_t> ultimaSeq{0};      /**< Sequência da última amostra. */
+    std::atomic<int32_t> ultimoValor{0};     /**< Valor da última amostra. */
+    std::atomic<uint64_t> ultimoT_ns{0};     /**< Instante da última amostra. */
+    std::atomic<uint16_t> taxaDhz{0};        /**< Última taxa de amostragem informada (décimos de Hz). */
+    std::atomic<uint32_t> trocasRelogio{0};  /**< Trocas de sincronização de relógio (0: instantes sem correção). */
+    std::atomic<int64_t> adiantamentoNs{0};  /**< Quanto o relógio da placa está adiantado em relação ao coletor. */
+    std::atomic<int32_t> derivaPpb{0};       /**< Deriva do relógio da placa (partes por bilhão). */
+    std::atomic<int64_t> incertezaNs{0};     /**< Incerteza da correção dos instantes. */
+};
+
+/**
+ * @class TabelaSensores
+ * @brief Tabela de resumos por sensor, com um único escritor (o laço de recepção).
+ *
+ * @details Endereçamento aberto com sondagem linear. Os campos são atômicos relaxados para que
+ * outro thread possa consultá-la a qualquer momento sem travar o laço; cada laço possui a sua
+ * tabela, e a agregação entre laços só acontece na consulta.
+ */
+class TabelaSensores {
+private:
+    /**< Entradas da tabela. */
+    ResumoSensor entradas[RECEPCAO_MAX_SENSORES];
+
+    /**< Amostras de sensores que não couberam na tabela. */
+    std::atomic<uint64_t> excedentes{0};
+
+    /**
+     * @brief Entrada do sensor @p id, criada se ainda não existe.
+     * @return Nulo com a tabela cheia.
+     */
+    ResumoSensor* localizar(uint32_t id) {
+        uint32_t h = (id * 2654435761u) & (RECEPCAO_MAX_SENSORES - 1);
+        for (uint32_t i = 0; i < RECEPCAO_MAX_SENSORES; i++) {
+            ResumoSensor& e = entradas[(h + i) & (RECEPCAO_MAX_SENSORES - 1)];
+            if (!e.ocupado.load(std::memory_order_relaxed)) {
+                e.id.store(id, std::memory_order_relaxed);
+                e.ocupado.store(true, std::memory_order_release);
+                return &e;
+            }
+            if (e.id.load(std::memory_order_relaxed) == id) {
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+
+public:
+    /**
+     * @brief Registra uma amostra no resumo do seu sensor.
+     * @param taxaDhz Taxa de amostragem informada pelo remetente (0 mantém a anterior).
+     * @return Taxa de amostragem anterior do sensor (décimos de Hz).
+     */
+    uint16_t registrar(const AmostraLDR& a, uint16_t taxaDhz = 0) {
+        ResumoSensor* e = localizar(a.id_sensor);
+        if (e == nullptr) {
+            excedentes.store(excedentes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return 0;
+        }
+        uint64_t n = e->amostras.load(std::memory_order_relaxed);
+        if (n > 0 && static_cast<int32_t>(a.seq - e->ultimaSeq.load(std::memory_order_relaxed)) <= 0 && a.seq != 0) {
+            e->foraDeOrdem.store(e->foraDeOrdem.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        e->ultimaSeq.store(a.seq, std::memory_order_relaxed);
+        e->ultimoValor.store(a.valor, std::memory_order_relaxed);
+        e->ultimoT_ns.store(a.t_ns, std::memory_order_relaxed);
+        e->amostras.store(n + 1, std::memory_order_relaxed);
+        uint16_t anterior = e->taxaDhz.load(std::memory_order_relaxed);
+        if (taxaDhz != 0) {
+            e->taxaDhz.store(taxaDhz, std::memory_order_relaxed);
+        }
+        return anterior;
+    }
+
+    /**
+     * @brief Publica no resumo do sensor @p id a estimativa atual do seu relógio.
+     */
+    void registrarRelogio(uint32_t id, const EstimadorRelogio& relogio) {
+        ResumoSensor* e = localizar(id);
+        if (e == nullptr) {
+            return;
+        }
+        e->adiantamentoNs.store(relogio.adiantamentoNs(), std::memory_order_relaxed);
+        e->derivaPpb.store(static_cast<int32_t>(std::lround(relogio.derivaPpm() * 1000.0)), std::memory_order_relaxed);
+        e->incertezaNs.store(relogio.incertezaNs(), std::memory_order_relaxed);
+        e->trocasRelogio.store(relogio.trocasTotais(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Percorre os sensores presentes (pode ser chamado de outro thread).
+     */
+    template <typename Funcao>
+    void paraCada(Funcao&& f) const {
+        for (const ResumoSensor& e : entradas) {
+            if (e.ocupado.load(std::memory_order_acquire)) {
+                f(e);
+            }
+        }
+    }
+};
+
+/** @def RECEPCAO_MAX_ORIGENS
+ * @brief Capacidade da tabela de remetentes de cada laço de recepção (potência de 2).
+ */
+#define RECEPCAO_MAX_ORIGENS 256
+
+/**
+ * @brief Resumo de um remetente (endereço e porta de origem) visto por um laço de recepção.
+ */
+struct ResumoOrigem {
+    std::atomic<uint64_t> chave{0};          /**< Endereço IPv4 (32 bits altos) e porta, na ordem da rede. */
+    std::atomic<bool> ocupado{false};        /**< Entrada em uso. */
+    std::atomic<uint64_t> datagramas{0};     /**< Datagramas de amostras recebidos. */
+    std::atomic<uint64_t> amostras{0};       /**< Amostras válidas recebidas. */
+    std::atomic<uint32_t> ultimoSensor{0};   /**< Sensor do último datagrama. */
+    std::atomic<uint64_t> ultimaChegadaNs{0}; /**< Instante de recepção do último datagrama (CLOCK_REALTIME). */
+
+    /** @brief Endereço do remetente (ordem da rede). */
+    in_addr endereco() const { return in_addr{static_cast<in_addr_t>(chave.load(std::memory_order_relaxed) >> 32)}; }
+
+    /** @brief Porta do remetente (ordem do host). */
+    uint16_t porta() const { return ntohs(static_cast<uint16_t>(chave.load(std::memory_order_relaxed))); }
+};
+
+/**
+ * @class TabelaOrigens
+ * @brief Tabela de resumos por remetente, com um único escritor (o laço de recepção).
+ *
+ * @details Mesma organização da TabelaSensores. Com o fluxo em multicast, os remetentes não são
+ * conhecidos de antemão: é por ela que o coletor sabe quais placas publicam no grupo.
+ */
+class TabelaOrigens {
+private:
+    /**< Entradas da tabela. */
+    ResumoOrigem entradas[RECEPCAO_MAX_ORIGENS];
+
+    /**< Datagramas de remetentes que não couberam na tabela. */
+    std::atomic<uint64_t> excedentes{0};
+
+public:
+    /**
+     * @brief Registra um datagrama de @p origem.
+     * @return true se é o primeiro datagrama do remetente.
+     */
+    bool registrar(const sockaddr_in& origem, uint32_t amostras, uint32_t sensor, uint64_t agoraNs) {
+        uint64_t chave = static_cast<uint64_t>(origem.sin_addr.s_addr) << 32 | origem.sin_port;
+        uint32_t h = static_cast<uint32_t>((chave * 0x9E3779B97F4A7C15ull) >> 56) & (RECEPCAO_MAX_ORIGENS - 1);
+        for (uint32_t i = 0; i < RECEPCAO_MAX_ORIGENS; i++) {
+            ResumoOrigem& e = entradas[(h + i) & (RECEPCAO_MAX_ORIGENS - 1)];
+            bool nova = false;
+            if (!e.ocupado.load(std::memory_order_relaxed)) {
+                e.chave.store(chave, std::memory_order_relaxed);
+                e.ocupado.store(true, std::memory_order_release);
+                nova = true;
+            } else if (e.chave.load(std::memory_order_relaxed) != chave) {
+                continue;
+            }
+            e.datagramas.store(e.datagramas.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            e.amostras.store(e.amostras.load(std::memory_order_relaxed) + amostras, std::memory_order_relaxed);
+            e.ultimoSensor.store(sensor, std::memory_order_relaxed);
+            e.ultimaChegadaNs.store(agoraNs, std::memory_order_relaxed);
+            return nova;
+        }
+        excedentes.store(excedentes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * @brief Percorre os remetentes presentes (pode ser chamado de outro thread).
+     */
+    template <typename Funcao>
+    void paraCada(Funcao&& f) const {
+        for (const ResumoOrigem& e : entradas) {
+            if (e.ocupado.load(std::memory_order_acquire)) {
+                f(e);
+            }
+        }
+    }
+};
+
+/**
+ * @brief Lê um relógio POSIX em nanossegundos.
+ */
+inline uint64_t relogioNs(clockid_t relogio) {
+    timespec ts;
+    clock_gettime(relogio, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @class BackendRecepcao
+ * @brief Interface comum aos laços de eventos de recepção.
+ */
+class BackendRecepcao {
+protected:
+    /**< Socket UDP já associado (bind) ao endereço de escuta. */
+    int sock;
+
+    /**< Armazém de amostras (pode ser nulo, ex.: na bancada de desempenho). */
+    ArmazemAmostras* armazem;
+
+    /**< Diário de escrita antecipada dos lotes (opcional; um por laço). */
+    DiarioAmostras* diario = nullptr;
+
+    /**< Séries em memória das amostras recentes (opcional; acessadas só pelo thread do laço). */
+    SeriesAmostras* series = nullptr;
+
+    /**< Motor de alertas avaliado sobre as séries a cada lote (opcional, requer as séries). */
+    MotorAlertas* alertas = nullptr;
+
+    /**< Anel de difusão aos assinantes locais (opcional; compartilhado entre os laços). */
+    AnelDifusao* difusao = nullptr;
+
+    /**< Anel em memória compartilhada para leitores locais (opcional; compartilhado entre os laços). */
+    AnelCompartilhado* anelCompartilhado = nullptr;
+
+    /**< Recepção agregada (UDP_GRO) pedida para este laço. */
+    bool gro = false;
+
+    /**< Período do temporizador do laço (ns). */
+    uint64_t periodoNs;
+
+    /**< Mantém o laço em execução; parar() o zera. */
+    std::atomic<bool> ativo{true};
+
+    /**< Chamado a cada disparo do temporizador, no thread do laço. */
+    std::function<void()> aoTemporizador;
+
+    /**< Contadores da recepção. */
+    EstatisticasRecepcao estat;
+
+    /**< Resumo por sensor dos dados recebidos por este laço. */
+    TabelaSensores sensores;
+
+    /**< Resumo por remetente dos datagramas recebidos por este laço. */
+    TabelaOrigens origens;
+
+    /**< Sequências recebidas dos remetentes em modo confiável e confirmações a enviar. */
+    RastreadorConfirmacoes confirmacoes;
+
+    /**< Datagramas FEC recentes, para reconstruir os perdidos a partir dos pacotes de reparo. */
+    RecuperadorFec fec;
+
+    /**< Estimativa do relógio de cada placa que pede sincronização. */
+    SincronizadorRelogios relogios;
+
+    /**< Blocos LoteAmostras em que os datagramas são decodificados (iniciado no thread do laço). */
+    PoolBuffers lotes;
+
+    /**
+     * @brief Prepara o pool de lotes; chamado no início de executar(), já no thread do laço.
+     * @return 0 ou -errno.
+     */
+    int iniciarLotes() {
+        return lotes.iniciar(RECEPCAO_LOTE, sizeof(LoteAmostras));
+    }
+
+    /**
+     * @brief Entrega o buffer cheio do armazém para escrita (síncrona ou assíncrona, conforme o backend).
+     */
+    virtual void descarregarArmazem() = 0;
+
+    /**
+     * @brief Repassa um lote decodificado às etapas seguintes (diário, tabela de sensores, armazém,
+     * anel compartilhado, séries, alertas e difusão).
+     * @details O lote é referenciado pelo índice no pool e devolvido pelo chamador.
+     */
+    void entregarLote(uint32_t indice) {
+        const LoteAmostras& lote = *lotes.como<LoteAmostras>(indice);
+        if (diario != nullptr) {
+            diario->anexar(lote.amostras, lote.n);
+        }
+        uint16_t taxaAnterior = 0;
+        for (uint32_t i = 0; i < lote.n; i++) {
+            uint16_t anterior = sensores.registrar(lote.amostras[i], lote.taxaDhz);
+            if (i == 0) {
+                taxaAnterior = anterior;
+            }
+            if (armazem != nullptr && !armazem->anexar(lote.amostras[i])) {
+                descarregarArmazem();
+            }
+        }
+        // A taxa de um lote é medida pelo remetente: só uma variação acima de 1/8 é uma mudança de regime.
+        if (lote.taxaDhz != 0 && taxaAnterior != 0 && std::abs(lote.taxaDhz - taxaAnterior) > taxaAnterior / 8) {
+            LOG_INFO("Taxa de amostragem alterada", campo("sensor", lote.amostras[0].id_sensor),
+                     campo("taxa_hz", lote.taxaDhz / 10.0), campo("anterior_hz", taxaAnterior / 10.0));
+        }
+        if (anelCompartilhado != nullptr) {
+            anelCompartilhado->publicar(lote.amostras, lote.n);
+        }
+        if (series == nullptr && difusao == nullptr) {
+            return;
+        }
+        // Cada trecho de amostras consecutivas do mesmo sensor é anexado à série e avaliado em
+        // lote, e publicado no anel de difusão como um datagrama binário.
+        for (uint32_t i = 0, j; i < lote.n; i = j) {
+            for (j = i + 1; j < lote.n && lote.amostras[j].id_sensor == lote.amostras[i].id_sensor; j++) {
+            }
+            if (series != nullptr) {
+                uint32_t serie = series->internar(lote.amostras[i].id_sensor);
+                uint64_t inicio = series->total(serie);
+                series->anexar(lote.amostras + i, j - i);
+                if (alertas != nullptr) {
+                    alertas->avaliar(*series, serie, inicio);
+                }
+            }
+            if (difusao != nullptr) {
+                difusao->publicar([&](char* destino, size_t capacidade) {
+                    return codificarDatagrama(destino, capacidade, lote.amostras + i, j - i, 0, lote.taxaDhz);
+                });
+            }
+        }
+    }
+
+    /**
+     * @brief Decodifica um datagrama, diretamente do buffer de recepção, e entrega as amostras.
+     * @details Um pacote de reparo FEC não tem amostras: é usado para reconstruir o datagrama
+     * perdido do seu grupo, que é então decodificado como os demais. Um pedido de sincronização
+     * de relógio é respondido na hora.
+     * @param origem Endereço do remetente (destino das confirmações do modo confiável), ou nulo.
+     */
+    void processarDatagrama(const char* dados, size_t tamanho, uint64_t agoraNs, const sockaddr_in* origem) {
+        EstatisticasRecepcao::somar(estat.datagramas, 1);
+        EstatisticasRecepcao::somar(estat.bytes, tamanho);
+        if (ehLoteGateway(dados, tamanho)) {
+            decodificarLoteEEntregar(dados, tamanho, agoraNs, origem);
+            return;
+        }
+        if (ehSincronizacao(dados, tamanho)) {
+            sincronizarRelogio(dados, tamanho, agoraNs, origem);
+            return;
+        }
+        if (ehReparoFec(dados, tamanho)) {
+            EstatisticasRecepcao::somar(estat.reparos, 1);
+            fec.reparar(dados, tamanho, [&](const char* recuperado, size_t n) {
+                decodificarEEntregar(recuperado, n, agoraNs, origem);
+            });
+            return;
+        }
+        decodificarEEntregar(dados, tamanho, agoraNs, origem);
+    }
+
+    /**
+     * @brief Separa uma leitura agregada pelo UDP_GRO nos seus datagramas e os processa.
+     * @param segmento Tamanho de cada datagrama (o último pode ser menor); 0 se a leitura é um só.
+     */
+    void processarAgregado(const char* dados, size_t tamanho, uint16_t segmento, uint64_t agoraNs,
+                           const sockaddr_in* origem) {
+        if (segmento == 0 || segmento >= tamanho) {
+            processarDatagrama(dados, tamanho, agoraNs, origem);
+            return;
+        }
+        EstatisticasRecepcao::somar(estat.agregados, 1);
+        for (size_t pos = 0; pos < tamanho; pos += segmento) {
+            processarDatagrama(dados + pos, std::min<size_t>(segmento, tamanho - pos), agoraNs, origem);
+        }
+    }
+
+    /**
+     * @brief Registra o datagrama no resumo do remetente (se conhecido) e anuncia os novos no log.
+     * @param sensor Sensor do datagrama (o gateway, em um lote comprimido).
+     */
+    void registrarOrigem(const sockaddr_in* origem, uint32_t amostras, uint32_t sensor, uint64_t agoraNs) {
+        if (origem != nullptr && origens.registrar(*origem, amostras, sensor, agoraNs)) {
+            char ip[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &origem->sin_addr, ip, sizeof(ip));
+            LOG_INFO("Nova origem", campo("ip", ip), campo("porta", ntohs(origem->sin_port)), campo("sensor", sensor));
+        }
+    }
+
+    /**
+     * @brief Responde a um pedido de sincronização e publica a nova estimativa do relógio da placa.
+     * @param agoraNs Instante de chegada do pedido (t2).
+     */
+    void sincronizarRelogio(const char* dados, size_t tamanho, uint64_t agoraNs, const sockaddr_in* origem) {
+        EstatisticasRecepcao::somar(estat.sincronizacoes, 1);
+        uint32_t id = 0;
+        SincronizadorRelogios::Resultado r = relogios.processar(sock, dados, tamanho, agoraNs, origem, id);
+        if (r != SincronizadorRelogios::MEDIDO && r != SincronizadorRelogios::SALTO) {
+            return;
+        }
+        const EstimadorRelogio& relogio = *relogios.estimador(id);
+        sensores.registrarRelogio(id, relogio);
+        if (r == SincronizadorRelogios::SALTO) {
+            LOG_AVISO("Relogio da placa ajustado; estimativa reiniciada", campo("sensor", id),
+                      campo("adiantamento_ms", relogio.adiantamentoNs() / 1e6));
+        } else if (relogio.trocasTotais() == 1) {
+            LOG_INFO("Relogio da placa sincronizado", campo("sensor", id),
+                     campo("adiantamento_ms", relogio.adiantamentoNs() / 1e6),
+                     campo("atraso_us", relogio.atrasoNs() / 1e3));
+        }
+    }
+
+    /**
+     * @brief Decodifica um lote comprimido de um gateway e entrega cada bloco como um datagrama.
+     */
+    void decodificarLoteEEntregar(const char* dados, size_t tamanho, uint64_t agoraNs, const sockaddr_in* origem) {
+        EstatisticasRecepcao::somar(estat.lotesGateway, 1);
+        uint32_t gateway = 0;
+        long n = decodificarLoteGateway(dados, tamanho, [&](const AmostraLDR* amostras, size_t k, uint16_t taxaDhz) {
+            uint32_t indice = lotes.obter();
+            LoteAmostras* lote = lotes.como<LoteAmostras>(indice);
+            lote->n = static_cast<uint32_t>(k);
+            lote->taxaDhz = taxaDhz;
+            std::copy(amostras, amostras + k, lote->amostras);
+            EstatisticasRecepcao::somar(estat.amostras, k);
+            entregarLote(indice);
+            lotes.devolver(indice);
+        }, &gateway);
+        if (n < 0) {
+            EstatisticasRecepcao::somar(estat.invalidos, 1);
+        }
+        registrarOrigem(origem, n > 0 ? static_cast<uint32_t>(n) : 0, gateway, agoraNs);
+    }
+
+    /**
+     * @brief Decodifica um datagrama de amostras em um bloco do pool e o entrega.
+     */
+    void decodificarEEntregar(const char* dados, size_t tamanho, uint64_t agoraNs, const sockaddr_in* origem) {
+        uint32_t indice = lotes.obter();
+        LoteAmostras* lote = lotes.como<LoteAmostras>(indice);
+        MetadadosLDR meta;
+        lote->n = static_cast<uint32_t>(decodificarDatagrama(dados, tamanho, agoraNs, lote->amostras,
+                                                             LDR_MAX_AMOSTRAS_DATAGRAMA, &meta));
+        lote->taxaDhz = meta.taxaDhz;
+        // Instantes do relógio da placa passam ao do coletor, se a placa já fez uma troca de sincronização.
+        const EstimadorRelogio* relogio = nullptr;
+        if (lote->n > 0 && meta.binario && !relogios.vazio() &&
+            (relogio = relogios.estimador(lote->amostras[0].id_sensor)) != nullptr) {
+            for (uint32_t i = 0; i < lote->n; i++) {
+                lote->amostras[i].t_ns = relogio->corrigir(lote->amostras[i].t_ns);
+            }
+        }
+        if (lote->n > 0 && (meta.flags & LDR_FLAG_FEC)) {
+            fec.guardar(dados, tamanho, lote->amostras[0].id_sensor, lote->amostras[0].seq);
+        }
+        registrarOrigem(origem, lote->n, lote->n > 0 ? lote->amostras[0].id_sensor : 0, agoraNs);
+        if (lote->n == 0) {
+            EstatisticasRecepcao::somar(estat.invalidos, 1);
+        } else if ((meta.flags & LDR_FLAG_CONFIAVEL) &&
+                   !confirmacoes.registrar(lote->amostras[0].id_sensor, lote->amostras[0].seq, lote->n, origem)) {
+            EstatisticasRecepcao::somar(estat.duplicados, 1);
+        } else {
+            EstatisticasRecepcao::somar(estat.amostras, lote->n);
+            entregarLote(indice);
+        }
+        lotes.devolver(indice);
+    }
+
+public:
+    /**
+     * @brief Construtor.
+     * @param socketUdp Socket UDP associado ao endereço de escuta.
+     * @param armazemAmostras Destino das amostras (ou nullptr).
+     * @param periodoTemporizadorNs Período do temporizador do laço.
+     */
+    BackendRecepcao(int socketUdp, ArmazemAmostras* armazemAmostras, uint64_t periodoTemporizadorNs)
+        : sock(socketUdp), armazem(armazemAmostras), periodoNs(periodoTemporizadorNs) {}
+
+    virtual ~BackendRecepcao() = default;
+
+    /** @brief Nome do backend (para log). */
+    virtual const char* nome() const = 0;
+
+    /**
+     * @brief Executa o laço de eventos até parar() ser chamado (uma única vez por objeto).
+     * @details Os buffers do laço são alocados aqui, no thread que o executa.
+     * @return 0 em término normal, ou -errno se o backend não pôde ser usado neste kernel.
+     */
+    virtual int executar() = 0;
+
+    /** @brief Solicita o término do laço (efetivo até o próximo disparo do temporizador). */
+    void parar() { ativo.store(false, std::memory_order_relaxed); }
+
+    /** @brief Define a função chamada a cada disparo do temporizador. */
+    void definirTemporizador(std::function<void()> funcao) { aoTemporizador = std::move(funcao); }
+
+    /** @brief Define o diário em que este laço anexa os lotes (antes de executar()). */
+    void definirDiario(DiarioAmostras* diarioAmostras) { diario = diarioAmostras; }
+
+    /** @brief Define as séries em memória alimentadas por este laço (antes de executar()). */
+    void definirSeries(SeriesAmostras* seriesAmostras) { series = seriesAmostras; }
+
+    /** @brief Define o motor de alertas alimentado por este laço (antes de executar()). */
+    void definirAlertas(MotorAlertas* motor) { alertas = motor; }
+
+    /** @brief Define o anel de difusão em que este laço publica os lotes (antes de executar()). */
+    void definirDifusao(AnelDifusao* anel) { difusao = anel; }
+
+    /** @brief Define o anel compartilhado em que este laço publica as amostras (antes de executar()). */
+    void definirAnelCompartilhado(AnelCompartilhado* anel) { anelCompartilhado = anel; }
+
+    /**
+     * @brief Pede a recepção agregada (UDP_GRO) (antes de executar()).
+     * @details Os backends que não a suportam recusam executar() com -EOPNOTSUPP.
+     */
+    void definirGro(bool habilitar) { gro = habilitar; }
+
+    /** @brief Contadores da recepção. */
+    const EstatisticasRecepcao& estatisticas() const { return estat; }
+
+    /** @brief Resumo por sensor dos dados recebidos por este laço. */
+    const TabelaSensores& tabelaSensores() const { return sensores; }
+
+    /** @brief Resumo por remetente dos datagramas recebidos por este laço. */
+    const TabelaOrigens& tabelaOrigens() const { return origens; }
+
+    /** @brief Estado do modo confiável (confirmações enviadas, sequências abandonadas). */
+    const RastreadorConfirmacoes& rastreadorConfirmacoes() const { return confirmacoes; }
+
+    /** @brief Estado do modo FEC (datagramas reconstruídos e irrecuperáveis). */
+    const RecuperadorFec& recuperadorFec() const { return fec; }
+
+    /** @brief Estimativas dos relógios das placas (lidas só no thread do laço; fora dele, ver tabelaSensores()). */
+    const SincronizadorRelogios& sincronizadorRelogios() const { return relogios; }
+};
+
+/**
+ * @class BackendEpoll
+ * @brief Laço com epoll: socket não bloqueante lido em lote com recvmmsg() e temporizador timerfd.
+ *
+ * @details As escritas no armazém são síncronas (write()), feitas no disparo do temporizador
+ * ou quando o buffer ativo enche. Com definirGro(), cada leitura comporta uma agregação
+ * completa (GRO_TAMANHO_BUFFER) e traz o tamanho do segmento em uma mensagem de controle.
+ */
+class BackendEpoll : public BackendRecepcao {
+private:
+    /**< Buffers de recepção (um bloco por mensagem) e descritores de mensagem para recvmmsg(). */
+    PoolBuffers buffers;
+    iovec iovs[RECEPCAO_LOTE];
+    mmsghdr msgs[RECEPCAO_LOTE];
+
+    /**< Endereços de origem (destino das confirmações do modo confiável). */
+    sockaddr_in origens[RECEPCAO_LOTE];
+
+    /**< Mensagens de controle com o segmento do UDP_GRO, e mensagens por recvmmsg() em uso. */
+    alignas(cmsghdr) char controles[RECEPCAO_LOTE][CMSG_SPACE(sizeof(int))];
+    unsigned porChamada = RECEPCAO_LOTE;
+
+    /**
+     * @brief Lê todos os datagramas disponíveis no socket.
+     */
+    void drenarSocket() {
+        while (true) {
+            for (unsigned i = 0; i < porChamada; i++) {
+                msgs[i].msg_hdr.msg_iov = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+                msgs[i].msg_hdr.msg_name = &origens[i];
+                msgs[i].msg_hdr.msg_namelen = sizeof(origens[i]);
+                if (gro) {
+                    msgs[i].msg_hdr.msg_control = controles[i];
+                    msgs[i].msg_hdr.msg_controllen = sizeof(controles[i]);
+                }
+            }
+            int n = recvmmsg(sock, msgs, porChamada, MSG_DONTWAIT, nullptr);
+            if (n <= 0) {
+                return;
+            }
+            uint64_t agora = relogioNs(CLOCK_REALTIME);
+            for (int i = 0; i < n; i++) {
+                const sockaddr_in* origem = msgs[i].msg_hdr.msg_namelen == sizeof(origens[i]) ? &origens[i] : nullptr;
+                if (gro) {
+                    processarAgregado(static_cast<const char*>(iovs[i].iov_base), msgs[i].msg_len,
+                                      segmentoGro(msgs[i].msg_hdr), agora, origem);
+                } else {
+                    processarDatagrama(static_cast<const char*>(iovs[i].iov_base), msgs[i].msg_len, agora, origem);
+                }
+            }
+            if (static_cast<unsigned>(n) < porChamada) {
+                return;
+            }
+        }
+    }
+
+public:
+    BackendEpoll(int socketUdp, ArmazemAmostras* armazemAmostras, uint64_t periodoTemporizadorNs)
+        : BackendRecepcao(socketUdp, armazemAmostras, periodoTemporizadorNs) {
+        for (unsigned i = 0; i < RECEPCAO_LOTE; i++) {
+            msgs[i] = mmsghdr{};
+        }
+    }
+
+    const char* nome() const override { return "epoll"; }
+
+protected:
+    void descarregarArmazem() override { armazem->descarregar(); }
+
+public:
+
+    int executar() override {
+        if (gro && habilitarGro(sock) < 0) {
+            LOG_AVISO("Recepcao agregada (UDP_GRO) indisponivel; lendo um datagrama por vez", campoErrno());
+            gro = false;
+        }
+        porChamada = gro ? RECEPCAO_LOTE_GRO : RECEPCAO_LOTE;
+        size_t tamanhoBuffer = gro ? GRO_TAMANHO_BUFFER : RECEPCAO_TAMANHO_DATAGRAMA;
+        int r = iniciarLotes();
+        if (r < 0 || (r = buffers.iniciar(porChamada, tamanhoBuffer)) < 0) {
+            return r;
+        }
+        for (unsigned i = 0; i < porChamada; i++) {
+            iovs[i].iov_base = buffers.bloco(buffers.obter());
+            iovs[i].iov_len = tamanhoBuffer;
+        }
+        int ep = epoll_create1(EPOLL_CLOEXEC);
+        int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (ep < 0 || tfd < 0) {
+            int erro = errno;
+            if (ep >= 0) close(ep);
+            if (tfd >= 0) close(tfd);
+            return -erro;
+        }
+        itimerspec periodo{};
+        periodo.it_interval.tv_sec = static_cast<time_t>(periodoNs / 1000000000ull);
+        periodo.it_interval.tv_nsec = static_cast<long>(periodoNs % 1000000000ull);
+        periodo.it_value = periodo.it_interval;
+        timerfd_settime(tfd, 0, &periodo, nullptr);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = sock;
+        epoll_ctl(ep, EPOLL_CTL_ADD, sock, &ev);
+        ev.data.fd = tfd;
+        epoll_ctl(ep, EPOLL_CTL_ADD, tfd, &ev);
+
+        epoll_event eventos[2];
+        while (ativo.load(std::memory_order_relaxed)) {
+            int n = epoll_wait(ep, eventos, 2, -1);
+            for (int i = 0; i < n; i++) {
+                if (eventos[i].data.fd == sock) {
+                    drenarSocket();
+                } else {
+                    uint64_t disparos;
+                    if (read(tfd, &disparos, sizeof(disparos)) > 0) {
+                        if (armazem != nullptr) {
+                            armazem->descarregar();
+                        }
+                        confirmacoes.enviar(sock);
+                        if (aoTemporizador) {
+                            aoTemporizador();
+                        }
+                    }
+                }
+            }
+        }
+        close(tfd);
+        close(ep);
+        return 0;
+    }
+};
+
+#endif // RECEPCAO_UDP_HPP
@@ -0,0 +1,273 @@
+/**
+ * @file recepcao_uring.hpp
+ * @brief Backend de recepção do coletor baseado em io_uring.
+ *
+ * @details Um único laço de submissão atende três tipos de operação:
+ * - `recvmsg` multishot no socket UDP (uma submissão gera uma conclusão por datagrama),
+ *   com os buffers escolhidos pelo kernel em um anel de buffers fornecidos;
+ * - escrita (anexação) do buffer cheio do ArmazemAmostras no arquivo de amostras;
+ * - temporizador periódico (IORING_OP_TIMEOUT).
+ *
+ * O socket e o arquivo de amostras são registrados como descritores fixos, evitando a
+ * busca e a contagem de referências do descritor a cada operação.
+ */
+
+#ifndef RECEPCAO_URING_HPP
+#define RECEPCAO_URING_HPP
+
+#include <netinet/in.h>
+#include <sys/mman.h>
+
+#include "anel_io_uring.hpp"
+#include "log_assincrono.hpp"
+#include "recepcao_udp.hpp"
+
+/** @def URING_ENTRADAS
+ * @brief Número de SQEs do anel.
+ */
+#define URING_ENTRADAS 64
+
+/** @def URING_BUFFERS
+ * @brief Número de buffers no anel de buffers fornecidos (potência de 2).
+ */
+#define URING_BUFFERS 256
+
+/**
+ * @class BackendUring
+ * @brief Laço de eventos io_uring: recvmsg multishot, escrita em disco e temporizador.
+ */
+class BackendUring : public BackendRecepcao {
+private:
+    /** @brief Identificadores das operações (user_data das SQEs). */
+    enum Operacao : uint64_t {
+        OP_RECEPCAO = 1,
+        OP_TEMPORIZADOR = 2,
+        OP_ESCRITA = 3
+    };
+
+    /** @brief Índices na tabela de descritores fixos. */
+    enum DescritorFixo : int {
+        FIXO_SOCKET = 0,
+        FIXO_ARMAZEM = 1
+    };
+
+    /**< Grupo do anel de buffers fornecidos. */
+    static constexpr uint16_t GRUPO_BUFFERS = 0;
+
+    /**< O anel io_uring. */
+    AnelIoUring anel;
+
+    /**< Anel de buffers fornecidos (compartilhado com o kernel). */
+    io_uring_buf_ring* anelBuffers = static_cast<io_uring_buf_ring*>(MAP_FAILED);
+
+    /**< Memória dos buffers fornecidos; o id do buffer no anel é o índice do bloco no pool. */
+    PoolBuffers memoriaBuffers;
+
+    /**< Cauda local do anel de buffers (publicada ao fim de cada lote de conclusões). */
+    uint16_t caudaBuffers = 0;
+
+    /**< Modelo de msghdr para o recvmsg multishot (define o espaço reservado ao endereço). */
+    msghdr modeloMsg{};
+
+    /**< Período do temporizador no formato do kernel. */
+    __kernel_timespec periodo{};
+
+    /**< Escrita no armazém em andamento. */
+    bool escritaPendente = false;
+    const char* escritaDados = nullptr;
+    size_t escritaRestante = 0;
+
+    /**< Conta as recepções concluídas (para distinguir falha de suporte de falha transitória). */
+    uint64_t recepcoesConcluidas = 0;
+
+    static constexpr size_t TAMANHO_ANEL_BUFFERS = URING_BUFFERS * sizeof(io_uring_buf);
+
+    /**
+     * @brief Devolve um buffer ao anel de buffers fornecidos (publicado em publicarBuffers()).
+     */
+    void devolverBuffer(uint16_t id) {
+        // Em C++ o __DECLARE_FLEX_ARRAY do cabeçalho desloca o campo bufs (a struct vazia ocupa
+        // 1 byte); as entradas são indexadas a partir do início do anel, como faz o kernel.
+        io_uring_buf* b = reinterpret_cast<io_uring_buf*>(anelBuffers) + (caudaBuffers & (URING_BUFFERS - 1));
+        b->addr = reinterpret_cast<uint64_t>(memoriaBuffers.bloco(id));
+        b->len = RECEPCAO_TAMANHO_DATAGRAMA;
+        b->bid = id;
+        caudaBuffers++;
+    }
+
+    void publicarBuffers() {
+        __atomic_store_n(&anelBuffers->tail, caudaBuffers, __ATOMIC_RELEASE);
+    }
+
+    void armarRecepcao() {
+        io_uring_sqe* sqe = anel.obterSqe();
+        sqe->opcode = IORING_OP_RECVMSG;
+        sqe->fd = FIXO_SOCKET;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->addr = reinterpret_cast<uint64_t>(&modeloMsg);
+        sqe->len = 1;
+        sqe->buf_group = GRUPO_BUFFERS;
+        sqe->user_data = OP_RECEPCAO;
+    }
+
+    void armarTemporizador() {
+        io_uring_sqe* sqe = anel.obterSqe();
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->fd = -1;
+        sqe->addr = reinterpret_cast<uint64_t>(&periodo);
+        sqe->len = 1;
+        sqe->user_data = OP_TEMPORIZADOR;
+    }
+
+    void submeterEscrita() {
+        io_uring_sqe* sqe = anel.obterSqe();
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = FIXO_ARMAZEM;
+        sqe->flags = IOSQE_FIXED_FILE;
+        sqe->addr = reinterpret_cast<uint64_t>(escritaDados);
+        sqe->len = static_cast<uint32_t>(escritaRestante);
+        sqe->off = static_cast<uint64_t>(-1); // posição atual do arquivo (O_APPEND)
+        sqe->user_data = OP_ESCRITA;
+        escritaPendente = true;
+    }
+
+    void descarregarArmazem() override { iniciarEscrita(); }
+
+    /**
+     * @brief Entrega o buffer ativo do armazém para escrita, se não houver outra em andamento.
+     */
+    void iniciarEscrita() {
+        if (armazem != nullptr && !escritaPendente && armazem->trocar(escritaDados, escritaRestante)) {
+            submeterEscrita();
+        }
+    }
+
+    /**
+     * @brief Trata a conclusão de uma recepção multishot.
+     * @return false se o recvmsg falhou por falta de suporte do kernel.
+     */
+    bool tratarRecepcao(const io_uring_cqe& cqe, uint64_t agora) {
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            uint16_t id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res >= 0) {
+                recepcoesConcluidas++;
+                char* base = memoriaBuffers.bloco(id);
+                const io_uring_recvmsg_out* saida = reinterpret_cast<const io_uring_recvmsg_out*>(base);
+                const char* carga = base + sizeof(io_uring_recvmsg_out) + modeloMsg.msg_namelen + modeloMsg.msg_controllen;
+                if (saida->flags & MSG_TRUNC) {
+                    EstatisticasRecepcao::somar(estat.datagramas, 1);
+                    EstatisticasRecepcao::somar(estat.invalidos, 1);
+                } else {
+                    const sockaddr_in* origem = saida->namelen == sizeof(sockaddr_in)
+                        ? reinterpret_cast<const sockaddr_in*>(base + sizeof(io_uring_recvmsg_out)) : nullptr;
+                    processarDatagrama(carga, saida->payloadlen, agora, origem);
+                }
+            }
+            devolverBuffer(id);
+        }
+        if (cqe.res < 0 && cqe.res != -ENOBUFS && recepcoesConcluidas == 0) {
+            return false;
+        }
+        // Sem IORING_CQE_F_MORE o multishot terminou (ex.: anel de buffers vazio): rearmar.
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            armarRecepcao();
+        }
+        return true;
+    }
+
+    void tratarEscrita(const io_uring_cqe& cqe) {
+        escritaPendente = false;
+        if (cqe.res > 0 && static_cast<size_t>(cqe.res) < escritaRestante) {
+            escritaDados += cqe.res;
+            escritaRestante -= static_cast<size_t>(cqe.res);
+            submeterEscrita();
+            return;
+        }
+        if (cqe.res < 0) {
+            LOG_ERRO("Falha ao escrever amostras", campo("erro", -cqe.res));
+        }
+        armazem->liberar();
+    }
+
+public:
+    BackendUring(int socketUdp, ArmazemAmostras* armazemAmostras, uint64_t periodoTemporizadorNs)
+        : BackendRecepcao(socketUdp, armazemAmostras, periodoTemporizadorNs) {
+        modeloMsg.msg_namelen = sizeof(sockaddr_in);
+        periodo.tv_sec = static_cast<long long>(periodoNs / 1000000000ull);
+        periodo.tv_nsec = static_cast<long long>(periodoNs % 1000000000ull);
+    }
+
+    ~BackendUring() override {
+        if (anelBuffers != MAP_FAILED) munmap(anelBuffers, TAMANHO_ANEL_BUFFERS);
+    }
+
+    const char* nome() const override { return "io_uring"; }
+
+    int executar() override {
+        if (gro) {
+            return -EOPNOTSUPP; // os buffers do anel têm o tamanho de um datagrama
+        }
+        int r = anel.iniciar(URING_ENTRADAS);
+        if (r < 0 || (r = iniciarLotes()) < 0 ||
+            (r = memoriaBuffers.iniciar(URING_BUFFERS, RECEPCAO_TAMANHO_DATAGRAMA)) < 0) {
+            return r;
+        }
+        int fixos[2] = {sock, armazem != nullptr ? armazem->descritor() : -1};
+        if ((r = anel.registrarArquivos(fixos, armazem != nullptr ? 2 : 1)) < 0) {
+            return r;
+        }
+        anelBuffers = static_cast<io_uring_buf_ring*>(mmap(nullptr, TAMANHO_ANEL_BUFFERS, PROT_READ | PROT_WRITE,
+                                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (anelBuffers == MAP_FAILED) {
+            return -ENOMEM;
+        }
+        if ((r = anel.registrarAnelBuffers(anelBuffers, URING_BUFFERS, GRUPO_BUFFERS)) < 0) {
+            return r;
+        }
+        for (uint16_t i = 0; i < URING_BUFFERS; i++) {
+            devolverBuffer(static_cast<uint16_t>(memoriaBuffers.obter()));
+        }
+        publicarBuffers();
+
+        armarRecepcao();
+        armarTemporizador();
+        while (ativo.load(std::memory_order_relaxed) || escritaPendente) {
+            r = anel.submeterEEsperar(1);
+            if (r < 0 && r != -EINTR && r != -EAGAIN && r != -EBUSY) {
+                return r;
+            }
+            uint64_t agora = relogioNs(CLOCK_REALTIME);
+            int falha = 0;
+            anel.consumirConclusoes([&](const io_uring_cqe& cqe) {
+                switch (cqe.user_data) {
+                    case OP_RECEPCAO:
+                        if (!tratarRecepcao(cqe, agora)) {
+                            falha = cqe.res;
+                        }
+                        break;
+                    case OP_TEMPORIZADOR:
+                        iniciarEscrita();
+                        confirmacoes.enviar(sock);
+                        if (aoTemporizador) {
+                            aoTemporizador();
+                        }
+                        if (ativo.load(std::memory_order_relaxed)) {
+                            armarTemporizador();
+                        }
+                        break;
+                    case OP_ESCRITA:
+                        tratarEscrita(cqe);
+                        break;
+                }
+            });
+            publicarBuffers();
+            if (falha < 0) {
+                return falha;
+            }
+        }
+        return 0;
+    }
+};
+
+#endif // RECEPCAO_URING_HPP
@@ -13,6 +13,7 @@
 #include <string>
 #include <unistd.h>
 #include <cmath>
+#include "log_assincrono.hpp"
 
 /**
  * @class SensorLDR
@@ -86,7 +87,7 @@ int main() {
 
     while (true) {
         int val = ldr.lerLuminosidadePercentual();
-        std::cout << "Luminosidade: " << val << "%" << std::endl;
+        LOG_INFO("Leitura do sensor", campo("luminosidade", val));
         sleep(1);
     }
 
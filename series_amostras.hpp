@@ -0,0 +1,220 @@
+/**
+ * @file series_amostras.hpp
+ * @brief Representação em memória das amostras recentes, por série (struct-of-arrays).
+ *
+ * @details O servidor Python guarda cada leitura como um dicionário
+ * `{"id": "LDR_KY-018", "valor": ..., "unidade": "%"}`, repetindo o nome e a unidade em todas
+ * as amostras. Aqui cada sensor é uma série, identificada por um índice denso obtido ao internar
+ * o seu id; o nome e a unidade ficam uma única vez nos metadados da série, e os instantes e
+ * valores são guardados em vetores contíguos separados (12 bytes por amostra), o que permite
+ * percorrê-los em laços simples que o compilador vetoriza.
+ *
+ * Cada série retém as últimas `capacidade` amostras em um anel. A memória de uma série é
+ * alocada quando o sensor aparece pela primeira vez; anexar amostras não aloca. A estrutura
+ * pertence a um único thread (o laço de recepção do trabalhador).
+ */
+
+#ifndef SERIES_AMOSTRAS_HPP
+#define SERIES_AMOSTRAS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "protocolo_ldr.hpp"
+
+/** @def SERIES_CAPACIDADE_PADRAO
+ * @brief Número de amostras retidas por série (potência de 2).
+ */
+#define SERIES_CAPACIDADE_PADRAO 1024
+
+/**
+ * @brief Metadados de uma série (guardados uma vez, não por amostra).
+ */
+struct MetadadosSerie {
+    uint32_t id_sensor;  /**< Identificador do sensor no protocolo. */
+    std::string nome;    /**< Nome do sensor (ex.: "LDR_KY-018"). */
+    std::string unidade; /**< Unidade dos valores (ex.: "%"). */
+};
+
+/**
+ * @brief Agregado de uma janela de amostras de uma série.
+ */
+struct AgregadoSerie {
+    uint64_t n = 0;       /**< Número de amostras na janela. */
+    int32_t minimo = 0;   /**< Menor valor. */
+    int32_t maximo = 0;   /**< Maior valor. */
+    double media = 0.0;   /**< Média dos valores. */
+};
+
+/**
+ * @class SeriesAmostras
+ * @brief Séries de amostras em colunas contíguas, indexadas pelo id de sensor internado.
+ */
+class SeriesAmostras {
+private:
+    /** @brief Colunas e metadados de uma série. */
+    struct Serie {
+        MetadadosSerie meta;           /**< Metadados. */
+        std::vector<uint64_t> t_ns;    /**< Instantes (anel de `capacidade` posições). */
+        std::vector<int32_t> valores;  /**< Valores (anel de `capacidade` posições). */
+        uint64_t total = 0;            /**< Amostras já anexadas (a próxima vai para total & mascara). */
+    };
+
+    /**< Séries, na ordem em que foram internadas. */
+    std::vector<Serie> series;
+
+    /**< Índice da série de cada id de sensor e de cada nome. */
+    std::unordered_map<uint32_t, uint32_t> porId;
+    std::unordered_map<std::string, uint32_t> porNome;
+
+    /**< Amostras retidas por série e máscara do anel. */
+    size_t capacidade;
+    size_t mascara;
+
+    /**< Última série consultada (as amostras de um lote costumam ser do mesmo sensor). */
+    uint32_t ultimoId = 0;
+    uint32_t ultimaSerie = UINT32_MAX;
+
+public:
+    /**
+     * @brief Construtor.
+     * @param amostrasPorSerie Amostras retidas por série (arredondado para potência de 2).
+     */
+    explicit SeriesAmostras(size_t amostrasPorSerie = SERIES_CAPACIDADE_PADRAO) {
+        capacidade = 1;
+        while (capacidade < amostrasPorSerie) {
+            capacidade <<= 1;
+        }
+        mascara = capacidade - 1;
+    }
+
+    /**
+     * @brief Obtém o índice da série de um sensor, criando-a na primeira vez.
+     * @details O nome padrão é "LDR_KY-018" para o sensor 0 (formato texto) e "LDR_<id>" para
+     * os demais; a unidade padrão é "%".
+     */
+    uint32_t internar(uint32_t id_sensor) {
+        if (ultimaSerie != UINT32_MAX && ultimoId == id_sensor) {
+            return ultimaSerie;
+        }
+        auto it = porId.find(id_sensor);
+        uint32_t indice;
+        if (it != porId.end()) {
+            indice = it->second;
+        } else {
+            indice = static_cast<uint32_t>(series.size());
+            Serie s;
+            s.meta.id_sensor = id_sensor;
+            s.meta.nome = id_sensor == 0 ? "LDR_KY-018" : "LDR_" + std::to_string(id_sensor);
+            s.meta.unidade = "%";
+            s.t_ns.assign(capacidade, 0);
+            s.valores.assign(capacidade, 0);
+            porNome.emplace(s.meta.nome, indice);
+            series.push_back(std::move(s));
+            porId.emplace(id_sensor, indice);
+        }
+        ultimoId = id_sensor;
+        ultimaSerie = indice;
+        return indice;
+    }
+
+    /**
+     * @brief Procura uma série pelo nome.
+     * @return Índice da série, ou -1 se não existir.
+     */
+    int64_t buscar(const std::string& nome) const {
+        auto it = porNome.find(nome);
+        return it != porNome.end() ? static_cast<int64_t>(it->second) : -1;
+    }
+
+    /**
+     * @brief Altera o nome e a unidade da série de um sensor.
+     */
+    void definirMetadados(uint32_t id_sensor, const std::string& nome, const std::string& unidade) {
+        uint32_t indice = internar(id_sensor);
+        Serie& s = series[indice];
+        porNome.erase(s.meta.nome);
+        s.meta.nome = nome;
+        s.meta.unidade = unidade;
+        porNome[nome] = indice;
+    }
+
+    /**
+     * @brief Anexa amostras (de um ou mais sensores) às suas séries.
+     */
+    void anexar(const AmostraLDR* amostras, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            Serie& s = series[internar(amostras[i].id_sensor)];
+            size_t pos = s.total & mascara;
+            s.t_ns[pos] = amostras[i].t_ns;
+            s.valores[pos] = amostras[i].valor;
+            s.total++;
+        }
+    }
+
+    /** @brief Número de séries. */
+    size_t tamanho() const { return series.size(); }
+
+    /** @brief Amostras retidas por série. */
+    size_t amostrasPorSerie() const { return capacidade; }
+
+    /** @brief Metadados da série @p serie. */
+    const MetadadosSerie& metadados(uint32_t serie) const { return series[serie].meta; }
+
+    /** @brief Total de amostras já anexadas à série (inclusive as que saíram do anel). */
+    uint64_t total(uint32_t serie) const { return series[serie].total; }
+
+    /**
+     * @brief Percorre as amostras de posições [inicio, fim) de uma série em trechos contíguos.
+     *
+     * @details As posições contam desde a criação da série; as que já saíram do anel são
+     * ignoradas. @p f é chamada com `(const uint64_t* t_ns, const int32_t* valores, size_t n)`
+     * no máximo duas vezes (antes e depois da volta do anel).
+     */
+    template <typename Funcao>
+    void trechos(uint32_t serie, uint64_t inicio, uint64_t fim, Funcao&& f) const {
+        const Serie& s = series[serie];
+        fim = std::min(fim, s.total);
+        if (s.total > capacidade) {
+            inicio = std::max(inicio, s.total - capacidade);
+        }
+        while (inicio < fim) {
+            size_t pos = inicio & mascara;
+            size_t n = static_cast<size_t>(std::min<uint64_t>(fim - inicio, capacidade - pos));
+            f(s.t_ns.data() + pos, s.valores.data() + pos, n);
+            inicio += n;
+        }
+    }
+
+    /**
+     * @brief Agrega as últimas @p ultimas amostras de uma série.
+     */
+    AgregadoSerie agregar(uint32_t serie, size_t ultimas) const {
+        AgregadoSerie r;
+        uint64_t total = series[serie].total;
+        uint64_t inicio = total > ultimas ? total - ultimas : 0;
+        int32_t minimo = std::numeric_limits<int32_t>::max();
+        int32_t maximo = std::numeric_limits<int32_t>::min();
+        int64_t soma = 0;
+        trechos(serie, inicio, total, [&](const uint64_t*, const int32_t* v, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                minimo = std::min(minimo, v[i]);
+                maximo = std::max(maximo, v[i]);
+                soma += v[i];
+            }
+            r.n += n;
+        });
+        if (r.n > 0) {
+            r.minimo = minimo;
+            r.maximo = maximo;
+            r.media = static_cast<double>(soma) / static_cast<double>(r.n);
+        }
+        return r;
+    }
+};
+
+#endif // SERIES_AMOSTRAS_HPP
@@ -19,6 +19,7 @@ import socket
 import threading
 import json
 import queue
+import struct
 from datetime import datetime
 from collections import deque
 
@@ -47,6 +48,44 @@ dados_fila = queue.Queue()
 # Deque para armazenar o histórico de valores para plotagem, com tamanho máximo.
 dados_grafico = deque(maxlen=HISTORICO_MAX_PONTOS)
 
+## @def LDR_MAGIA
+# Magia do cabeçalho dos datagramas binários (ver protocolo_ldr.hpp).
+LDR_MAGIA = 0x4C44
+
+## @def LDR_MAGIA_FEC
+# Magia dos pacotes de reparo FEC, que não trazem amostras (ver fec_udp.hpp).
+LDR_MAGIA_FEC = 0x4C46
+
+## @def LDR_TAMANHO_CABECALHO
+# Bytes do cabeçalho dos datagramas binários.
+LDR_TAMANHO_CABECALHO = 24
+
+## @def LDR_MAX_AMOSTRAS_DATAGRAMA
+# Número máximo de amostras em um datagrama binário (a drenagem do spool envia datagramas cheios).
+LDR_MAX_AMOSTRAS_DATAGRAMA = 128
+
+## @def TAMANHO_BUFFER_RECEPCAO
+# Buffer de recvfrom(): comporta o maior datagrama binário, que não pode ser truncado.
+TAMANHO_BUFFER_RECEPCAO = max(2048, LDR_TAMANHO_CABECALHO + 8 * LDR_MAX_AMOSTRAS_DATAGRAMA)
+
+def decodificar_datagrama(data):
+    """
+    @brief Extrai os valores de um datagrama, no formato texto ("75") ou binário.
+
+    O formato binário (enviado pelo cliente com spool) tem um cabeçalho de 24 bytes seguido de
+    registros de 8 bytes (deslocamento em µs e valor), na ordem de bytes da rede.
+
+    @return Lista de valores percentuais (vários quando o cliente recupera amostras atrasadas).
+    """
+    if len(data) >= 16 and struct.unpack_from("!H", data, 0)[0] == LDR_MAGIA_FEC:
+        return []  # pacote de reparo FEC: sem amostras (a reconstrução é feita pelo coletor C++)
+    if len(data) >= LDR_TAMANHO_CABECALHO and struct.unpack_from("!H", data, 0)[0] == LDR_MAGIA:
+        n = struct.unpack_from("!H", data, 12)[0]
+        if len(data) != LDR_TAMANHO_CABECALHO + 8 * n:
+            raise ValueError("datagrama binario com tamanho invalido")
+        return [struct.unpack_from("!Ii", data, LDR_TAMANHO_CABECALHO + 8 * i)[1] for i in range(n)]
+    return [int(data.decode('utf-8').strip())]
+
 def iniciar_servidor_udp():
     """
     @brief Inicia um servidor UDP em um thread separado para receber dados.
@@ -57,7 +96,8 @@ def iniciar_servidor_udp():
     é então colocado na fila de dados para ser processado pela thread principal (GUI).
     O ID do sensor é fixo como "LDR_KY-018" e a unidade como "%".
     
-    @note Assume-se que os pacotes UDP contêm apenas a representação string de um inteiro.
+    @note Os pacotes UDP contêm a representação string de um inteiro ou, vindos do cliente com
+    spool, um datagrama binário com uma ou mais amostras (ver decodificar_datagrama()).
     @return Não retorna. Executa em loop infinito.
     """
     sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
@@ -67,25 +107,22 @@ def iniciar_servidor_udp():
     while True:
         try:
             # 1. Recebe o datagrama (bytes)
-            data, addr = sock.recvfrom(1024) 
-            
-            # 2. Converte bytes para string e remove espaços em branco (ex: "75")
-            mensagem_string = data.decode('utf-8').strip()
-            
-            # 3. Converte a string (ex: "75") para um número inteiro
-            valor_percentual = int(mensagem_string)
+            data, addr = sock.recvfrom(TAMANHO_BUFFER_RECEPCAO) 
             
-            # 4. TRANSFORMAÇÃO PARA JSON (Dicionário Python)
-            dados_json_enriquecidos = {
-                "id": "LDR_KY-018",# Adiciona o ID do grupo
-                "valor": valor_percentual,
-                "unidade": "%"# Adiciona a unidade
-            }
-            
-            # 5. Coloca o objeto JSON (dicionário) na fila
-            dados_fila.put(dados_json_enriquecidos)
+            # 2. Converte o datagrama (texto "75" ou binário) para números inteiros
+            for valor_percentual in decodificar_datagrama(data):
+
+                # 3. TRANSFORMAÇÃO PARA JSON (Dicionário Python)
+                dados_json_enriquecidos = {
+                    "id": "LDR_KY-018",# Adiciona o ID do grupo
+                    "valor": valor_percentual,
+                    "unidade": "%"# Adiciona a unidade
+                }
+
+                # 4. Coloca o objeto JSON (dicionário) na fila
+                dados_fila.put(dados_json_enriquecidos)
             
-        except (ValueError, UnicodeDecodeError):
+        except (ValueError, UnicodeDecodeError, struct.error):
             # Erro se a mensagem não for um número (ex: "ola")
             print(f"Erro: Pacote recebido não é um número válido: {data}")
         except Exception as e:
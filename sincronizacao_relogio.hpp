@@ -0,0 +1,372 @@
+/**
+ * @file sincronizacao_relogio.hpp
+ * @brief Estimativa do desvio e da deriva do relógio de cada placa em relação ao coletor.
+ *
+ * @details As amostras binárias levam o instante do relógio da placa, que não é sincronizado:
+ * duas placas lado a lado podem divergir em segundos, e cada uma deriva algumas dezenas de ppm.
+ * Aqui a placa (SondaRelogio) envia de tempos em tempos um pedido com o instante de envio t1; o
+ * coletor (SincronizadorRelogios) responde na hora com os instantes de chegada t2 e de envio t3,
+ * e a placa anota a chegada da resposta, t4, no pedido seguinte. Como no NTP, cada troca dá
+ *
+ *     desvio θ = ((t2 - t1) + (t3 - t4)) / 2    (coletor menos placa)
+ *     atraso δ = (t4 - t1) - (t3 - t2)
+ *
+ * e o erro de θ é no máximo δ / 2. O EstimadorRelogio de cada placa guarda as últimas trocas e
+ * usa a de menor atraso (filtro de relógio do NTP); os desvios filtrados alimentam uma regressão
+ * linear contra o relógio da placa, cuja inclinação é a deriva. Na ingestão, cada amostra binária
+ * de uma placa sincronizada tem o instante levado ao relógio do coletor:
+ * `t + θ + deriva * (t - t_referência)`.
+ *
+ * A qualidade de cada placa (desvio, deriva, atraso e dispersão dos desvios em torno da reta) é
+ * publicada no resumo do sensor. Um desvio medido muito longe do previsto (o relógio da placa foi
+ * ajustado) reinicia a estimativa.
+ */
+
+#ifndef SINCRONIZACAO_RELOGIO_HPP
+#define SINCRONIZACAO_RELOGIO_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "protocolo_ldr.hpp"
+
+/** @def SINC_FILTRO
+ * @brief Trocas recentes entre as quais se escolhe a de menor atraso.
+ */
+#define SINC_FILTRO 8
+
+/** @def SINC_PONTOS
+ * @brief Desvios filtrados usados na regressão da deriva.
+ */
+#define SINC_PONTOS 16
+
+/** @def SINC_SALTO_NS
+ * @brief Diferença entre o desvio medido e o previsto que indica um ajuste do relógio da placa.
+ */
+#define SINC_SALTO_NS (100 * 1000000ll)
+
+/** @def SINC_DERIVA_MAXIMA
+ * @brief Maior deriva aceita (500 ppm); acima disso, a regressão é ruído de poucas trocas.
+ */
+#define SINC_DERIVA_MAXIMA 500e-6
+
+/** @def SINC_PERIODO_INICIAL_S
+ * @brief Intervalo entre os primeiros pedidos da placa, até SINC_FILTRO respostas.
+ */
+#define SINC_PERIODO_INICIAL_S 1
+
+/**
+ * @brief true se o datagrama é de sincronização de relógio (pedido ou resposta).
+ */
+inline bool ehSincronizacao(const char* dados, size_t tamanho) {
+    uint16_t magia;
+    if (tamanho != sizeof(CabecalhoSincLDR)) {
+        return false;
+    }
+    memcpy(&magia, dados, sizeof(magia));
+    return ntohs(magia) == LDR_MAGIA_SINC;
+}
+
+/**
+ * @brief Uma troca de sincronização, já reduzida a desvio e atraso.
+ */
+struct MedidaRelogio {
+    uint64_t tPlacaNs;  /**< Instante t1 (relógio da placa). */
+    int64_t desvioNs;   /**< θ: relógio do coletor menos o da placa. */
+    int64_t atrasoNs;   /**< δ: ida e volta descontado o tempo no coletor. */
+};
+
+/**
+ * @class EstimadorRelogio
+ * @brief Desvio e deriva do relógio de uma placa, a partir das trocas de sincronização.
+ */
+class EstimadorRelogio {
+private:
+    /**< Últimas trocas (anel) e desvios filtrados da regressão (anel). */
+    MedidaRelogio recentes[SINC_FILTRO];
+    MedidaRelogio pontos[SINC_PONTOS];
+    uint32_t nRecentes = 0;
+    uint32_t nPontos = 0;
+    uint32_t trocas = 0;
+
+    /**< Reta estimada: desvio `desvioRef` em `tRef` (relógio da placa), inclinação `deriva`. */
+    uint64_t tRef = 0;
+    int64_t desvioRef = 0;
+    double deriva = 0.0;
+
+    /**< Atraso da troca escolhida e dispersão dos pontos em torno da reta (ns). */
+    int64_t atraso = 0;
+    int64_t dispersao = 0;
+
+    /** @brief Ajusta a reta aos pontos (mínimos quadrados, com x relativo ao ponto mais recente). */
+    void ajustar(const MedidaRelogio& ultimo) {
+        tRef = ultimo.tPlacaNs;
+        uint32_t n = std::min<uint32_t>(nPontos, SINC_PONTOS);
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            double x = static_cast<double>(static_cast<int64_t>(pontos[i].tPlacaNs - tRef));
+            double y = static_cast<double>(pontos[i].desvioNs);
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+        }
+        double mx = sx / n, my = sy / n;
+        double vx = sxx / n - mx * mx;
+        // A inclinação só é confiável com os pontos espalhados por pelo menos 1 s.
+        if (n >= 2 && vx > 0.25e18) {
+            deriva = std::max(-SINC_DERIVA_MAXIMA, std::min(SINC_DERIVA_MAXIMA, (sxy / n - mx * my) / vx));
+        }
+        desvioRef = static_cast<int64_t>(std::llround(my - deriva * mx));
+        double residuos = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            double x = static_cast<double>(static_cast<int64_t>(pontos[i].tPlacaNs - tRef));
+            double r = static_cast<double>(pontos[i].desvioNs) - (desvioRef + deriva * x);
+            residuos += r * r;
+        }
+        dispersao = static_cast<int64_t>(std::sqrt(residuos / n));
+    }
+
+public:
+    /**
+     * @brief Acrescenta uma troca completa.
+     * @return false se o desvio medido se afastou do previsto em mais de SINC_SALTO_NS além da
+     * incerteza da troca: a estimativa foi reiniciada a partir desta troca.
+     */
+    bool adicionar(uint64_t t1, uint64_t t2, uint64_t t3, uint64_t t4) {
+        MedidaRelogio m;
+        m.tPlacaNs = t1;
+        m.desvioNs = (static_cast<int64_t>(t2 - t1) + static_cast<int64_t>(t3 - t4)) / 2;
+        m.atrasoNs = std::max<int64_t>(0, static_cast<int64_t>(t4 - t1) - static_cast<int64_t>(t3 - t2));
+        bool continua = true;
+        if (valido() && std::llabs(m.desvioNs - desvioPrevisto(t1)) > SINC_SALTO_NS + m.atrasoNs / 2) {
+            *this = EstimadorRelogio();
+            continua = false;
+        }
+        recentes[nRecentes++ % SINC_FILTRO] = m;
+        trocas++;
+        // Filtro de relógio: das trocas recentes, vale a de menor atraso (a menos enviesada).
+        const MedidaRelogio* melhor = &recentes[0];
+        for (uint32_t i = 1; i < std::min<uint32_t>(nRecentes, SINC_FILTRO); i++) {
+            if (recentes[i].atrasoNs < melhor->atrasoNs) {
+                melhor = &recentes[i];
+            }
+        }
+        bool repetido = false;
+        for (uint32_t i = 0; i < std::min<uint32_t>(nPontos, SINC_PONTOS); i++) {
+            repetido |= pontos[i].tPlacaNs == melhor->tPlacaNs;
+        }
+        if (!repetido) {
+            pontos[nPontos++ % SINC_PONTOS] = *melhor;
+        }
+        atraso = melhor->atrasoNs;
+        ajustar(pontos[(nPontos - 1) % SINC_PONTOS]);
+        return continua;
+    }
+
+    /** @brief true após a primeira troca. */
+    bool valido() const { return trocas > 0; }
+
+    /** @brief Desvio (coletor menos placa) previsto para o instante @p tPlacaNs da placa. */
+    int64_t desvioPrevisto(uint64_t tPlacaNs) const {
+        return desvioRef + static_cast<int64_t>(std::llround(deriva * static_cast<double>(
+                                                    static_cast<int64_t>(tPlacaNs - tRef))));
+    }
+
+    /** @brief Instante @p tPlacaNs da placa levado ao relógio do coletor. */
+    uint64_t corrigir(uint64_t tPlacaNs) const {
+        return tPlacaNs + static_cast<uint64_t>(desvioPrevisto(tPlacaNs));
+    }
+
+    /** @brief Quanto a placa está adiantada em relação ao coletor, na última referência (ns). */
+    int64_t adiantamentoNs() const { return -desvioRef; }
+
+    /** @brief Quanto a placa ganha do coletor por segundo (ppm; negativo: atrasa). */
+    double derivaPpm() const { return -deriva * 1e6; }
+
+    /** @brief Atraso de ida e volta da troca em uso (ns). */
+    int64_t atrasoNs() const { return atraso; }
+
+    /** @brief Incerteza estimada da correção: metade do atraso mais a dispersão em torno da reta (ns). */
+    int64_t incertezaNs() const { return atraso / 2 + dispersao; }
+
+    /** @brief Trocas desde o início (ou o último reinício). */
+    uint32_t trocasTotais() const { return trocas; }
+};
+
+/**
+ * @class SincronizadorRelogios
+ * @brief Lado do coletor: responde aos pedidos e mantém um EstimadorRelogio por placa.
+ *
+ * @details Acessado apenas pelo thread do laço de recepção; a tabela só aloca ao conhecer uma
+ * placa nova. A resposta sai na hora, pelo próprio socket de recepção, sem bloquear.
+ */
+class SincronizadorRelogios {
+private:
+    /** @brief Estado de uma placa. */
+    struct Placa {
+        uint32_t seq = 0;               /**< Último pedido respondido. */
+        uint64_t t1 = 0, t2 = 0, t3 = 0; /**< Instantes desse pedido. */
+        bool respondido = false;        /**< Há um pedido respondido à espera do seu t4. */
+        EstimadorRelogio estimador;
+    };
+
+    /**< Placas por id_sensor. */
+    std::unordered_map<uint32_t, Placa> placas;
+
+    /**< Respostas enviadas e estimativas reiniciadas por salto do relógio. */
+    uint64_t respostas = 0;
+    uint64_t saltos = 0;
+
+public:
+    /** @brief Resultado de processar(). */
+    enum Resultado { IGNORADO, RESPONDIDO, MEDIDO, SALTO };
+
+    /**
+     * @brief Trata um pedido: responde a @p origem e, se ele traz o t4 do pedido anterior,
+     * alimenta o estimador da placa.
+     * @param t2 Instante de chegada do pedido (CLOCK_REALTIME do coletor).
+     * @param id Recebe o id da placa.
+     * @return MEDIDO (ou SALTO, se a estimativa foi reiniciada) quando o estimador mudou.
+     */
+    Resultado processar(int sock, const char* dados, size_t tamanho, uint64_t t2, const sockaddr_in* origem,
+                        uint32_t& id) {
+        CabecalhoSincLDR cab;
+        if (!ehSincronizacao(dados, tamanho)) {
+            return IGNORADO;
+        }
+        memcpy(&cab, dados, sizeof(cab));
+        if (cab.versao != LDR_VERSAO || cab.tipo != LDR_SINC_PEDIDO) {
+            return IGNORADO;
+        }
+        id = ntohl(cab.id_sensor);
+        Placa& p = placas[id];
+        Resultado r = IGNORADO;
+        uint64_t t4 = be64toh(cab.t4_anterior_ns);
+        if (p.respondido && t4 != 0 && ntohl(cab.seq_anterior) == p.seq) {
+            r = p.estimador.adicionar(p.t1, p.t2, p.t3, t4) ? MEDIDO : SALTO;
+            saltos += r == SALTO;
+            p.respondido = false;
+        }
+        if (origem == nullptr) {
+            return r;
+        }
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        uint64_t t3 = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+        cab.tipo = LDR_SINC_RESPOSTA;
+        cab.t2_ns = htobe64(t2);
+        cab.t3_ns = htobe64(t3);
+        if (sendto(sock, &cab, sizeof(cab), MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(origem),
+                   sizeof(*origem)) == static_cast<ssize_t>(sizeof(cab))) {
+            p.seq = ntohl(cab.seq);
+            p.t1 = be64toh(cab.t1_ns);
+            p.t2 = t2;
+            p.t3 = t3;
+            p.respondido = true;
+            respostas++;
+            if (r == IGNORADO) {
+                r = RESPONDIDO;
+            }
+        }
+        return r;
+    }
+
+    /** @brief Estimador da placa @p id, ou nulo se ela ainda não completou uma troca. */
+    const EstimadorRelogio* estimador(uint32_t id) const {
+        auto it = placas.find(id);
+        return it != placas.end() && it->second.estimador.valido() ? &it->second.estimador : nullptr;
+    }
+
+    /** @brief true se nenhuma placa pediu sincronização (a ingestão dispensa a consulta). */
+    bool vazio() const { return placas.empty(); }
+
+    /** @brief Respostas enviadas. */
+    uint64_t respostasEnviadas() const { return respostas; }
+
+    /** @brief Estimativas reiniciadas por ajuste do relógio de uma placa. */
+    uint64_t saltosDetectados() const { return saltos; }
+};
+
+/**
+ * @class SondaRelogio
+ * @brief Lado da placa: monta os pedidos e anota a chegada das respostas.
+ *
+ * @details A placa não corrige o próprio relógio: só informa ao coletor o t4 de cada troca. O
+ * desvio e o atraso da última troca ficam disponíveis para o log.
+ */
+class SondaRelogio {
+private:
+    uint32_t idSensor;
+    uint32_t seq = 0;
+
+    /**< Resposta mais recente (seq e t4), a informar no próximo pedido. */
+    uint32_t seqResposta = 0;
+    uint64_t t4Resposta = 0;
+
+    /**< Última troca completa vista pela placa. */
+    int64_t desvio = 0;
+    int64_t atraso = 0;
+    uint64_t respostas = 0;
+
+public:
+    explicit SondaRelogio(uint32_t id) : idSensor(id) {}
+
+    /**
+     * @brief Monta o próximo pedido, com t1 = @p agoraNs (CLOCK_REALTIME da placa, lido logo antes do envio).
+     * @return Tamanho do datagrama (sizeof(CabecalhoSincLDR)).
+     */
+    size_t codificarPedido(char* destino, uint64_t agoraNs) {
+        CabecalhoSincLDR cab{};
+        cab.magia = htons(LDR_MAGIA_SINC);
+        cab.versao = LDR_VERSAO;
+        cab.tipo = LDR_SINC_PEDIDO;
+        cab.id_sensor = htonl(idSensor);
+        cab.seq = htonl(++seq);
+        cab.seq_anterior = htonl(seqResposta);
+        cab.t1_ns = htobe64(agoraNs);
+        cab.t4_anterior_ns = htobe64(t4Resposta);
+        memcpy(destino, &cab, sizeof(cab));
+        t4Resposta = 0;
+        return sizeof(cab);
+    }
+
+    /**
+     * @brief Trata uma resposta chegada em @p t4 (CLOCK_REALTIME da placa).
+     * @return false se o datagrama não é a resposta ao último pedido.
+     */
+    bool processarResposta(const char* dados, size_t tamanho, uint64_t t4) {
+        CabecalhoSincLDR cab;
+        if (!ehSincronizacao(dados, tamanho)) {
+            return false;
+        }
+        memcpy(&cab, dados, sizeof(cab));
+        if (cab.tipo != LDR_SINC_RESPOSTA || ntohl(cab.id_sensor) != idSensor || ntohl(cab.seq) != seq) {
+            return false;
+        }
+        uint64_t t1 = be64toh(cab.t1_ns), t2 = be64toh(cab.t2_ns), t3 = be64toh(cab.t3_ns);
+        desvio = (static_cast<int64_t>(t2 - t1) + static_cast<int64_t>(t3 - t4)) / 2;
+        atraso = std::max<int64_t>(0, static_cast<int64_t>(t4 - t1) - static_cast<int64_t>(t3 - t2));
+        seqResposta = seq;
+        t4Resposta = t4;
+        respostas++;
+        return true;
+    }
+
+    /** @brief Desvio (coletor menos placa) da última troca (ns). */
+    int64_t desvioNs() const { return desvio; }
+
+    /** @brief Atraso de ida e volta da última troca (ns). */
+    int64_t atrasoNs() const { return atraso; }
+
+    /** @brief Respostas recebidas. */
+    uint64_t respostasRecebidas() const { return respostas; }
+};
+
+#endif // SINCRONIZACAO_RELOGIO_HPP
@@ -0,0 +1,485 @@
+/**
+ * @file spool_amostras.hpp
+ * @brief Spool local de amostras do cliente (store-and-forward) em um arquivo mapeado em memória.
+ *
+ * @details Toda amostra lida pelo cliente é primeiro anexada ao spool e só sai dele depois de
+ * enviada. Enquanto o coletor está inalcançável (sendto() falha), as amostras se acumulam; quando
+ * a conectividade volta, o atraso é drenado a uma taxa limitada, em datagramas binários que
+ * preservam o instante e a sequência originais de cada amostra.
+ *
+ * O spool é um anel de tamanho fixo em um arquivo mapeado com MAP_SHARED: se o processo cair, as
+ * amostras pendentes continuam no arquivo e são reenviadas na próxima execução. Com o anel cheio,
+ * a amostra mais antiga é descartada (e contada). Cada registro guarda a sua posição absoluta no
+ * anel e um CRC32C; na abertura, a região pendente é percorrida e termina no primeiro registro
+ * inválido (por exemplo, escrito pela metade antes de uma queda de energia). A entrega é "pelo
+ * menos uma vez": uma queda entre o envio e a confirmação reenvia o último datagrama.
+ *
+ * O mapeamento compartilhado já sobrevive à queda do processo; a sincronização em disco (msync)
+ * só protege contra a falta de energia. Ela é feita a cada N amostras ou, se antes, na primeira
+ * anexação depois de T ms da última, para não gravar a flash da placa a cada amostra.
+ *
+ * Layout (ordem de bytes do host): CabecalhoSpool (64 bytes) seguido de `capacidade` registros
+ * RegistroSpool (32 bytes cada).
+ */
+
+#ifndef SPOOL_AMOSTRAS_HPP
+#define SPOOL_AMOSTRAS_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "confiabilidade_udp.hpp"
+#include "copia_zero.hpp"
+#include "crc32c.hpp"
+#include "fec_udp.hpp"
+#include "gso_udp.hpp"
+#include "protocolo_ldr.hpp"
+
+/** @def SPOOL_MAGIA
+ * @brief Identificação do arquivo de spool ("LDRS").
+ */
+#define SPOOL_MAGIA 0x5352444Cu
+
+/** @def SPOOL_VERSAO
+ * @brief Versão do layout.
+ */
+#define SPOOL_VERSAO 1
+
+/** @def SPOOL_CAPACIDADE_PADRAO
+ * @brief Amostras retidas por padrão (potência de 2; 1 dia a 1 Hz cabe em 131072).
+ */
+#define SPOOL_CAPACIDADE_PADRAO 131072
+
+/** @def SPOOL_SINCRONIZAR_A_CADA
+ * @brief Amostras anexadas entre duas sincronizações (msync) por padrão.
+ */
+#define SPOOL_SINCRONIZAR_A_CADA 64
+
+/** @def SPOOL_SINCRONIZAR_MS
+ * @brief Tempo máximo, em ms, entre a anexação de uma amostra e a sincronização por padrão.
+ */
+#define SPOOL_SINCRONIZAR_MS 5000
+
+/**
+ * @brief Cabeçalho do spool.
+ */
+struct alignas(64) CabecalhoSpool {
+    uint32_t magia;           /**< SPOOL_MAGIA. */
+    uint32_t versao;          /**< SPOOL_VERSAO. */
+    uint32_t capacidade;      /**< Número de registros (potência de 2). */
+    uint32_t tamanhoRegistro; /**< sizeof(RegistroSpool). */
+    uint64_t cabeca;          /**< Posição do próximo registro a anexar. */
+    uint64_t cauda;           /**< Posição do registro mais antigo ainda não enviado. */
+    uint64_t descartadas;     /**< Amostras sobrescritas com o anel cheio. */
+};
+
+/**
+ * @brief Uma amostra no spool.
+ */
+struct RegistroSpool {
+    uint64_t posicao;   /**< Posição absoluta do registro (detecta registros antigos). */
+    uint64_t t_ns;      /**< Instante original da amostra. */
+    uint32_t id_sensor; /**< Sensor. */
+    uint32_t seq;       /**< Sequência original. */
+    int32_t valor;      /**< Valor. */
+    uint32_t crc;       /**< CRC32C dos campos anteriores. */
+};
+static_assert(sizeof(CabecalhoSpool) == 64, "cabecalho do spool deve ter 64 bytes");
+static_assert(sizeof(RegistroSpool) == 32, "registro do spool deve ter 32 bytes");
+
+/**
+ * @class SpoolAmostras
+ * @brief Anel persistente de amostras pendentes de envio (um único thread o usa).
+ */
+class SpoolAmostras {
+private:
+    /**< Mapeamento do arquivo. */
+    CabecalhoSpool* cabecalho = nullptr;
+    RegistroSpool* registros = nullptr;
+    size_t tamanho = 0;
+    uint64_t mascara = 0;
+
+    /**< Registros anexados desde a última sincronização e o intervalo entre sincronizações. */
+    uint32_t naoSincronizados = 0;
+    uint32_t intervaloSincronizacao = SPOOL_SINCRONIZAR_A_CADA;
+
+    /**< Tempo máximo entre sincronizações (0 = só pelo número de amostras) e a última (CLOCK_MONOTONIC). */
+    uint64_t periodoSincronizacaoNs = 0;
+    uint64_t ultimaSincronizacaoNs = 0;
+
+    static uint64_t agoraNs() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    static uint32_t crcRegistro(const RegistroSpool& r) {
+        return crc32c(&r, offsetof(RegistroSpool, crc));
+    }
+
+    bool registroValido(uint64_t pos) const {
+        const RegistroSpool& r = registros[pos & mascara];
+        return r.posicao == pos && r.crc == crcRegistro(r);
+    }
+
+public:
+    SpoolAmostras() = default;
+    SpoolAmostras(const SpoolAmostras&) = delete;
+    SpoolAmostras& operator=(const SpoolAmostras&) = delete;
+
+    ~SpoolAmostras() {
+        if (cabecalho != nullptr) {
+            msync(cabecalho, tamanho, MS_SYNC);
+            munmap(cabecalho, tamanho);
+        }
+    }
+
+    /**
+     * @brief Abre o spool em @p caminho, criando-o se não existir ou se tiver outro layout.
+     *
+     * @details Um spool existente mantém a sua capacidade. As amostras pendentes são validadas
+     * da cauda para a cabeça; a cabeça recua para o primeiro registro inválido.
+     *
+     * @param capacidade Número de registros de um spool novo (potência de 2).
+     * @param sincronizarACada Sincroniza o arquivo em disco (msync) a cada N amostras anexadas.
+     * @param sincronizarMs Sincroniza também na primeira anexação depois de T ms da última
+     * sincronização (0 = só pelo número de amostras).
+     * @return 0 ou -errno.
+     */
+    int abrir(const std::string& caminho, uint32_t capacidade = SPOOL_CAPACIDADE_PADRAO,
+              uint32_t sincronizarACada = SPOOL_SINCRONIZAR_A_CADA, uint32_t sincronizarMs = SPOOL_SINCRONIZAR_MS) {
+        if (capacidade == 0 || (capacidade & (capacidade - 1)) != 0) {
+            return -EINVAL;
+        }
+        int fd = open(caminho.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return -errno;
+        }
+        CabecalhoSpool existente{};
+        bool valido = pread(fd, &existente, sizeof(existente), 0) == static_cast<ssize_t>(sizeof(existente)) &&
+                      existente.magia == SPOOL_MAGIA && existente.versao == SPOOL_VERSAO &&
+                      existente.tamanhoRegistro == sizeof(RegistroSpool) && existente.capacidade != 0 &&
+                      (existente.capacidade & (existente.capacidade - 1)) == 0;
+        struct stat st;
+        if (valido && (fstat(fd, &st) < 0 ||
+                       static_cast<size_t>(st.st_size) < sizeof(CabecalhoSpool) +
+                                                             static_cast<size_t>(existente.capacidade) * sizeof(RegistroSpool))) {
+            valido = false;
+        }
+        if (valido) {
+            capacidade = existente.capacidade;
+        }
+        size_t bytes = sizeof(CabecalhoSpool) + static_cast<size_t>(capacidade) * sizeof(RegistroSpool);
+        void* p = MAP_FAILED;
+        if (valido || (ftruncate(fd, 0) == 0 && ftruncate(fd, static_cast<off_t>(bytes)) == 0)) {
+            p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int erro = errno;
+        close(fd);
+        if (p == MAP_FAILED) {
+            return -erro;
+        }
+        cabecalho = static_cast<CabecalhoSpool*>(p);
+        registros = reinterpret_cast<RegistroSpool*>(cabecalho + 1);
+        tamanho = bytes;
+        mascara = capacidade - 1;
+        intervaloSincronizacao = sincronizarACada > 0 ? sincronizarACada : 1;
+        periodoSincronizacaoNs = static_cast<uint64_t>(sincronizarMs) * 1000000ull;
+        ultimaSincronizacaoNs = agoraNs();
+        if (!valido) {
+            // Arquivo novo (zerado pelo ftruncate): a magia é escrita por último.
+            cabecalho->versao = SPOOL_VERSAO;
+            cabecalho->capacidade = capacidade;
+            cabecalho->tamanhoRegistro = sizeof(RegistroSpool);
+            cabecalho->magia = SPOOL_MAGIA;
+            msync(cabecalho, tamanho, MS_SYNC);
+            return 0;
+        }
+        uint64_t cauda = cabecalho->cauda;
+        uint64_t cabeca = cabecalho->cabeca;
+        if (cabeca < cauda || cabeca - cauda > capacidade) {
+            cauda = cabeca > capacidade ? cabeca - capacidade : 0;
+        }
+        uint64_t pos = cauda;
+        while (pos < cabeca && registroValido(pos)) {
+            pos++;
+        }
+        cabecalho->cauda = cauda;
+        cabecalho->cabeca = pos;
+        return 0;
+    }
+
+    /**
+     * @brief Anexa uma amostra; com o anel cheio, descarta a mais antiga.
+     */
+    void anexar(const AmostraLDR& a) {
+        uint64_t pos = cabecalho->cabeca;
+        if (pos - cabecalho->cauda > mascara) {
+            cabecalho->cauda++;
+            cabecalho->descartadas++;
+        }
+        RegistroSpool& r = registros[pos & mascara];
+        r.posicao = pos;
+        r.t_ns = a.t_ns;
+        r.id_sensor = a.id_sensor;
+        r.seq = a.seq;
+        r.valor = a.valor;
+        r.crc = crcRegistro(r);
+        // O registro é escrito antes de a cabeça avançar (vale para uma queda do processo).
+        __atomic_store_n(&cabecalho->cabeca, pos + 1, __ATOMIC_RELEASE);
+        if (++naoSincronizados >= intervaloSincronizacao ||
+            (periodoSincronizacaoNs > 0 && agoraNs() - ultimaSincronizacaoNs >= periodoSincronizacaoNs)) {
+            sincronizar();
+        }
+    }
+
+    /**
+     * @brief Copia as amostras pendentes mais antigas que cabem em um datagrama binário.
+     *
+     * @details O lote para na primeira amostra de outro sensor, com sequência não contígua, com
+     * deslocamento em relação à primeira que não cabe nos 32 bits de µs do protocolo ou com
+     * intervalo que difere em mais de 25% do primeiro intervalo do lote (um lote tem uma única
+     * taxa de amostragem).
+     * @return Número de amostras copiadas para @p saida (0 se não há pendentes).
+     */
+    size_t espiar(AmostraLDR* saida, size_t maximo) const {
+        uint64_t pos = cabecalho->cauda;
+        size_t n = 0;
+        for (; n < maximo && pos < cabecalho->cabeca; n++, pos++) {
+            const RegistroSpool& r = registros[pos & mascara];
+            if (n > 0 && (r.id_sensor != saida[0].id_sensor || r.seq != saida[0].seq + n ||
+                          r.t_ns < saida[n - 1].t_ns || (r.t_ns - saida[0].t_ns) / 1000ull > UINT32_MAX)) {
+                break;
+            }
+            if (n > 1) {
+                uint64_t primeiro = saida[1].t_ns - saida[0].t_ns;
+                uint64_t intervalo = r.t_ns - saida[n - 1].t_ns;
+                if (4 * intervalo < 3 * primeiro || 4 * intervalo > 5 * primeiro) {
+                    break;
+                }
+            }
+            saida[n] = AmostraLDR{r.t_ns, r.id_sensor, r.seq, r.valor};
+        }
+        return n;
+    }
+
+    /**
+     * @brief Obtém a amostra anexada por último (enviada ou não), para continuar a sequência.
+     * @return false se o spool está vazio ou o registro não é válido.
+     */
+    bool ultimaAmostra(AmostraLDR& a) const {
+        uint64_t pos = cabecalho->cabeca;
+        if (pos == 0 || !registroValido(pos - 1)) {
+            return false;
+        }
+        const RegistroSpool& r = registros[(pos - 1) & mascara];
+        a = AmostraLDR{r.t_ns, r.id_sensor, r.seq, r.valor};
+        return true;
+    }
+
+    /** @brief Remove as @p n amostras pendentes mais antigas (já enviadas). */
+    void confirmar(size_t n) {
+        cabecalho->cauda += n;
+    }
+
+    /** @brief Força a gravação do spool em disco. */
+    void sincronizar() {
+        msync(cabecalho, tamanho, MS_SYNC);
+        naoSincronizados = 0;
+        ultimaSincronizacaoNs = agoraNs();
+    }
+
+    /** @brief Amostras pendentes de envio. */
+    uint64_t pendentes() const { return cabecalho->cabeca - cabecalho->cauda; }
+
+    /** @brief Amostras descartadas por falta de espaço desde a criação do spool. */
+    uint64_t descartadas() const { return cabecalho->descartadas; }
+
+    /** @brief Capacidade do spool. */
+    uint64_t capacidade() const { return mascara + 1; }
+};
+
+/**
+ * @brief Buffers do envio segmentado (GSO) de drenarSpool(), reservados uma vez pelo chamador.
+ */
+struct BufferGso {
+    AmostraLDR amostras[GSO_MAX_SEGMENTOS * LDR_MAX_AMOSTRAS_DATAGRAMA]; /**< Amostras lidas do spool. */
+    char dados[GSO_MAX_CARGA];                                           /**< Datagramas lado a lado. */
+    bool indisponivel = false;                                           /**< O kernel recusou UDP_SEGMENT. */
+    uint64_t envios = 0;                                                 /**< Envios segmentados feitos. */
+};
+
+/**
+ * @brief Modos de envio aplicados por drenarSpool().
+ *
+ * @details No modo confiável, cada datagrama leva LDR_FLAG_CONFIAVEL e a sua cópia vai para a
+ * janela; o envio para quando ela não comporta o próximo. No modo FEC, cada datagrama leva
+ * LDR_FLAG_FEC e os reparos são emitidos ao completar cada grupo. No formato texto, cada amostra
+ * vai sozinha, só com o valor (sem instante nem sequência), e a janela e o FEC são ignorados.
+ */
+struct ConfiguracaoEnvio {
+    JanelaRetransmissao* janela = nullptr; /**< Janela do modo confiável (nula: desligado). */
+    uint64_t agoraNs = 0;                  /**< Instante do envio (CLOCK_MONOTONIC), registrado na janela. */
+    CodificadorFec* fec = nullptr;         /**< Codificador do modo FEC (nulo: desligado). */
+    uint16_t taxaDhz = 0;                  /**< Taxa atual (décimos de Hz) dos datagramas de uma só amostra. */
+    bool texto = false;                    /**< Formato texto dos coletores antigos (uma amostra por datagrama). */
+    bool conectado = false;                /**< Socket conectado ao coletor: send() sem endereço. */
+    BufferGso* gso = nullptr;              /**< Envio segmentado do atraso (nulo: um datagrama por envio). */
+    EnvioCopiaZero* copiaZero = nullptr;   /**< Envio segmentado sem cópia (MSG_ZEROCOPY), se houver. */
+};
+
+/**
+ * @brief Envia um datagrama ao coletor.
+ *
+ * @details Com o socket conectado, usa send() sem endereço: o kernel reaproveita a rota guardada
+ * no connect() em vez de procurá-la a cada datagrama, e um ICMP de porta inalcançável volta como
+ * ECONNREFUSED no envio seguinte. Sem conexão, usa sendto() para @p destino.
+ */
+inline ssize_t enviarDatagrama(int sock, const char* dados, size_t tamanho, const sockaddr_in& destino,
+                               bool conectado) {
+    if (conectado) {
+        return send(sock, dados, tamanho, 0);
+    }
+    return sendto(sock, dados, tamanho, 0, reinterpret_cast<const sockaddr*>(&destino), sizeof(destino));
+}
+
+/**
+ * @brief Taxa de amostragem de um lote, em décimos de Hz, medida pelos instantes das amostras.
+ * @return 0 se o lote tem uma só amostra.
+ */
+inline uint16_t taxaLoteDhz(const AmostraLDR* lote, size_t n) {
+    uint64_t duracao = n > 1 ? lote[n - 1].t_ns - lote[0].t_ns : 0;
+    if (duracao == 0) {
+        return 0;
+    }
+    uint64_t dhz = (10000000000ull * (n - 1) + duracao / 2) / duracao;
+    return static_cast<uint16_t>(std::clamp<uint64_t>(dhz, 1, UINT16_MAX));
+}
+
+/**
+ * @brief Parte de drenarSpool() que envia o atraso em envios segmentados (GSO).
+ *
+ * @details Lê do spool até um envio cheio de amostras consecutivas e as codifica em datagramas
+ * de LDR_MAX_AMOSTRAS_DATAGRAMA amostras (só o último pode ser menor), lado a lado, entregues ao
+ * kernel em um único sendmsg(). Para quando sobra no máximo um datagrama, que segue pelo envio
+ * comum. Se o kernel recusa UDP_SEGMENT, marca o buffer como indisponível e não tenta de novo.
+ * Com config.copiaZero, cada envio é codificado em um buffer do pool sem cópia, que fica com o
+ * kernel até a conclusão; com todos em voo, o envio usa o buffer de config.gso, com cópia.
+ *
+ * @return Amostras enviadas, ou -errno se o primeiro envio falhou.
+ */
+inline int64_t drenarSegmentado(SpoolAmostras& spool, int sock, const sockaddr_in& destino, uint64_t maximo,
+                                const ConfiguracaoEnvio& config) {
+    BufferGso& gso = *config.gso;
+    const size_t cheio = sizeof(CabecalhoLDR) + LDR_MAX_AMOSTRAS_DATAGRAMA * sizeof(AmostraWireLDR);
+    const size_t porEnvio = std::min<size_t>(GSO_MAX_SEGMENTOS, GSO_MAX_CARGA / cheio) * LDR_MAX_AMOSTRAS_DATAGRAMA;
+    uint8_t flags = config.fec != nullptr ? LDR_FLAG_FEC : 0;
+    uint64_t enviadas = 0;
+    while (enviadas < maximo && !gso.indisponivel) {
+        size_t n = spool.espiar(gso.amostras, static_cast<size_t>(std::min<uint64_t>(maximo - enviadas, porEnvio)));
+        if (n <= LDR_MAX_AMOSTRAS_DATAGRAMA) {
+            break;
+        }
+        uint32_t indice = config.copiaZero != nullptr ? config.copiaZero->obter() : PoolBuffers::NENHUM;
+        char* dados = indice != PoolBuffers::NENHUM ? config.copiaZero->dados(indice) : gso.dados;
+        size_t bytes = 0;
+        for (size_t i = 0; i < n; i += LDR_MAX_AMOSTRAS_DATAGRAMA) {
+            size_t k = std::min<size_t>(n - i, LDR_MAX_AMOSTRAS_DATAGRAMA);
+            uint16_t taxa = k > 1 ? taxaLoteDhz(gso.amostras + i, k) : config.taxaDhz;
+            bytes += codificarDatagrama(dados + bytes, GSO_MAX_CARGA - bytes, gso.amostras + i, k, flags, taxa);
+        }
+        const sockaddr_in* para = config.conectado ? nullptr : &destino;
+        ssize_t r = indice != PoolBuffers::NENHUM
+                        ? config.copiaZero->enviar(indice, bytes, static_cast<uint16_t>(cheio), para)
+                        : enviarSegmentado(sock, dados, bytes, static_cast<uint16_t>(cheio), para);
+        if (r == -EIO || r == -EINVAL || r == -ENOPROTOOPT) {
+            gso.indisponivel = true;
+            break;
+        }
+        if (r < 0) {
+            return enviadas == 0 ? r : static_cast<int64_t>(enviadas);
+        }
+        gso.envios++;
+        if (config.fec != nullptr) {
+            for (size_t pos = 0; pos < bytes; pos += cheio) {
+                config.fec->adicionar(dados + pos, std::min(cheio, bytes - pos), [&](const char* reparo, size_t t) {
+                    enviarDatagrama(sock, reparo, t, destino, config.conectado);
+                });
+            }
+        }
+        spool.confirmar(n);
+        enviadas += n;
+    }
+    return static_cast<int64_t>(enviadas);
+}
+
+/**
+ * @brief Envia as amostras pendentes do spool, em datagramas binários, até @p maximo amostras.
+ *
+ * @details Cada datagrama só é removido do spool depois que o socket o aceita; na primeira falha
+ * o envio para e as amostras restantes permanecem pendentes. O lote e o datagrama são codificados
+ * em buffers na pilha: o envio não aloca memória. Com config.gso (e sem o modo confiável nem o
+ * texto), o atraso sai antes em envios segmentados (drenarSegmentado()).
+ *
+ * @return Amostras enviadas, ou -errno se a primeira tentativa falhou.
+ */
+inline int64_t drenarSpool(SpoolAmostras& spool, int sock, const sockaddr_in& destino, uint64_t maximo,
+                           const ConfiguracaoEnvio& config = ConfiguracaoEnvio{}) {
+    JanelaRetransmissao* janela = config.texto ? nullptr : config.janela;
+    CodificadorFec* fec = config.texto ? nullptr : config.fec;
+    size_t porDatagrama = config.texto ? 1 : LDR_MAX_AMOSTRAS_DATAGRAMA;
+    AmostraLDR lote[LDR_MAX_AMOSTRAS_DATAGRAMA];
+    char datagrama[sizeof(CabecalhoLDR) + LDR_MAX_AMOSTRAS_DATAGRAMA * sizeof(AmostraWireLDR)];
+    uint64_t enviadas = 0;
+    if (config.gso != nullptr && janela == nullptr && !config.texto) {
+        int64_t r = drenarSegmentado(spool, sock, destino, maximo, config);
+        if (r < 0) {
+            return r;
+        }
+        enviadas = static_cast<uint64_t>(r);
+    }
+    while (enviadas < maximo) {
+        size_t n = spool.espiar(lote, static_cast<size_t>(std::min<uint64_t>(maximo - enviadas, porDatagrama)));
+        if (n == 0) {
+            break;
+        }
+        if (janela != nullptr && !janela->podeEnviar(lote[0].id_sensor, lote[0].seq + static_cast<uint32_t>(n) - 1)) {
+            break; // janela cheia: as amostras esperam no spool pelas confirmações
+        }
+        uint8_t flags = (janela != nullptr ? LDR_FLAG_CONFIAVEL : 0) | (fec != nullptr ? LDR_FLAG_FEC : 0);
+        uint16_t taxa = n > 1 ? taxaLoteDhz(lote, n) : config.taxaDhz;
+        size_t bytes = config.texto ? codificarTexto(datagrama, sizeof(datagrama), lote[0].valor)
+                                    : codificarDatagrama(datagrama, sizeof(datagrama), lote, n, flags, taxa);
+        if (enviarDatagrama(sock, datagrama, bytes, destino, config.conectado) < 0) {
+            if (enviadas == 0) {
+                return -errno;
+            }
+            break;
+        }
+        if (fec != nullptr) {
+            // Um reparo perdido localmente só reduz a proteção do grupo; o envio continua.
+            fec->adicionar(datagrama, bytes, [&](const char* reparo, size_t tamanho) {
+                enviarDatagrama(sock, reparo, tamanho, destino, config.conectado);
+            });
+        }
+        if (janela != nullptr) {
+            janela->guardar(datagrama, bytes, lote[0].id_sensor, lote[0].seq, static_cast<uint32_t>(n), config.agoraNs);
+        }
+        spool.confirmar(n);
+        enviadas += n;
+    }
+    return static_cast<int64_t>(enviadas);
+}
+
+#endif // SPOOL_AMOSTRAS_HPP
@@ -0,0 +1,143 @@
+/**
+ * @file tempo_real.hpp
+ * @brief Modo de tempo real do cliente: memória travada, núcleo fixo, SCHED_FIFO e medição de jitter.
+ *
+ * @details A kHz, uma falta de página ou uma preempção pelo escalonador aparece como um buraco no
+ * fluxo de amostras. O modo de tempo real trava toda a memória do processo (inclusive a mapeada
+ * depois, como o spool e as pilhas dos threads), pré-carrega a pilha do thread de amostragem,
+ * impede o malloc de devolver memória ao kernel, fixa o thread em um núcleo (de preferência
+ * isolado com `isolcpus`) e o coloca em SCHED_FIFO. O envio pela rede fica em outro thread, sem
+ * prioridade de tempo real.
+ *
+ * O MedidorJitter acumula, sem alocar, o atraso de cada despertar em relação ao instante
+ * agendado, em um histograma de 1 µs por faixa.
+ */
+
+#ifndef TEMPO_REAL_HPP
+#define TEMPO_REAL_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+/** @def TEMPO_REAL_PILHA
+ * @brief Bytes de pilha pré-carregados no thread de amostragem.
+ */
+#define TEMPO_REAL_PILHA (256 * 1024)
+
+/** @def MEDIDOR_JITTER_FAIXAS
+ * @brief Faixas de 1 µs do histograma de atrasos (a última acumula os maiores).
+ */
+#define MEDIDOR_JITTER_FAIXAS 2048
+
+/**
+ * @brief Trava a memória do processo e pré-carrega a pilha do thread chamador.
+ *
+ * @details Com MCL_FUTURE, o que for mapeado depois também fica residente. O malloc passa a não
+ * devolver memória ao kernel nem a atender pedidos grandes com mmap, para que liberar e alocar
+ * de novo não volte a causar faltas de página.
+ *
+ * @return 0 ou -errno (EPERM/ENOMEM: sem CAP_IPC_LOCK ou acima de RLIMIT_MEMLOCK).
+ */
+__attribute__((noinline)) inline int travarMemoria() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+        return -errno;
+    }
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    // Toca cada página da pilha que o laço pode usar: com a memória travada, ela fica residente.
+    volatile char pilha[TEMPO_REAL_PILHA];
+    for (size_t i = 0; i < sizeof(pilha); i += 4096) {
+        pilha[i] = 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief Fixa o thread chamador no núcleo @p nucleo.
+ * @return 0 ou -errno.
+ */
+inline int fixarNucleo(int nucleo) {
+    cpu_set_t conjunto;
+    CPU_ZERO(&conjunto);
+    CPU_SET(nucleo, &conjunto);
+    return -pthread_setaffinity_np(pthread_self(), sizeof(conjunto), &conjunto);
+}
+
+/**
+ * @brief Coloca o thread chamador em SCHED_FIFO com a prioridade @p prioridade (1 a 99).
+ * @return 0 ou -errno (EPERM: sem CAP_SYS_NICE ou RLIMIT_RTPRIO).
+ */
+inline int escalonarFifo(int prioridade) {
+    sched_param parametro{};
+    parametro.sched_priority = std::clamp(prioridade, sched_get_priority_min(SCHED_FIFO),
+                                          sched_get_priority_max(SCHED_FIFO));
+    return -pthread_setschedparam(pthread_self(), SCHED_FIFO, &parametro);
+}
+
+/**
+ * @class MedidorJitter
+ * @brief Histograma dos atrasos de despertar (um único thread o usa).
+ */
+class MedidorJitter {
+private:
+    /**< Contagem por faixa de 1 µs. */
+    uint32_t faixas[MEDIDOR_JITTER_FAIXAS] = {};
+
+    /**< Despertares medidos, soma e maior atraso (ns). */
+    uint64_t total = 0;
+    uint64_t soma = 0;
+    uint64_t maximo = 0;
+
+public:
+    /**
+     * @brief Registra um despertar.
+     * @param agendadoNs Instante agendado (CLOCK_MONOTONIC).
+     * @param acordouNs Instante em que o thread voltou a executar.
+     */
+    void registrar(uint64_t agendadoNs, uint64_t acordouNs) {
+        uint64_t atraso = acordouNs > agendadoNs ? acordouNs - agendadoNs : 0;
+        faixas[std::min<uint64_t>(atraso / 1000, MEDIDOR_JITTER_FAIXAS - 1)]++;
+        total++;
+        soma += atraso;
+        maximo = std::max(maximo, atraso);
+    }
+
+    /**
+     * @brief Atraso (µs) abaixo do qual ficam @p fracao dos despertares (ex.: 0.99).
+     * @details Resolução de 1 µs; acima de MEDIDOR_JITTER_FAIXAS µs, informa o máximo.
+     */
+    double percentilUs(double fracao) const {
+        uint64_t alvo = static_cast<uint64_t>(fracao * static_cast<double>(total));
+        uint64_t acumulado = 0;
+        for (size_t i = 0; i + 1 < MEDIDOR_JITTER_FAIXAS; i++) {
+            acumulado += faixas[i];
+            if (acumulado > alvo) {
+                return static_cast<double>(i + 1);
+            }
+        }
+        return maximoUs();
+    }
+
+    /** @brief Atraso médio (µs). */
+    double medioUs() const { return total ? static_cast<double>(soma) / 1e3 / static_cast<double>(total) : 0.0; }
+
+    /** @brief Maior atraso (µs). */
+    double maximoUs() const { return static_cast<double>(maximo) / 1e3; }
+
+    /** @brief Despertares medidos. */
+    uint64_t despertares() const { return total; }
+
+    /** @brief Zera o histograma (início de uma nova janela de relatório). */
+    void zerar() {
+        memset(faixas, 0, sizeof(faixas));
+        total = soma = maximo = 0;
+    }
+};
+
+#endif // TEMPO_REAL_HPP